@@ -0,0 +1,168 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <atomic>
+#include <algorithm> // std::max
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Process-wide allocation counters for the LCS solvers.
+ *
+ * `heapAllocations()` counts the blocks the solvers get from new[], and
+ * `arenaAllocations()` counts the blocks handed out by arenas instead.
+ * `arenaChunks()` counts the chunks the arenas themselves had to allocate.
+ */
+struct AllocationCounters
+{
+  static std::atomic<long long> &heapAllocations()
+  {
+    static std::atomic<long long> counter(0);
+    return counter;
+  }
+
+  static std::atomic<long long> &arenaAllocations()
+  {
+    static std::atomic<long long> counter(0);
+    return counter;
+  }
+
+  static std::atomic<long long> &arenaChunks()
+  {
+    static std::atomic<long long> counter(0);
+    return counter;
+  }
+
+  static void print()
+  {
+    printf("Heap allocations: %lld\n", heapAllocations().load());
+    printf("Arena allocations: %lld\n", arenaAllocations().load());
+    printf("Arena chunks allocated: %lld\n", arenaChunks().load());
+  }
+};
+
+/**
+ * @brief Bump allocator for the scratch memory of one solve at a time.
+ *
+ * Each thread that solves many pairs keeps its own arena: the matrix rows,
+ * buffers and copies of the sequences of a pair are carved out of the arena,
+ * and reset() releases all of them at once before the next pair. Memory is
+ * never returned to the system until the arena is destroyed, so once the
+ * arena has grown to fit the largest pair, solving a pair makes no heap
+ * allocations at all. An arena is not thread-safe.
+ */
+class Arena
+{
+private:
+  static const size_t ALIGNMENT = 64; // Cache line, so rows do not share lines.
+
+  struct Chunk
+  {
+    std::unique_ptr<char[]> memory;
+    size_t size;
+  };
+
+  std::vector<Chunk> chunks;
+  size_t current_chunk = 0; // Chunk that allocations are taken from.
+  size_t offset = 0;        // Bytes used in the current chunk.
+  size_t bytes_in_use = 0;
+  size_t peak_bytes_in_use = 0;
+  long long n_allocations = 0;
+  long long n_resets = 0;
+
+  void addChunk(size_t size)
+  {
+    Chunk chunk;
+    // Over-allocate so the start of the chunk can be aligned.
+    chunk.memory.reset(new char[size + ALIGNMENT]);
+    chunk.size = size;
+    chunks.push_back(std::move(chunk));
+    AllocationCounters::arenaChunks()++;
+  }
+
+  char *chunkStart(size_t index)
+  {
+    size_t address = (size_t)chunks[index].memory.get();
+    return (char *)((address + ALIGNMENT - 1) & ~(ALIGNMENT - 1));
+  }
+
+public:
+  /* Creates an arena with an initial chunk of the given size in bytes. */
+  Arena(size_t initial_size = 1 << 20)
+  {
+    addChunk(initial_size > 0 ? initial_size : ALIGNMENT);
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  /* Returns uninitialized memory for n bytes, aligned to a cache line. */
+  void *allocateBytes(size_t n)
+  {
+    n = (n + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    while (offset + n > chunks[current_chunk].size)
+    {
+      // Move on to the next chunk, adding one if none is left that fits.
+      current_chunk++;
+      offset = 0;
+      if (current_chunk == chunks.size())
+      {
+        addChunk(std::max(n, 2 * chunks[current_chunk - 1].size));
+      }
+    }
+
+    void *block = chunkStart(current_chunk) + offset;
+    offset += n;
+    bytes_in_use += n;
+    peak_bytes_in_use = std::max(peak_bytes_in_use, bytes_in_use);
+    n_allocations++;
+    AllocationCounters::arenaAllocations()++;
+    return block;
+  }
+
+  /* Returns uninitialized memory for n objects of a trivial type. */
+  template <typename T>
+  T *allocate(size_t n)
+  {
+    return (T *)allocateBytes(n * sizeof(T));
+  }
+
+  /* Releases everything allocated since the last reset. */
+  void reset()
+  {
+    current_chunk = 0;
+    offset = 0;
+    bytes_in_use = 0;
+    n_resets++;
+  }
+
+  /* Total bytes reserved from the system. */
+  size_t capacity() const
+  {
+    size_t total = 0;
+    for (const Chunk &chunk : chunks)
+    {
+      total += chunk.size;
+    }
+    return total;
+  }
+
+  size_t peakBytesInUse() const
+  {
+    return peak_bytes_in_use;
+  }
+
+  long long allocationCount() const
+  {
+    return n_allocations;
+  }
+
+  long long resetCount() const
+  {
+    return n_resets;
+  }
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef _BIT_PARALLEL_H_
+#define _BIT_PARALLEL_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "cancellation.h"
+#include "sequence.h"
+
+/**
+ * @brief Computes rows of the LCS matrix 64 cells at a time.
+ *
+ * This is Hyyrö's bit-vector formulation of the LCS recurrence. Row i of the
+ * matrix is stored as the bit vector V of its column differences, where bit j
+ * is 0 if the row increases at column j + 1. Moving to the next character of
+ * sequence_a updates the whole row with a few word operations:
+ *
+ *   U = V & Match[a_i]
+ *   V = (V + U) | (V - U)
+ *
+ * where Match[c] has bit j set if sequence_b[j] == c, and the addition
+ * carries across the words of the vector. The last entry of the row, the LCS
+ * of the rows so far against sequence_b, is the number of 0 bits. It takes
+ * O(length_b / 64) time per row and O(length_b) memory, so it is far cheaper
+ * than filling the matrix, but it gives only the values, not the alignment.
+ */
+class BitParallelLCS
+{
+private:
+  int length_b;
+  int n_words;
+  int symbols[256]; // Row of each character in matches, or -1 if not in b.
+  std::vector<uint64_t> matches;
+  std::vector<uint64_t> row;
+
+public:
+  BitParallelLCS(const Sequence &sequence_b)
+      : length_b(sequence_b.length()), n_words((sequence_b.length() + 63) / 64)
+  {
+    // Only characters that occur in sequence_b get a match vector.
+    for (int c = 0; c < 256; c++)
+    {
+      symbols[c] = -1;
+    }
+    int n_symbols = 0;
+    for (int j = 0; j < length_b; j++)
+    {
+      unsigned char c = sequence_b[j];
+      if (symbols[c] < 0)
+        symbols[c] = n_symbols++;
+    }
+    matches.assign((size_t)n_symbols * n_words, 0);
+    for (int j = 0; j < length_b; j++)
+    {
+      unsigned char c = sequence_b[j];
+      matches[(size_t)symbols[c] * n_words + j / 64] |= (uint64_t)1 << (j % 64);
+    }
+    row.assign(n_words, ~(uint64_t)0);
+  }
+
+  // Moves to the next row, for the next character of sequence_a.
+  void advance(const char a)
+  {
+    int symbol = symbols[(unsigned char)a];
+    if (symbol < 0)
+      return; // No match anywhere in the row, so it does not change.
+
+    const uint64_t *match = &matches[(size_t)symbol * n_words];
+    uint64_t carry = 0;
+    for (int w = 0; w < n_words; w++)
+    {
+      uint64_t v = row[w];
+      uint64_t u = v & match[w];
+      uint64_t sum = v + u;
+      uint64_t carry_out = sum < v;
+      sum += carry;
+      carry_out |= sum < carry;
+      carry = carry_out;
+      row[w] = sum | (v - u);
+    }
+  }
+
+  // The last entry of the current row: the number of 0 bits, ignoring the
+  // padding past the end of sequence_b.
+  int length() const
+  {
+    int length = 0;
+    for (int w = 0; w < n_words; w++)
+    {
+      uint64_t zeros = ~row[w];
+      int n_bits = length_b - w * 64;
+      if (n_bits < 64)
+        zeros &= ((uint64_t)1 << n_bits) - 1;
+      length += __builtin_popcountll(zeros);
+    }
+    return length;
+  }
+};
+
+/* Computes the length of the LCS of two sequences with BitParallelLCS.
+Returns -1 if the token is cancelled before it finishes. */
+inline int bitParallelLCSLength(const Sequence &sequence_a,
+                                const Sequence &sequence_b,
+                                CancellationToken *cancellation_token = nullptr)
+{
+  if (sequence_a.length() == 0 || sequence_b.length() == 0)
+    return 0;
+
+  BitParallelLCS lcs(sequence_b);
+  for (int i = 0; i < sequence_a.length(); i++)
+  {
+    // Checking once per 1024 rows keeps the clock reads negligible.
+    if (i % 1024 == 0 && cancellation_token && cancellation_token->isCancelled())
+      return -1;
+    lcs.advance(sequence_a[i]);
+  }
+  return lcs.length();
+}
+
+/* Computes the last column of the LCS matrix of two sequences: column[i] is
+the LCS of the first i characters of sequence_a and all of sequence_b, for
+0 <= i <= length_a. Returns false if the token is cancelled first. */
+inline bool bitParallelLastColumn(const Sequence &sequence_a,
+                                  const Sequence &sequence_b, int *column,
+                                  CancellationToken *cancellation_token = nullptr)
+{
+  column[0] = 0;
+  BitParallelLCS lcs(sequence_b);
+  for (int i = 0; i < sequence_a.length(); i++)
+  {
+    if (i % 1024 == 0 && cancellation_token && cancellation_token->isCancelled())
+      return false;
+    lcs.advance(sequence_a[i]);
+    column[i + 1] = lcs.length();
+  }
+  return true;
+}
+
+#endif
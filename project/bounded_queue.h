@@ -0,0 +1,191 @@
+#ifndef _BOUNDED_QUEUE_H_
+#define _BOUNDED_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer queue.
+ *
+ * This is Dmitry Vyukov's array-based queue: every slot carries a sequence
+ * number that tells producers and consumers whether it is free or full, so
+ * a push or pop is a single compare-and-swap on the shared position in the
+ * common case. The capacity is rounded up to a power of two.
+ *
+ * push() and pop() block on a condition variable while the queue is full or
+ * empty, instead of spinning, so idle stages leave the cores to the busy
+ * ones. The lock is only taken when a thread is waiting or about to wait.
+ */
+template <typename T>
+class BoundedQueue
+{
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::vector<Slot> slots;
+  const size_t mask;
+  // Keep the producer and consumer positions on separate cache lines.
+  alignas(64) std::atomic<size_t> enqueue_position;
+  alignas(64) std::atomic<size_t> dequeue_position;
+
+  // Threads blocked in push() or pop(), and whether close() was called.
+  std::mutex wait_mutex;
+  std::condition_variable not_full;
+  std::condition_variable not_empty;
+  std::atomic<int> n_waiting;
+  std::atomic<bool> closed;
+
+  /* Wakes a thread blocked on the condition, if any. The fence orders the
+  push or pop before the check of n_waiting, against the increment and the
+  retry of a thread that is about to wait. */
+  void wake(std::condition_variable &condition)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (n_waiting.load(std::memory_order_relaxed) > 0)
+    {
+      std::lock_guard<std::mutex> lock(wait_mutex);
+      condition.notify_one();
+    }
+  }
+
+  static size_t roundUpToPowerOfTwo(size_t n)
+  {
+    size_t power = 2;
+    while (power < n)
+    {
+      power *= 2;
+    }
+    return power;
+  }
+
+public:
+  BoundedQueue(size_t capacity)
+      : slots(roundUpToPowerOfTwo(capacity)),
+        mask(slots.size() - 1),
+        enqueue_position(0),
+        dequeue_position(0),
+        n_waiting(0),
+        closed(false)
+  {
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  /* Adds a value. Returns false if the queue is full. */
+  bool tryPush(T &value)
+  {
+    size_t position = enqueue_position.load(std::memory_order_relaxed);
+    while (true)
+    {
+      Slot &slot = slots[position & mask];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)position;
+      if (difference == 0)
+      {
+        if (enqueue_position.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed))
+        {
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0)
+      {
+        return false; // Full.
+      }
+      else
+      {
+        position = enqueue_position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /* Removes a value. Returns false if the queue is empty. */
+  bool tryPop(T &value)
+  {
+    size_t position = dequeue_position.load(std::memory_order_relaxed);
+    while (true)
+    {
+      Slot &slot = slots[position & mask];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)(position + 1);
+      if (difference == 0)
+      {
+        if (dequeue_position.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed))
+        {
+          value = std::move(slot.value);
+          slot.sequence.store(position + mask + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0)
+      {
+        return false; // Empty.
+      }
+      else
+      {
+        position = dequeue_position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /* Adds a value, waiting while the queue is full. */
+  void push(T &value)
+  {
+    if (!tryPush(value))
+    {
+      std::unique_lock<std::mutex> lock(wait_mutex);
+      n_waiting++;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      not_full.wait(lock, [&]() { return tryPush(value); });
+      n_waiting--;
+    }
+    wake(not_empty);
+  }
+
+  /* Removes a value, waiting while the queue is empty. Returns false once
+  the queue is closed and empty. */
+  bool pop(T &value)
+  {
+    bool popped = tryPop(value);
+    if (!popped)
+    {
+      std::unique_lock<std::mutex> lock(wait_mutex);
+      n_waiting++;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      // Values pushed before close() are still taken.
+      not_empty.wait(lock, [&]()
+                     { return (popped = tryPop(value)) || closed.load(); });
+      n_waiting--;
+      if (!popped)
+        return false;
+    }
+    wake(not_full);
+    return true;
+  }
+
+  /* Tells the consumers that nothing more will be pushed. */
+  void close()
+  {
+    closed = true;
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    not_empty.notify_all();
+  }
+};
+
+#endif
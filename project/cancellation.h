@@ -0,0 +1,75 @@
+#ifndef _CANCELLATION_H_
+#define _CANCELLATION_H_
+
+#include <time.h>
+
+#include <atomic>
+
+/**
+ * @brief Stops a running solve, on request or once a deadline has passed.
+ *
+ * Solvers poll isCancelled() once per row or block of rows, so a cancelled
+ * solve stops within one block and reports how far it got, instead of
+ * running to completion. A token may be shared by several solves and reused
+ * with reset(); it must outlive the solves that use it.
+ *
+ * The deadline is read from the coarse monotonic clock, which costs a few
+ * nanoseconds instead of a full clock read, so polling it once per row stays
+ * cheap even for short rows. Its resolution of a few milliseconds is far
+ * finer than any useful time limit.
+ */
+class CancellationToken
+{
+private:
+  std::atomic<bool> cancelled;
+  std::atomic<long long> deadline; // In nanoseconds, or 0 for none.
+
+  static long long now()
+  {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+  }
+
+public:
+  CancellationToken() : cancelled(false), deadline(0) {}
+
+  CancellationToken(const CancellationToken &) = delete;
+  CancellationToken &operator=(const CancellationToken &) = delete;
+
+  /* Cancels every solve using the token. Safe to call from any thread. */
+  void cancel()
+  {
+    cancelled.store(true, std::memory_order_relaxed);
+  }
+
+  /* Cancels the solves that are still running `seconds` from now. A limit
+  of 0 or less removes the deadline. */
+  void setTimeLimit(const double seconds)
+  {
+    deadline.store(seconds > 0.0 ? now() + (long long)(seconds * 1e9) : 0,
+                   std::memory_order_relaxed);
+  }
+
+  /* Clears the cancellation and the deadline, to reuse the token. */
+  void reset()
+  {
+    deadline.store(0, std::memory_order_relaxed);
+    cancelled.store(false, std::memory_order_relaxed);
+  }
+
+  bool isCancelled()
+  {
+    if (cancelled.load(std::memory_order_relaxed))
+      return true;
+    long long end = deadline.load(std::memory_order_relaxed);
+    if (end != 0 && now() >= end)
+    {
+      cancel();
+      return true;
+    }
+    return false;
+  }
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "lcs_cache.h" // hashPair
+
+#define LCS_CHECKPOINT_MAGIC 0x4b53434c // "LCSK" in little-endian memory.
+#define LCS_CHECKPOINT_VERSION 1
+
+/**
+ * @brief The completed part of one strip of columns of the matrix.
+ *
+ * Every row of the strip up to and including `row` has been computed.
+ * `values` holds that row for columns start_col to end_col. When the strip to
+ * the right is further behind, `edge_values` holds the last column of this
+ * strip from `edge_first_row` down to `row`, which the strip to the right
+ * still has to read.
+ */
+struct CheckpointStrip
+{
+  int start_col = 0;
+  int end_col = -1; // Inclusive; end_col < start_col for an empty strip.
+  int row = 0;
+  std::vector<int> values;
+  int edge_first_row = 0;
+  std::vector<int> edge_values;
+};
+
+/**
+ * @brief The frontier of a partially filled matrix, to resume a solve from.
+ *
+ * Only the last completed row of each strip (and the column segments its
+ * neighbor needs) is kept, so a checkpoint is O(length_b + length_a) in size
+ * however far the solve has got. The rows above the frontier are not saved.
+ * A resumed solve leaves them unfilled: the traceback aligns that part of the
+ * sequences in linear space (traceUnfilledRows in lcs.h), and the rows are
+ * only recomputed (fillUnfilledRows) when something needs the whole matrix,
+ * such as a matrix dump, or by recurrences without a linear-space traceback:
+ * the scored and counted solves.
+ */
+class Checkpoint
+{
+private:
+  template <typename T>
+  static void writeValue(std::ofstream &out_file, const T &value)
+  {
+    out_file.write((const char *)&value, sizeof(value));
+  }
+
+  template <typename T>
+  static bool readValue(std::ifstream &in_file, T &value)
+  {
+    return (bool)in_file.read((char *)&value, sizeof(value));
+  }
+
+  static void writeInts(std::ofstream &out_file, const std::vector<int> &values)
+  {
+    uint32_t n = values.size();
+    writeValue(out_file, n);
+    out_file.write((const char *)values.data(), n * sizeof(int));
+  }
+
+  /* Refuses more than max_n values, so that a damaged count cannot make it
+  allocate more than the matrix could ever need. */
+  static bool readInts(std::ifstream &in_file, std::vector<int> &values,
+                       const uint32_t max_n)
+  {
+    uint32_t n;
+    if (!readValue(in_file, n) || n > max_n)
+      return false;
+    values.resize(n);
+    return n == 0 || in_file.read((char *)values.data(), n * sizeof(int));
+  }
+
+public:
+  uint32_t length_a = 0;
+  uint32_t length_b = 0;
+  PairHash input_hash; // Hash of both sequences, to refuse other inputs.
+  std::vector<CheckpointStrip> strips;
+
+  Checkpoint() {}
+
+  Checkpoint(const std::string &sequence_a, const std::string &sequence_b)
+      : length_a(sequence_a.length()), length_b(sequence_b.length()),
+        input_hash(hashPair(sequence_a, sequence_b, 0))
+  {
+  }
+
+  /* True if this checkpoint was taken for the given input. */
+  bool matches(const Checkpoint &other) const
+  {
+    return length_a == other.length_a && length_b == other.length_b &&
+           input_hash == other.input_hash;
+  }
+
+  /* Saves to a temporary file first and renames it over the old checkpoint,
+  so a crash while saving leaves the previous checkpoint intact. */
+  bool save(const std::string &path) const
+  {
+    std::string temporary_path = path + ".tmp";
+    {
+      std::ofstream out_file(temporary_path, std::ios::binary);
+      if (!out_file.is_open())
+        return false;
+
+      uint32_t magic = LCS_CHECKPOINT_MAGIC, version = LCS_CHECKPOINT_VERSION;
+      writeValue(out_file, magic);
+      writeValue(out_file, version);
+      writeValue(out_file, length_a);
+      writeValue(out_file, length_b);
+      writeValue(out_file, input_hash);
+      uint32_t n_strips = strips.size();
+      writeValue(out_file, n_strips);
+      for (const CheckpointStrip &strip : strips)
+      {
+        writeValue(out_file, strip.start_col);
+        writeValue(out_file, strip.end_col);
+        writeValue(out_file, strip.row);
+        writeInts(out_file, strip.values);
+        writeValue(out_file, strip.edge_first_row);
+        writeInts(out_file, strip.edge_values);
+      }
+      if (!out_file.good())
+        return false;
+    }
+    return rename(temporary_path.c_str(), path.c_str()) == 0;
+  }
+
+  /* Returns false if the file is missing, is not a complete checkpoint, or
+  was taken for another input than `input` (see matches()). The sizes in the
+  file are checked against the input before anything is allocated. */
+  bool load(const std::string &path, const Checkpoint &input)
+  {
+    std::ifstream in_file(path, std::ios::binary);
+    if (!in_file.is_open())
+      return false;
+
+    uint32_t magic, version, n_strips;
+    if (!readValue(in_file, magic) || magic != LCS_CHECKPOINT_MAGIC ||
+        !readValue(in_file, version) || version != LCS_CHECKPOINT_VERSION ||
+        !readValue(in_file, length_a) || !readValue(in_file, length_b) ||
+        !readValue(in_file, input_hash) || !readValue(in_file, n_strips))
+      return false;
+
+    // Every strip has at least one column, and holds at most a row and a
+    // column of the matrix.
+    if (!matches(input) || n_strips < 1 || n_strips > std::max(length_b, 1u))
+      return false;
+    strips.assign(n_strips, CheckpointStrip());
+    for (CheckpointStrip &strip : strips)
+    {
+      if (!readValue(in_file, strip.start_col) ||
+          !readValue(in_file, strip.end_col) ||
+          !readValue(in_file, strip.row) ||
+          strip.row < 0 || (uint32_t)strip.row > length_a ||
+          !readInts(in_file, strip.values, length_b + 1) ||
+          !readValue(in_file, strip.edge_first_row) ||
+          !readInts(in_file, strip.edge_values, length_a + 1))
+        return false;
+    }
+    return true;
+  }
+};
+
+#endif
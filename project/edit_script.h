@@ -0,0 +1,92 @@
+#ifndef _EDIT_SCRIPT_H_
+#define _EDIT_SCRIPT_H_
+
+#include <vector>
+
+#include "scoring.h"
+
+/**
+ * An alignment as an edit script that turns sequence A into sequence B,
+ * run-length encoded as in an extended CIGAR string:
+ *
+ *   =  keep characters of A that match B
+ *   X  replace characters of A with those of B
+ *   D  delete characters of A
+ *   I  insert characters of B
+ *
+ * so "3=1X2D4=1I" keeps 3 characters, replaces 1, deletes 2, keeps 4 and
+ * inserts 1. An edit starts in A after the characters of the =, X and D runs
+ * before it, and in B after those of the =, X and I runs. The script always
+ * covers the whole of both sequences: the parts outside a local alignment
+ * are deleted and inserted.
+ *
+ * The tracebacks build the script as they walk the path, from its end
+ * towards its start, the same way as the match runs.
+ */
+struct EditRun
+{
+  int length;
+  char op;
+};
+
+/* The edit a move of the traceback makes, or 0 for TRACEBACK_STOP. */
+inline char editOp(const TracebackMove move)
+{
+  switch (move)
+  {
+  case TRACEBACK_MATCH:
+    return '=';
+  case TRACEBACK_DIAGONAL:
+    return 'X';
+  case TRACEBACK_UP:
+    return 'D';
+  case TRACEBACK_LEFT:
+    return 'I';
+  default:
+    return 0;
+  }
+}
+
+/* Adds length edits to a script that is being built from its end towards its
+start, extending the last run if it has the same edit. */
+inline void prependEdit(std::vector<EditRun> &reversed_runs, const char op,
+                        const int length = 1)
+{
+  if (length <= 0)
+    return;
+  if (!reversed_runs.empty() && reversed_runs.back().op == op)
+  {
+    reversed_runs.back().length += length;
+    return;
+  }
+  reversed_runs.push_back(EditRun{length, op});
+}
+
+/* Adds a run to the end of a script that is being built from its start,
+merging it with the last run if they have the same edit. */
+inline void appendEditRun(std::vector<EditRun> &runs, const EditRun &run)
+{
+  if (run.length <= 0)
+    return;
+  if (!runs.empty() && runs.back().op == run.op)
+  {
+    runs.back().length += run.length;
+    return;
+  }
+  runs.push_back(run);
+}
+
+/* Swaps the insertions and the deletions, for a script traced with the roles
+of the sequences swapped. */
+inline void transposeEditScript(std::vector<EditRun> &runs)
+{
+  for (EditRun &run : runs)
+  {
+    if (run.op == 'D')
+      run.op = 'I';
+    else if (run.op == 'I')
+      run.op = 'D';
+  }
+}
+
+#endif
@@ -2,6 +2,15 @@
 #define _LCS_H_
 #include <iostream>
 
+#include "arena.h"
+#include "bit_parallel.h"
+#include "cancellation.h"
+#include "checkpoint.h"
+#include "edit_script.h"
+#include "matrix_dump.h"
+#include "progress.h"
+#include "scoring.h"
+#include "sequence.h"
 #include "timer.h"
 #include <algorithm> // std::max
 #include <fstream>
@@ -9,19 +18,115 @@
 #include <iostream>
 #include <sstream>
 #include <string.h>
+#include <vector>
+
+/** A run of consecutive matches in the alignment: sequence_a[i + k] is
+matched with sequence_b[j + k] for 0 <= k < length. Indices start at 0. */
+struct MatchRun
+{
+  int i;
+  int j;
+  int length;
+};
+
+/* Adds the match (i, j) to runs that are being built from the end of the
+alignment towards the start, extending the last run if (i, j) precedes it. */
+inline void prependMatch(std::vector<MatchRun> &reversed_runs, const int i, const int j)
+{
+  if (!reversed_runs.empty() && reversed_runs.back().i == i + 1 &&
+      reversed_runs.back().j == j + 1)
+  {
+    reversed_runs.back().i = i;
+    reversed_runs.back().j = j;
+    reversed_runs.back().length++;
+    return;
+  }
+  reversed_runs.push_back(MatchRun{i, j, 1});
+}
+
+/* Adds a run to the end of an alignment that is being built from the start,
+merging it with the last run if they are on the same diagonal and touch. */
+inline void appendMatchRun(std::vector<MatchRun> &runs, const MatchRun &run)
+{
+  if (!runs.empty() && runs.back().i + runs.back().length == run.i &&
+      runs.back().j + runs.back().length == run.j)
+  {
+    runs.back().length += run.length;
+    return;
+  }
+  runs.push_back(run);
+}
+
+/* Which sequence a solver that divides the columns of the matrix between its
+workers puts along the columns. */
+enum LCSOrientation
+{
+  LCS_ORIENTATION_AUTO,     // Whichever suits the shape and number of workers.
+  LCS_ORIENTATION_KEEP,     // sequence_b along the columns, as given.
+  LCS_ORIENTATION_TRANSPOSE // sequence_a along the columns.
+};
+
+/* Parses the value of --orientation. Returns false if it is unknown. */
+inline bool parseOrientation(const std::string &name, LCSOrientation &orientation)
+{
+  if (name == "auto")
+    orientation = LCS_ORIENTATION_AUTO;
+  else if (name == "keep")
+    orientation = LCS_ORIENTATION_KEEP;
+  else if (name == "transpose")
+    orientation = LCS_ORIENTATION_TRANSPOSE;
+  else
+    return false;
+  return true;
+}
+
+/* True if a solver that gives each of n_workers a strip of columns should
+swap the roles of the sequences. Each worker synchronizes with its neighbor
+once per row (or block of rows), so with sequence_b much shorter than
+sequence_a, the strips are narrow and the workers spend their time waiting
+rather than computing. Putting the longer sequence along the columns gives
+wider strips and fewer rows to synchronize on. A single worker never
+synchronizes, and wide strips gain little, so those keep the given
+orientation. */
+inline bool shouldTranspose(const LCSOrientation orientation, const int length_a,
+                            const int length_b, const int n_workers)
+{
+  // Strips at least this wide already do far more work per row than it
+  // costs to synchronize, and keep their rows in cache.
+  const int WIDE_STRIP = 1024;
+  if (orientation == LCS_ORIENTATION_AUTO)
+    return n_workers > 1 && length_a > length_b && length_b / n_workers < WIDE_STRIP;
+  return orientation == LCS_ORIENTATION_TRANSPOSE;
+}
 
 /** Abstract Base class for LCS implementations */
 class LongestCommonSubsequence
 {
 protected:
-  const std::string sequence_a;
-  std::string sequence_b;
+  Arena *arena;                 // Arena holding the matrix, or null for the heap.
+  std::string sequence_storage; // Copies of both sequences when there is no arena.
+  /* True if the roles of the sequences were swapped for the solve: then
+  sequence_a holds the caller's sequence B and sequence_b the caller's A.
+  Results are reported in the caller's orientation. */
+  bool transposed;
+  Sequence sequence_a;
+  Sequence sequence_b;
   const int length_a; // Length of sequence_a.
   int length_b;       // Length of sequence_b.
   int max_length;     /* The longest common subsequence cannot be longer
       const int max_length; /* The longest common subsequence cannot be longer
       than the shorter of the two input sequences. */
   std::string longest_common_subsequence;
+  /* The alignment found by the traceback, as runs of matches in order. */
+  std::vector<MatchRun> match_runs;
+  /* The same alignment as an edit script from sequence A to sequence B. */
+  std::vector<EditRun> edit_runs;
+  /* The score of the alignment found by the traceback: the length of the
+  LCS, unless a subclass scores the cells differently. */
+  int score = 0;
+  /* Column of the whole matrix that column 0 of this matrix is, for solvers
+  that hold only some of the columns. */
+  int column_offset = 0;
 
   int matrix_width;        // Width of the matrix.
   const int matrix_height; // Height of the matrix.
@@ -40,113 +145,390 @@ protected:
   /* Time taken to compute all entries of the matrix. */
   double matrix_time_taken = 0.0;
 
-  /* The logic for computing individual entries of the matrix is the same
-  regardless of which algorithm is being used. */
-  virtual void
-  computeCell(const int row, const int col)
+  /* Path that checkpoints of the fill are saved to, or "" for none. */
+  std::string checkpoint_path;
+  /* Seconds between checkpoints (rows between checkpoints for the
+  distributed version). */
+  double checkpoint_interval = 0.0;
+  /* Frontier loaded by resumeFrom(), which the next solve() starts from. */
+  Checkpoint resume_checkpoint;
+  bool resuming = false;
+
+  /* Seconds between progress reports on stderr, or 0 for none. */
+  double progress_interval = 0.0;
+
+  /* Token that can stop a solve partway through, or null. */
+  CancellationToken *cancellation_token = nullptr;
+  /* True if the last solve was cancelled before it finished. */
+  bool cancelled = false;
+  /* Cells of the matrix computed when the last solve finished or stopped. */
+  long long completed_cells = 0;
+  /* After a resumed solve that did not recompute the rows above its
+  checkpoint, the first row of each column that holds its final values;
+  empty when the whole matrix is filled. */
+  std::vector<int> first_filled_rows;
+
+  // Largest part of a linear-space traceback solved with a full matrix.
+  static const long long LINEAR_TRACEBACK_CELLS = 1 << 16;
+
+  /* Polled by the fills once per row or block of rows. */
+  bool cancellationRequested()
   {
-    /* Adjust the indices when accessing sequences, to account for extra row and
-    column of 0s. in the matrix. */
-    /* If characters are the same, set the entry to
-        1 + the entry diagonally to the top left. */
-    if (sequence_a[row - 1] == sequence_b[col - 1])
+    return cancellation_token && cancellation_token->isCancelled();
+  }
+
+  /* Records a cancelled solve: there is no result, only partial stats. */
+  void finishCancelled()
+  {
+    longest_common_subsequence.clear();
+    match_runs.clear();
+    edit_runs.clear();
+    time_taken = timer.stop();
+  }
+
+  /* Returns a checkpoint with no strips that identifies this input. */
+  Checkpoint emptyCheckpoint() const
+  {
+    return Checkpoint(sequence_a.str(), sequence_b.str());
+  }
+
+  /* Copies the completed part of a strip out of the matrix: row `row` from
+  start_col to end_col, and the last column from edge_first_row to row. */
+  CheckpointStrip snapshotStrip(const int start_col, const int end_col,
+                                const int row, const int edge_first_row) const
+  {
+    CheckpointStrip strip;
+    strip.start_col = start_col;
+    strip.end_col = end_col;
+    strip.row = row;
+    if (end_col >= start_col)
     {
-      /* If i is 0 then we are in the top row,
-      if j is 0 then we are in the leftmost column,
-      either way, there is no entry diagonally to the top left, so treat it as 0. */
-      int top_left = 0;
-      if (row > 0 && col > 0)
-      {
-        top_left = matrix[row - 1][col - 1];
-      }
-      matrix[row][col] = top_left + 1;
-      return;
+      strip.values.assign(matrix[row] + start_col, matrix[row] + end_col + 1);
+    }
+    strip.edge_first_row = edge_first_row;
+    for (int i = edge_first_row; i <= row && end_col >= 0; i++)
+    {
+      strip.edge_values.push_back(matrix[i][end_col]);
     }
-    /* If characters are not the same, set entry to the higher of either the entry directly above or the entry directly to the left. */
-    int top, left;
-    top = left = 0;
-    if (row > 0)
+    return strip;
+  }
+
+  /* Writes a strip of a checkpoint back into the matrix. */
+  void restoreStrip(const CheckpointStrip &strip)
+  {
+    for (size_t k = 0; k < strip.values.size(); k++)
     {
-      top = matrix[row - 1][col];
+      matrix[strip.row][strip.start_col + k] = strip.values[k];
     }
-    if (col > 0)
+    for (size_t k = 0; k < strip.edge_values.size(); k++)
     {
-      left = matrix[row][col - 1];
+      matrix[strip.edge_first_row + k][strip.end_col] = strip.edge_values[k];
     }
-    matrix[row][col] = std::max(top, left);
   }
 
-  // Traces through the matrix to reconstruct the longest common subsequence.
-  virtual void determineLongestCommonSubsequence()
+  /* True if a strip of a checkpoint covers the given columns and fits in
+  the matrix. */
+  bool stripFits(const CheckpointStrip &strip, const int start_col,
+                 const int end_col) const
+  {
+    int n_cols = std::max(0, end_col - start_col + 1);
+    int n_edge_rows = std::max(0, strip.row - strip.edge_first_row + 1);
+    return strip.start_col == start_col && strip.end_col == end_col &&
+           strip.row >= 0 && strip.row < matrix_height &&
+           (int)strip.values.size() == n_cols &&
+           strip.edge_first_row >= 0 &&
+           (strip.edge_values.empty() || (int)strip.edge_values.size() == n_edge_rows);
+  }
+
+  /* True if the strips of a checkpoint match how this engine divides the
+  matrix. The default is a single strip of every column. */
+  virtual bool checkpointFits(const Checkpoint &checkpoint) const
   {
-    // Start at the maximal entry, the bottom-right.
-    int i = matrix_height - 1;
-    int j = matrix_width - 1;
-    int current = matrix[i][j];
-    longest_common_subsequence.resize(current, ' ');
-    int index = current - 1;
-    while (index >= 0 && i > 0 && j > 0)
+    return checkpoint.strips.size() == 1 &&
+           stripFits(checkpoint.strips[0], 1, matrix_width - 1);
+  }
+
+  /* Saves a checkpoint, reporting but otherwise ignoring failures so that
+  the solve carries on. */
+  void saveCheckpoint(const Checkpoint &checkpoint, const std::string &path)
+  {
+    if (!checkpoint.save(path))
     {
-      current = matrix[i][j];
-      int top, left, top_left;
-      top = left = top_left = 0;
+      std::cerr << "Error writing checkpoint: " << path << std::endl;
+    }
+  }
+
+  /* The logic for computing the entries of the matrix is the same regardless
+  of which algorithm is being used. The engines compute a row segment at a
+  time, so a subclass that scores the cells differently (see scoring.h)
+  overrides this with its own kernel, and pays for one virtual call per
+  segment rather than one per cell. */
+  virtual void computeRow(const int row, const int first_col, const int last_col)
+  {
+    computeScoredRow(LCSScoring(), sequence_a[row - 1], sequence_b.data,
+                     matrix[row - 1], matrix[row], first_col, last_col);
+  }
 
-      top_left = matrix[i - 1][j - 1];
-      top = matrix[i - 1][j];
-      left = matrix[i][j - 1];
+  /* Finds the cell the traceback starts from, the bottom-right, and returns
+  its value. */
+  virtual int tracebackStart(int &i, int &j)
+  {
+    i = matrix_height - 1;
+    j = matrix_width - 1;
+    return matrix[i][j];
+  }
 
-      if (top_left == current)
+  /* Takes one step of the traceback back from (i, j), and returns the move.
+  A match is at the cell it moves to. */
+  virtual TracebackMove tracebackStep(int &i, int &j) const
+  {
+    return scoredTracebackStep(LCSScoring(), matrix, sequence_a.data,
+                               sequence_b.data, i, j);
+  }
+
+  /* True if the alignment may start and end anywhere in the matrix, rather
+  than at its corners. */
+  virtual bool localAlignment() const
+  {
+    return false;
+  }
+
+  /* True if a resumed solve may leave the rows above its checkpoint unfilled,
+  since the traceback can align that part of the sequences in linear space.
+  Only the LCS recurrence has a bit-parallel kernel for the passes, so the
+  other recurrences recompute those rows instead. */
+  virtual bool tracesUnfilledRows() const
+  {
+    return true;
+  }
+
+  /* True if the traceback step from (i, j) reads only filled cells. */
+  bool tracebackStepFilled(const int i, const int j) const
+  {
+    return first_filled_rows.empty() ||
+           (i - 1 >= first_filled_rows[j] && i - 1 >= first_filled_rows[j - 1]);
+  }
+
+  /* Prepends an optimal alignment of a[a_start, a_end) and b[b_start, b_end)
+  to the traceback, in linear space. As in lcs_hirschberg.h, the rows are
+  split in half, and the last row of each half's matrix, the bottom one with
+  both sequences reversed, shows where an optimal alignment crosses the
+  middle. Here the passes are computed 64 cells at a time by BitParallelLCS,
+  so aligning the part of a resumed solve above its checkpoint costs a small
+  fraction of recomputing it. Small parts are traced back through a full
+  matrix. reversed_a and reversed_b are a and b back to front. */
+  void prependLinearAlignment(const Sequence &a, const Sequence &b,
+                              const std::string &reversed_a,
+                              const std::string &reversed_b, const int a_start,
+                              const int a_end, const int b_start, const int b_end)
+  {
+    const int n = a_end - a_start;
+    const int m = b_end - b_start;
+    if (n <= 1 || m == 0 || (long long)(n + 1) * (m + 1) <= LINEAR_TRACEBACK_CELLS)
+    {
+      std::vector<int> cells((size_t)(n + 1) * (m + 1), 0);
+      std::vector<int *> rows(n + 1);
+      for (int i = 0; i <= n; i++)
       {
-        // Go to entry to the top-left.
-        i--;
-        j--;
-        continue;
+        rows[i] = cells.data() + (size_t)i * (m + 1);
+        if (i > 0)
+          computeScoredRow(LCSScoring(), a[a_start + i - 1], b.data + b_start,
+                           rows[i - 1], rows[i], 1, m);
       }
-
-      /* If the elements above, to the left, and diagonally to the top left
-      are all the same,  */
-      if (top_left == top && top_left == left)
+      int i = n, j = m;
+      while (i > 0 && j > 0)
       {
-        longest_common_subsequence[index] = sequence_a[i - 1];
-        index--;
-        // Go to entry to the top-left.
-        i--;
-        j--;
+        TracebackMove move = scoredTracebackStep(LCSScoring(), rows.data(),
+                                                 a.data + a_start, b.data + b_start, i, j);
+        prependEdit(edit_runs, editOp(move));
+        if (move == TRACEBACK_MATCH)
+        {
+          longest_common_subsequence += a[a_start + i];
+          prependMatch(match_runs, a_start + i, b_start + j);
+        }
+      }
+      prependEdit(edit_runs, 'I', j);
+      prependEdit(edit_runs, 'D', i);
+      return;
+    }
+
+    const int a_mid = a_start + n / 2;
+    std::vector<int> forward(m + 1), reverse(m + 1);
+    bitParallelLastColumn(Sequence(b.data + b_start, m),
+                          Sequence(a.data + a_start, a_mid - a_start), forward.data());
+    bitParallelLastColumn(Sequence(reversed_b.data() + b.length() - b_end, m),
+                          Sequence(reversed_a.data() + a.length() - a_end, a_end - a_mid),
+                          reverse.data());
+    int split = 0;
+    for (int k = 1; k <= m; k++)
+    {
+      if (forward[k] + reverse[m - k] > forward[split] + reverse[m - split])
+        split = k;
+    }
+    // The traceback runs from the end, so the bottom half goes first.
+    prependLinearAlignment(a, b, reversed_a, reversed_b, a_mid, a_end,
+                           b_start + split, b_end);
+    prependLinearAlignment(a, b, reversed_a, reversed_b, a_start, a_mid,
+                           b_start, b_start + split);
+  }
+
+  /* Prepends an optimal alignment of the first length_a characters of a and
+  the first length_b of b, where the traceback has reached rows that a
+  resumed solve left unfilled. */
+  void traceUnfilledRows(const Sequence &a, const Sequence &b, const int length_a,
+                         const int length_b)
+  {
+    std::string reversed_a(a.data, length_a), reversed_b(b.data, length_b);
+    std::reverse(reversed_a.begin(), reversed_a.end());
+    std::reverse(reversed_b.begin(), reversed_b.end());
+    prependLinearAlignment(Sequence(a.data, length_a), Sequence(b.data, length_b),
+                           reversed_a, reversed_b, 0, length_a, 0, length_b);
+  }
 
-        continue;
+  /* Fills the cells that a resumed solve left unfilled, for callers that need
+  the whole matrix rather than the alignment. Each row is computed from left
+  to right, so every cell's neighbors are filled before it. */
+  virtual void fillUnfilledRows()
+  {
+    if (first_filled_rows.empty())
+      return;
+    int end_row = *std::max_element(first_filled_rows.begin(), first_filled_rows.end());
+    for (int i = 1; i < end_row; i++)
+    {
+      for (int j = 1; j < matrix_width; j++)
+      {
+        if (first_filled_rows[j] <= i)
+          continue;
+        int last_col = j;
+        while (last_col + 1 < matrix_width && first_filled_rows[last_col + 1] > i)
+          last_col++;
+        computeRow(i, j, last_col);
+        j = last_col;
       }
+    }
+    first_filled_rows.clear();
+  }
 
-      /* If the entry to the top left is lower than the current entry but is not
-      equal to the entries above and to the left, then either the one above or
-      the one to the left must be the same as the current. */
-      if (top == current)
+  // Traces through the matrix to reconstruct the longest common subsequence.
+  virtual void determineLongestCommonSubsequence()
+  {
+    // Start at the maximal entry, the bottom-right unless the alignment is
+    // local.
+    int i, j;
+    score = tracebackStart(i, j);
+    longest_common_subsequence.clear();
+    match_runs.clear();
+    edit_runs.clear();
+    // Whatever follows the start is deleted from A and inserted from B.
+    prependEdit(edit_runs, 'I', length_b - j);
+    prependEdit(edit_runs, 'D', length_a - i);
+    while (i > 0 && j > 0)
+    {
+      // Above the checkpoint of a resumed solve, align what is left.
+      if (!tracebackStepFilled(i, j))
       {
-        // Go to the entry above.
-        i--;
-        continue;
+        traceUnfilledRows(sequence_a, sequence_b, i, j);
+        i = j = 0;
+        break;
       }
-      else
+      TracebackMove move = tracebackStep(i, j);
+      if (move == TRACEBACK_STOP)
+        break;
+      prependEdit(edit_runs, editOp(move));
+      if (move == TRACEBACK_MATCH)
       {
-        // If it wasn't the one above, it must be the one to the left.
-        j--;
+        longest_common_subsequence += sequence_a[i];
+        prependMatch(match_runs, i, j);
       }
     }
+    // And so is whatever precedes the end of the path.
+    prependEdit(edit_runs, 'I', j);
+    prependEdit(edit_runs, 'D', i);
+    std::reverse(longest_common_subsequence.begin(), longest_common_subsequence.end());
+    std::reverse(match_runs.begin(), match_runs.end());
+    std::reverse(edit_runs.begin(), edit_runs.end());
+    orientMatchRuns();
+  }
+
+  /* Puts the match runs in the caller's orientation. A transposed alignment
+  is still in order after swapping i and j, since both increase together. */
+  void orientMatchRuns()
+  {
+    if (!transposed)
+      return;
+    for (MatchRun &run : match_runs)
+    {
+      std::swap(run.i, run.j);
+    }
+    transposeEditScript(edit_runs);
+  }
+
+  // The input sequences in the caller's orientation.
+  const Sequence &inputSequenceA() const
+  {
+    return transposed ? sequence_b : sequence_a;
   }
 
+  const Sequence &inputSequenceB() const
+  {
+    return transposed ? sequence_a : sequence_b;
+  }
+
+public:
+  // Fills the matrix and reconstructs the longest common subsequence.
   virtual void
   solve() = 0;
 
-public:
-  LongestCommonSubsequence(const std::string &sequence_a, const std::string &sequence_b)
-      : sequence_a(sequence_a), sequence_b(sequence_b),
-        length_a(sequence_a.length()), length_b(sequence_b.length()),
+  /* If an arena is given, the copies of the sequences and the matrix are
+  allocated from it and are released by resetting the arena, which must not
+  happen before this object is destroyed. If transpose is true, the matrix
+  has a row per character of sequence_b and a column per character of
+  sequence_a. */
+  LongestCommonSubsequence(const Sequence &input_a, const Sequence &input_b,
+                           Arena *arena = nullptr, const bool transpose = false)
+      : arena(arena), transposed(transpose),
+        length_a(transpose ? input_b.length() : input_a.length()),
+        length_b(transpose ? input_a.length() : input_b.length()),
         max_length(std::min(length_a, length_b)),
         matrix_width(length_b + 1), matrix_height(length_a + 1)
   {
-    matrix = new int *[matrix_height];
+    const Sequence &sequence_a = transpose ? input_b : input_a;
+    const Sequence &sequence_b = transpose ? input_a : input_b;
+    char *sequences;
+    if (arena)
+    {
+      sequences = arena->allocate<char>(length_a + length_b);
+    }
+    else
+    {
+      sequence_storage.resize(length_a + length_b);
+      sequences = &sequence_storage[0];
+    }
+    memcpy(sequences, sequence_a.data, length_a);
+    memcpy(sequences + length_a, sequence_b.data, length_b);
+    this->sequence_a.data = sequences;
+    this->sequence_a.size = length_a;
+    this->sequence_b.data = sequences + length_a;
+    this->sequence_b.size = length_b;
+
+    /* The rows are carved out of a single block, so the matrix takes two
+    allocations instead of one per row. */
+    size_t n_cells = (size_t)matrix_height * matrix_width;
+    int *cells;
+    if (arena)
+    {
+      matrix = arena->allocate<int *>(matrix_height);
+      cells = arena->allocate<int>(n_cells);
+    }
+    else
+    {
+      matrix = new int *[matrix_height];
+      cells = new int[n_cells];
+      AllocationCounters::heapAllocations() += 2;
+    }
     for (int i = 0; i < matrix_height; i++)
     {
-      matrix[i] = new int[matrix_width];
+      matrix[i] = cells + (size_t)i * matrix_width;
       // Fill leftmost column with 0s.
       matrix[i][0] = 0;
     }
@@ -159,22 +541,138 @@ public:
 
   virtual ~LongestCommonSubsequence()
   {
-    for (int row = 0; row < matrix_height; row++)
+    if (!arena)
     {
-      delete[] matrix[row];
+      delete[] matrix[0];
+      delete[] matrix;
     }
-    delete[] matrix;
   }
 
-  // Returns the length of the longest common subsequence.
+  // Returns the length of the longest common subsequence, or -1 if the last
+  // solve was cancelled.
   virtual int getLongestSubsequenceLength()
   {
+    if (cancelled)
+      return -1;
     return matrix[matrix_height - 1][matrix_width - 1];
   }
 
-  // Print the matrix to the console.
+  // Returns the score of the alignment found by solve().
+  int getScore() const
+  {
+    return score;
+  }
+
+  // Returns the longest common subsequence found by solve().
+  const std::string &getLongestCommonSubsequence() const
+  {
+    return longest_common_subsequence;
+  }
+
+  // Returns the alignment found by solve() as runs of consecutive matches.
+  const std::vector<MatchRun> &getMatchRuns() const
+  {
+    return match_runs;
+  }
+
+  // Returns the alignment found by solve() as an edit script from A to B.
+  const std::vector<EditRun> &getEditScript() const
+  {
+    return edit_runs;
+  }
+
+  // The lengths of the sequences as they were given, even if transposed.
+  int getLengthA() const
+  {
+    return transposed ? length_b : length_a;
+  }
+
+  int getLengthB() const
+  {
+    return transposed ? length_a : length_b;
+  }
+
+  // Returns true if the solver swapped the roles of the sequences.
+  bool isTransposed() const
+  {
+    return transposed;
+  }
+
+  // Returns the total time taken (in seconds) by the last call to solve().
+  double getTimeTaken() const
+  {
+    return time_taken;
+  }
+
+  // Returns the time taken (in seconds) to compute the entries of the matrix.
+  double getMatrixTimeTaken() const
+  {
+    return matrix_time_taken;
+  }
+
+  /* Subsequent solves stop at the next row or block of rows once the token
+  is cancelled. The token must outlive the solves. */
+  void setCancellationToken(CancellationToken *token)
+  {
+    cancellation_token = token;
+  }
+
+  // Returns true if the last call to solve() was cancelled before finishing.
+  bool wasCancelled() const
+  {
+    return cancelled;
+  }
+
+  // Returns the number of cells of the matrix that the last solve computed.
+  long long getCompletedCells() const
+  {
+    return completed_cells;
+  }
+
+  /* Saves the frontier of the fill to the given file every `interval`
+  seconds during subsequent solves. The file is removed once a solve
+  finishes. */
+  void enableCheckpoints(const std::string &path, const double interval)
+  {
+    checkpoint_path = path;
+    checkpoint_interval = interval;
+  }
+
+  /* Prints the progress of subsequent solves to stderr every `interval`
+  seconds. */
+  void enableProgress(const double interval)
+  {
+    progress_interval = interval;
+  }
+
+  /* Loads a checkpoint so that the next solve() continues from it. Returns
+  false if the file is missing, damaged, or was taken for another input or a
+  different division of the matrix. */
+  virtual bool resumeFrom(const std::string &path)
+  {
+    Checkpoint checkpoint;
+    resuming = checkpoint.load(path, emptyCheckpoint()) && checkpointFits(checkpoint);
+    if (resuming)
+    {
+      resume_checkpoint = checkpoint;
+    }
+    return resuming;
+  }
+
+  /* Writes the matrix to a binary dump file that lcs_matrix_view can read.
+  Returns false if the file could not be written. */
+  virtual bool dumpMatrix(const std::string &path)
+  {
+    fillUnfilledRows();
+    return writeMatrixDump(path, inputSequenceA().data, getLengthA(),
+                           inputSequenceB().data, getLengthB(), matrix[0],
+                           transposed);
+  }
+
+  // Print the matrix to the console. Only practical for small matrices.
   void printMatrix()
   {
+    fillUnfilledRows();
     std::cout << "\n";
 
     /* Prints the matrix in the format:
@@ -182,10 +680,27 @@ public:
      * a0 [ x  x  x ]
      * a1 [ x  x  x ]
      * a2 [ x  x  x ]
+     * in the caller's orientation, even if the solve was transposed.
      */
-
-    // Determine the number of digits in the largest number.
-    int max_num = getLongestSubsequenceLength();
+    const Sequence &input_a = inputSequenceA();
+    const Sequence &input_b = inputSequenceB();
+    auto cell = [this](const int i, const int j)
+    {
+      return transposed ? matrix[j][i] : matrix[i][j];
+    };
+
+    // Determine the number of digits in the largest number, and leave room
+    // for a sign if any entry is negative.
+    int max_num = 0;
+    bool negative = false;
+    for (int i = 0; i <= input_a.length(); i++)
+    {
+      for (int j = 0; j <= input_b.length(); j++)
+      {
+        max_num = std::max(max_num, std::abs(cell(i, j)));
+        negative |= cell(i, j) < 0;
+      }
+    }
     int n_digits = 1;
     int n = max_num;
     while (n >= 10)
@@ -193,25 +708,25 @@ public:
       n /= 10;
       n_digits++;
     }
-    int min_field_width = n_digits + 1;
+    int min_field_width = n_digits + negative + 1;
 
     // Print the elements of sequence_b along the top row.
     std::cout
         << std::setw(3) << " " << std::right; /* Extra padding before first element
         to account for sequence_a being printed down the left side. */
     std::cout << std::setw(min_field_width) << " ";
-    for (int j = 1; j < matrix_width; j++)
+    for (int j = 1; j <= input_b.length(); j++)
     {
-      std::cout << std::setw(min_field_width) << sequence_b[j - 1];
+      std::cout << std::setw(min_field_width) << input_b[j - 1];
     }
     std::cout << "\n";
 
-    for (int i = 0; i < matrix_height; i++)
+    for (int i = 0; i <= input_a.length(); i++)
     {
       // Print sequence_a down the left side of the matrix.
       if (i > 0)
       {
-        std::cout << sequence_a[i - 1];
+        std::cout << input_a[i - 1];
       }
       else
       {
@@ -219,9 +734,9 @@ public:
       }
       std::cout << " [" << std::right;
 
-      for (int j = 0; j < matrix_width; j++)
+      for (int j = 0; j <= input_b.length(); j++)
       {
-        std::cout << std::setw(min_field_width) << matrix[i][j];
+        std::cout << std::setw(min_field_width) << cell(i, j);
       }
       std::cout << " ]\n";
     }
@@ -230,8 +745,8 @@ public:
 
   virtual void printLCS()
   {
-    std::cout << "Sequence A: " << sequence_a << "\n";
-    std::cout << "Sequence B: " << sequence_b << "\n";
+    std::cout << "Sequence A: " << inputSequenceA() << "\n";
+    std::cout << "Sequence B: " << inputSequenceB() << "\n";
     std::cout << "Longest common subsequence: " << longest_common_subsequence << "\n";
   }
 
@@ -267,9 +782,39 @@ public:
     printMatrixTimeTaken();
     printTotalTimeTaken();
   }
+
+  // Prints how far a cancelled solve got.
+  virtual void printCancelled(FILE *out_file)
+  {
+    long long total_cells = (long long)length_a * length_b;
+    fprintf(out_file, "Solve cancelled after %lf seconds\n", time_taken);
+    fprintf(out_file, "Cells computed: %lld of %lld (%.1f%%)\n", completed_cells,
+            total_cells, total_cells > 0 ? 100.0 * completed_cells / total_cells : 0.0);
+  }
 };
 
-void read_input_csv(const std::string &input_file_path, std::string &sequence_a, std::string &sequence_b)
+/* Applies the --checkpoint_file, --checkpoint_interval and --resume options
+of the serial and parallel programs. Without a checkpoint file to resume from,
+the solve starts from the beginning. */
+inline void configure_checkpoints(LongestCommonSubsequence &lcs,
+                                  const std::string &checkpoint_file,
+                                  const double checkpoint_interval,
+                                  const bool resume)
+{
+  if (checkpoint_file == "")
+    return;
+
+  lcs.enableCheckpoints(checkpoint_file, checkpoint_interval);
+  if (resume && std::ifstream(checkpoint_file).good() &&
+      !lcs.resumeFrom(checkpoint_file))
+  {
+    std::cerr << "Error: cannot resume from checkpoint: " << checkpoint_file
+              << std::endl;
+    exit(1);
+  }
+}
+
+inline void read_input_csv(const std::string &input_file_path, std::string &sequence_a, std::string &sequence_b)
 {
   std::ifstream in_file(input_file_path);
   if (!in_file.is_open())
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <string>
+
+#include "cxxopts.hpp"  // Command-line option parser library
+#include "lcs_anchor.h" // Header file containing the LongestCommonSubsequenceAnchored class
+#include "lcs_output.h" // Binary and JSONL result formats
+
+// ***
+//  This is the anchored version of the LCS program, for long and similar
+//  sequences. It chains exact k-mer matches between the sequences and only
+//  solves the gaps between them, on multiple threads.
+// ***
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_anchor",
+                           "LCS program for CMPT 431 project using k-mer anchors");
+
+  options.add_options(
+      "inputs",
+      {
+          {"n_threads", "Number of threads for the program",
+           cxxopts::value<int>()->default_value("1")},
+          {"kmer_length", "Length of the exact matches used as anchors.",
+           cxxopts::value<int>()->default_value("16")},
+          {"max_occurrences", "Skip k-mers that occur more often than this in sequence B.",
+           cxxopts::value<int>()->default_value("16")},
+          {"fast", "Do not check the result against the exact LCS length; it may then be shorter than the longest.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"sequence_a", "First input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_b", "Second input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"input_file", "Path to input .csv file.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"output_format", "Result format: text, binary, jsonl or edits.",
+           cxxopts::value<std::string>()->default_value("text")},
+          {"output_file", "Path to write binary or jsonl results to (default: stdout).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"alignment", "Include the alignment as runs of matches in binary or jsonl results.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  int n_threads = command_options["n_threads"].as<int>();
+  int kmer_length = command_options["kmer_length"].as<int>();
+  int max_occurrences = command_options["max_occurrences"].as<int>();
+  bool fast = command_options["fast"].as<bool>();
+
+  std::string sequence_a = command_options["sequence_a"].as<std::string>();
+  std::string sequence_b = command_options["sequence_b"].as<std::string>();
+  std::string input_file = command_options["input_file"].as<std::string>();
+  LCSOutputFormat output_format;
+  if (!parseOutputFormat(command_options["output_format"].as<std::string>(), output_format))
+  {
+    std::cerr << "Error: unknown output format: "
+              << command_options["output_format"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  std::string output_file = command_options["output_file"].as<std::string>();
+  double time_limit = command_options["time_limit"].as<double>();
+
+  if (input_file != "")
+  {
+    // Read sequences from .csv file if file path was provided.
+    read_input_csv(input_file, sequence_a, sequence_b);
+  }
+
+  if (sequence_a.length() < 1 || sequence_b.length() < 1)
+  {
+    std::cerr << "Error: sequences cannot be empty." << std::endl;
+    exit(1);
+  }
+  if (n_threads <= 0)
+  {
+    std::cerr << "Error: Number of threads must be greater than zero.\n";
+    return 1;
+  }
+  if (kmer_length <= 0 || max_occurrences <= 0)
+  {
+    std::cerr << "Error: kmer_length and max_occurrences must be greater than zero.\n";
+    return 1;
+  }
+
+  LongestCommonSubsequenceAnchored lcs(sequence_a, sequence_b, n_threads,
+                                       kmer_length, max_occurrences, fast);
+  CancellationToken cancellation;
+  cancellation.setTimeLimit(time_limit);
+  lcs.setCancellationToken(&cancellation);
+
+  if (output_format != LCS_OUTPUT_TEXT)
+  {
+    lcs.solve();
+    if (lcs.wasCancelled())
+    {
+      fprintf(stderr, "Solve cancelled after %lf seconds\n", lcs.getTimeTaken());
+      return 2;
+    }
+    // Plain LCS, so the score is the length.
+    int length = lcs.getLongestSubsequenceLength();
+    if (!writeResult(output_file, output_format, lcs.getLengthA(), lcs.getLengthB(),
+                     length, length, lcs.getMatrixTimeTaken(),
+                     lcs.getTimeTaken(),
+                     command_options["alignment"].as<bool>() ? &lcs.getMatchRuns() : NULL,
+                     &lcs.getEditScript()))
+    {
+      std::cerr << "Error writing file: " << output_file << std::endl;
+      exit(1);
+    }
+    return 0;
+  }
+
+  printf("_-_-_-_-_-_-_-_-_ LCS Anchored _-_-_-_-_-_-_-_-_\n");
+  printf("Number of Threads: %d\n", n_threads);
+  printf("Anchor Length: %d\n", kmer_length);
+  printf("Mode: %s\n", fast ? "fast" : "exact");
+  printf("Starting LCS Anchored Solver\n");
+  lcs.solve();
+
+  if (lcs.wasCancelled())
+  {
+    printf("LCS Anchored Solver Cancelled\n\n");
+    printf("Solve cancelled after %lf seconds\n", lcs.getTimeTaken());
+    return 2;
+  }
+  printf("LCS Anchored Solver Finished\n\n");
+
+  printf("-_-_-_-_-_-_-_ LCS Anchored Results _-_-_-_-_-_-_-\n");
+  lcs.printInfo();
+  lcs.printAnchorStats();
+
+  return 0;
+}
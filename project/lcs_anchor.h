@@ -0,0 +1,519 @@
+#ifndef _LCS_ANCHOR_H_
+#define _LCS_ANCHOR_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bit_parallel.h"
+#include "lcs.h"
+#include "lcs_parallel.h"
+#include "lcs_serial.h"
+#include "thread_pool.h"
+
+/* An exact match of kmer_length characters: sequence_a[i + k] ==
+sequence_b[j + k] for 0 <= k < kmer_length. */
+struct Anchor
+{
+  int i;
+  int j;
+};
+
+/* A subproblem between two chained anchors: the LCS of
+sequence_a[a_start, a_end) and sequence_b[b_start, b_end). */
+struct Gap
+{
+  int a_start, a_end;
+  int b_start, b_end;
+  std::vector<MatchRun> match_runs; // Alignment of the gap, in sequence indices.
+  std::vector<EditRun> edit_runs;   // The same alignment as an edit script.
+  int length = 0;
+
+  long long cells() const
+  {
+    return (long long)(a_end - a_start) * (b_end - b_start);
+  }
+};
+
+/* How the result of an anchored solve was checked. */
+enum AnchorVerification
+{
+  ANCHOR_UNVERIFIED, // Fast mode: the result was not checked.
+  ANCHOR_VERIFIED,   // The chained alignment has the length of the exact LCS.
+  ANCHOR_FALLBACK    // It was shorter, so the full matrix was solved instead.
+};
+
+/**
+ * @brief Solves long, similar sequences by chaining exact k-mer matches.
+ *
+ * The solve has three steps:
+ *
+ * 1. Every k-mer of sequence_b is indexed by a rolling hash, and every k-mer
+ *    of sequence_a that occurs in the index is an anchor. K-mers that occur
+ *    more than max_occurrences times in sequence_b are repeats that would
+ *    only add noise, and are skipped.
+ * 2. The longest chain of non-overlapping anchors that increase in both
+ *    sequences is found in O(n log n), like a longest increasing
+ *    subsequence, with a Fenwick tree of the best chain ending before each
+ *    column.
+ * 3. The gaps between consecutive anchors of the chain are independent LCS
+ *    problems. They are solved exactly by the serial solver, concurrently on
+ *    the thread pool, largest first.
+ *
+ * The chained alignment is a common subsequence, but not necessarily the
+ * longest one: a chain of anchors can commit to a worse alignment than the
+ * optimum. In exact mode, the length of the LCS is computed with the
+ * bit-parallel kernel at the same time as the gaps; if the chained alignment
+ * is shorter, the whole matrix is solved by the parallel solver instead. In
+ * fast mode, that check is skipped and the result is only a lower bound.
+ *
+ * Unlike the other solvers, only the gaps are ever held in memory as
+ * matrices, so it is not a LongestCommonSubsequence.
+ */
+class LongestCommonSubsequenceAnchored
+{
+protected:
+  std::string sequence_a;
+  std::string sequence_b;
+  int numThreads;
+  int kmer_length;
+  int max_occurrences;
+  bool fast; // Skip the check against the exact length.
+
+  ThreadPool thread_pool; // Runs the gaps and the check.
+
+  std::vector<Anchor> chain; // Chained anchors, in order.
+  long long n_anchors = 0;   // Anchors found before chaining.
+  std::vector<Gap> gaps;
+
+  std::string longest_common_subsequence;
+  std::vector<MatchRun> match_runs;
+  std::vector<EditRun> edit_runs; // The same alignment as an edit script.
+  int lcs_length = 0;
+  AnchorVerification verification = ANCHOR_UNVERIFIED;
+
+  CancellationToken *cancellation_token = nullptr;
+  bool cancelled = false;
+
+  Timer timer;
+  double time_taken = 0.0;
+  double anchor_time_taken = 0.0; // Indexing and chaining.
+  double matrix_time_taken = 0.0; // Gaps, check and fallback.
+
+  /* Finds the anchors, in increasing order of i and then j. */
+  std::vector<Anchor> findAnchors() const
+  {
+    std::vector<Anchor> anchors;
+    const int k = kmer_length;
+    const int length_a = sequence_a.length();
+    const int length_b = sequence_b.length();
+    if (k <= 0 || length_a < k || length_b < k)
+      return anchors;
+
+    // Polynomial hash modulo 2^64, rolled one character at a time.
+    const uint64_t BASE = 1000003;
+    uint64_t top_power = 1; // BASE^(k - 1), to remove the oldest character.
+    for (int t = 1; t < k; t++)
+    {
+      top_power *= BASE;
+    }
+    auto hashes = [&](const std::string &sequence, std::vector<uint64_t> &out)
+    {
+      out.resize(sequence.length() - k + 1);
+      uint64_t hash = 0;
+      for (int t = 0; t < k; t++)
+      {
+        hash = hash * BASE + (unsigned char)sequence[t];
+      }
+      out[0] = hash;
+      for (size_t p = 1; p < out.size(); p++)
+      {
+        hash = (hash - (unsigned char)sequence[p - 1] * top_power) * BASE +
+               (unsigned char)sequence[p + k - 1];
+        out[p] = hash;
+      }
+    };
+
+    // The index is a sorted array of (hash, position) pairs of sequence_b,
+    // which takes less memory than a hash map and keeps each k-mer's
+    // positions in increasing order.
+    std::vector<uint64_t> hashes_b;
+    hashes(sequence_b, hashes_b);
+    std::vector<std::pair<uint64_t, int>> index(hashes_b.size());
+    for (size_t j = 0; j < hashes_b.size(); j++)
+    {
+      index[j] = std::make_pair(hashes_b[j], (int)j);
+    }
+    std::vector<uint64_t>().swap(hashes_b);
+    std::sort(index.begin(), index.end());
+
+    std::vector<uint64_t> hashes_a;
+    hashes(sequence_a, hashes_a);
+    for (size_t i = 0; i < hashes_a.size(); i++)
+    {
+      auto first = std::lower_bound(index.begin(), index.end(),
+                                    std::make_pair(hashes_a[i], 0));
+      auto last = first;
+      while (last != index.end() && last->first == hashes_a[i])
+      {
+        ++last;
+      }
+      if (last - first > max_occurrences)
+        continue;
+      for (auto it = first; it != last; ++it)
+      {
+        // Equal hashes are almost always equal k-mers, but not always.
+        if (memcmp(&sequence_a[i], &sequence_b[it->second], k) == 0)
+        {
+          anchors.push_back(Anchor{(int)i, it->second});
+        }
+      }
+    }
+    return anchors;
+  }
+
+  /* Returns the longest chain of anchors in which each anchor starts after
+  the previous one ends in both sequences. */
+  std::vector<Anchor> chainAnchors(const std::vector<Anchor> &anchors) const
+  {
+    const int k = kmer_length;
+    const int n = anchors.size();
+    if (n == 0)
+      return std::vector<Anchor>();
+
+    // Fenwick tree over the end column j + k of the anchors added so far,
+    // holding the longest chain (and its last anchor) ending at or before
+    // each column.
+    const int n_columns = sequence_b.length() + 1;
+    std::vector<std::pair<int, int>> tree(n_columns + 1, std::make_pair(0, -1));
+    auto update = [&](int column, std::pair<int, int> value)
+    {
+      for (; column <= n_columns; column += column & -column)
+      {
+        tree[column] = std::max(tree[column], value);
+      }
+    };
+    auto query = [&](int column)
+    {
+      std::pair<int, int> best(0, -1);
+      for (; column > 0; column -= column & -column)
+      {
+        best = std::max(best, tree[column]);
+      }
+      return best;
+    };
+
+    std::vector<int> chain_lengths(n), previous(n);
+    int added = 0; // Anchors before this one are in the tree.
+    int best = 0;
+    for (int t = 0; t < n; t++)
+    {
+      // An anchor can precede this one once it ends at or before row i.
+      while (anchors[added].i + k <= anchors[t].i)
+      {
+        update(anchors[added].j + k, std::make_pair(chain_lengths[added], added));
+        added++;
+      }
+      std::pair<int, int> before = query(anchors[t].j);
+      chain_lengths[t] = before.first + 1;
+      previous[t] = before.second;
+      if (chain_lengths[t] > chain_lengths[best])
+        best = t;
+    }
+
+    std::vector<Anchor> result;
+    for (int t = best; t >= 0; t = previous[t])
+    {
+      result.push_back(anchors[t]);
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+  }
+
+  /* Solves one gap with the serial solver. */
+  void solveGap(Gap &gap)
+  {
+    if (gap.a_end <= gap.a_start || gap.b_end <= gap.b_start)
+      return;
+
+    LongestCommonSubsequenceSerial lcs(
+        Sequence(&sequence_a[gap.a_start], gap.a_end - gap.a_start),
+        Sequence(&sequence_b[gap.b_start], gap.b_end - gap.b_start));
+    lcs.setCancellationToken(cancellation_token);
+    lcs.solve();
+    if (lcs.wasCancelled())
+      return;
+    gap.length = lcs.getLongestSubsequenceLength();
+    gap.match_runs = lcs.getMatchRuns();
+    for (MatchRun &run : gap.match_runs)
+    {
+      run.i += gap.a_start;
+      run.j += gap.b_start;
+    }
+    gap.edit_runs = lcs.getEditScript();
+  }
+
+  /* Builds the alignment from the gaps and the anchors between them. */
+  void assembleAlignment()
+  {
+    match_runs.clear();
+    edit_runs.clear();
+    lcs_length = 0;
+    for (size_t g = 0; g < gaps.size(); g++)
+    {
+      for (const MatchRun &run : gaps[g].match_runs)
+      {
+        appendMatchRun(match_runs, run);
+      }
+      if (gaps[g].cells() == 0)
+      {
+        // Only one of the sequences has characters in the gap, so they are
+        // all edits.
+        appendEditRun(edit_runs, EditRun{gaps[g].a_end - gaps[g].a_start, 'D'});
+        appendEditRun(edit_runs, EditRun{gaps[g].b_end - gaps[g].b_start, 'I'});
+      }
+      for (const EditRun &run : gaps[g].edit_runs)
+      {
+        appendEditRun(edit_runs, run);
+      }
+      lcs_length += gaps[g].length;
+      if (g < chain.size())
+      {
+        appendMatchRun(match_runs, MatchRun{chain[g].i, chain[g].j, kmer_length});
+        appendEditRun(edit_runs, EditRun{kmer_length, '='});
+        lcs_length += kmer_length;
+      }
+    }
+  }
+
+  /* Solves the whole matrix, for when the chain missed the optimum. */
+  void solveFull()
+  {
+    LongestCommonSubsequenceParallel lcs(sequence_a, sequence_b, numThreads, 0, 1);
+    lcs.setThreadPool(&thread_pool);
+    lcs.setCancellationToken(cancellation_token);
+    lcs.solve();
+    if (lcs.wasCancelled())
+    {
+      cancelled = true;
+      return;
+    }
+    lcs_length = lcs.getLongestSubsequenceLength();
+    match_runs = lcs.getMatchRuns();
+    edit_runs = lcs.getEditScript();
+  }
+
+public:
+  /* Anchors are exact matches of kmer_length characters. The gaps, the check
+  and the fallback run on n_threads threads. */
+  LongestCommonSubsequenceAnchored(const std::string &sequence_a,
+                                   const std::string &sequence_b,
+                                   const int n_threads, const int kmer_length,
+                                   const int max_occurrences, const bool fast)
+      : sequence_a(sequence_a), sequence_b(sequence_b),
+        numThreads(std::max(1, n_threads)),
+        kmer_length(std::max(1, kmer_length)),
+        max_occurrences(std::max(1, max_occurrences)), fast(fast),
+        thread_pool(std::max(1, n_threads) - 1)
+  {
+  }
+
+  void solve()
+  {
+    timer.start();
+    cancelled = false;
+    verification = ANCHOR_UNVERIFIED;
+
+    Timer anchor_timer;
+    anchor_timer.start();
+    std::vector<Anchor> anchors = findAnchors();
+    n_anchors = anchors.size();
+    chain = chainAnchors(anchors);
+    std::vector<Anchor>().swap(anchors);
+
+    // One gap before each anchor of the chain and one after the last.
+    gaps.assign(chain.size() + 1, Gap());
+    int a_start = 0, b_start = 0;
+    for (size_t g = 0; g <= chain.size(); g++)
+    {
+      gaps[g].a_start = a_start;
+      gaps[g].b_start = b_start;
+      gaps[g].a_end = g < chain.size() ? chain[g].i : sequence_a.length();
+      gaps[g].b_end = g < chain.size() ? chain[g].j : sequence_b.length();
+      if (g < chain.size())
+      {
+        a_start = chain[g].i + kmer_length;
+        b_start = chain[g].j + kmer_length;
+      }
+    }
+    anchor_time_taken = anchor_timer.stop();
+
+    Timer matrix_timer;
+    matrix_timer.start();
+
+    // Largest gaps first, so that no thread is left with a big one at the
+    // end. Task 0 is the check against the exact length, which takes longer
+    // than any gap.
+    std::vector<int> order;
+    for (size_t g = 0; g < gaps.size(); g++)
+    {
+      if (gaps[g].cells() > 0)
+        order.push_back(g);
+    }
+    std::sort(order.begin(), order.end(), [this](int x, int y)
+              { return gaps[x].cells() > gaps[y].cells(); });
+    int exact_length = -1;
+    int first_gap = fast ? 0 : 1;
+    thread_pool.run(order.size() + first_gap, [&](int task)
+                    {
+      if (task < first_gap)
+        exact_length = bitParallelLCSLength(sequence_a, sequence_b, cancellation_token);
+      else
+        solveGap(gaps[order[task - first_gap]]); });
+
+    if (cancellation_token && cancellation_token->isCancelled())
+    {
+      cancelled = true;
+    }
+    else
+    {
+      assembleAlignment();
+      if (!fast)
+      {
+        verification = ANCHOR_VERIFIED;
+        if (lcs_length != exact_length)
+        {
+          verification = ANCHOR_FALLBACK;
+          solveFull();
+        }
+      }
+    }
+    matrix_time_taken = matrix_timer.stop();
+
+    if (cancelled)
+    {
+      longest_common_subsequence.clear();
+      match_runs.clear();
+      edit_runs.clear();
+      time_taken = timer.stop();
+      return;
+    }
+
+    longest_common_subsequence.clear();
+    longest_common_subsequence.reserve(lcs_length);
+    for (const MatchRun &run : match_runs)
+    {
+      longest_common_subsequence.append(sequence_a, run.i, run.length);
+    }
+    time_taken = timer.stop();
+  }
+
+  /* Subsequent solves stop at the next gap row or check row once the token
+  is cancelled. The token must outlive the solves. */
+  void setCancellationToken(CancellationToken *token)
+  {
+    cancellation_token = token;
+  }
+
+  bool wasCancelled() const
+  {
+    return cancelled;
+  }
+
+  // Returns the length of the LCS found, or -1 if the last solve was
+  // cancelled.
+  int getLongestSubsequenceLength() const
+  {
+    return cancelled ? -1 : lcs_length;
+  }
+
+  const std::string &getLongestCommonSubsequence() const
+  {
+    return longest_common_subsequence;
+  }
+
+  const std::vector<MatchRun> &getMatchRuns() const
+  {
+    return match_runs;
+  }
+
+  const std::vector<EditRun> &getEditScript() const
+  {
+    return edit_runs;
+  }
+
+  int getLengthA() const
+  {
+    return sequence_a.length();
+  }
+
+  int getLengthB() const
+  {
+    return sequence_b.length();
+  }
+
+  double getTimeTaken() const
+  {
+    return time_taken;
+  }
+
+  double getMatrixTimeTaken() const
+  {
+    return matrix_time_taken;
+  }
+
+  AnchorVerification getVerification() const
+  {
+    return verification;
+  }
+
+  void printInfo()
+  {
+    std::cout << "Sequence A: " << sequence_a << "\n";
+    std::cout << "Sequence B: " << sequence_b << "\n";
+    std::cout << "Longest common subsequence: " << longest_common_subsequence << "\n";
+    std::cout << "Length of the longest common subsequence: " << getLongestSubsequenceLength() << "\n";
+  }
+
+  // Prints how the anchors divided the matrix and how the result was checked.
+  void printAnchorStats()
+  {
+    long long gap_cells = 0;
+    for (const Gap &gap : gaps)
+    {
+      gap_cells += gap.cells();
+    }
+    long long total_cells = (long long)sequence_a.length() * sequence_b.length();
+
+    printf("\n-_-_-_-_-_-_-_ LCS Anchored Statistics _-_-_-_-_-_-_-\n\n");
+    printf("Anchors found: %lld\n", n_anchors);
+    printf("Anchors chained: %zu (%lld characters)\n", chain.size(),
+           (long long)chain.size() * kmer_length);
+    printf("Gaps: %zu\n", gaps.size());
+    printf("Cells in gaps: %lld of %lld (%.2f%%)\n", gap_cells, total_cells,
+           total_cells > 0 ? 100.0 * gap_cells / total_cells : 0.0);
+    switch (verification)
+    {
+    case ANCHOR_UNVERIFIED:
+      printf("Check: skipped (fast mode, the LCS may be shorter than the longest)\n");
+      break;
+    case ANCHOR_VERIFIED:
+      printf("Check: the chained LCS has the exact length\n");
+      break;
+    case ANCHOR_FALLBACK:
+      printf("Check: the chained LCS was shorter, solved the whole matrix instead\n");
+      break;
+    }
+    printf("Time taken to chain anchors: %lf\n", anchor_time_taken);
+    printf("Time taken to solve gaps: %lf\n", matrix_time_taken);
+    printf("Total time taken: %lf\n", time_taken);
+  }
+};
+
+#endif
@@ -0,0 +1,361 @@
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bounded_queue.h"
+#include "cxxopts.hpp"
+#include "lcs_cache.h"
+#include "lcs_parallel.h"
+#include "lcs_protocol.h"
+#include "lcs_serial.h"
+
+// ***
+//  Batch LCS program. Solves every pair of a large input file as a pipeline
+//  of three stages that run at the same time:
+//
+//    reader   - parses pairs straight out of the memory-mapped input file,
+//    workers  - solve the pairs, each with its own arena,
+//    writer   - formats the results, in input order or as they complete.
+//
+//  The stages are connected by bounded lock-free queues, so parsing and
+//  output formatting overlap with the computation instead of running before
+//  and after it.
+// ***
+
+/* A pair of the input. The sequences point into the mapped file. */
+struct BatchItem
+{
+  long long index = -1;
+  Sequence sequence_a;
+  Sequence sequence_b;
+};
+
+/* The result of a pair, on its way to the writer. */
+struct BatchResult
+{
+  long long index = -1;
+  int length = 0; // -1 if the solve was cancelled.
+  std::string subsequence;
+};
+
+/* Everything the stages share. */
+struct Pipeline
+{
+  BoundedQueue<BatchItem> items;
+  BoundedQueue<BatchResult> results;
+  std::atomic<int> n_active_workers;
+  std::atomic<long long> n_pairs;
+  std::atomic<long long> n_cells;
+  std::atomic<long long> n_cancelled;
+  ResultCache cache;
+
+  std::string engine;
+  int n_threads; // Threads per pair for the parallel engine.
+  uint32_t mode; // LCS_MODE_LENGTH or LCS_MODE_STRING.
+  size_t arena_size;
+  double time_limit; // Seconds per pair, or 0 for no limit.
+
+  Pipeline(size_t queue_size, size_t cache_bytes)
+      : items(queue_size), results(queue_size),
+        n_active_workers(0), n_pairs(0), n_cells(0), n_cancelled(0), cache(cache_bytes)
+  {
+  }
+};
+
+// Reader stage: splits the mapped file into pairs, one per line.
+void read_pairs(Pipeline &pipeline, const char *data, size_t size)
+{
+  long long index = 0;
+  size_t position = 0;
+  while (position < size)
+  {
+    size_t line_end = position;
+    while (line_end < size && data[line_end] != '\n')
+      line_end++;
+
+    // Each line holds two sequences separated by a comma.
+    size_t comma = position;
+    while (comma < line_end && data[comma] != ',')
+      comma++;
+    if (comma < line_end)
+    {
+      size_t end_b = comma + 1;
+      while (end_b < line_end && data[end_b] != ',' && data[end_b] != '\r')
+        end_b++;
+
+      BatchItem item;
+      item.index = index++;
+      item.sequence_a = Sequence(data + position, comma - position);
+      item.sequence_b = Sequence(data + comma + 1, end_b - comma - 1);
+      pipeline.items.push(item);
+    }
+    position = line_end + 1;
+  }
+  pipeline.items.close();
+}
+
+// Compute stage: solves pairs until the reader is done and the queue is empty.
+void solve_pairs(Pipeline &pipeline)
+{
+  Arena arena(pipeline.arena_size);
+  CancellationToken cancellation;
+  BatchItem item;
+  while (pipeline.items.pop(item))
+  {
+    BatchResult result;
+    result.index = item.index;
+    PairHash key = hashPair(item.sequence_a.data, item.sequence_a.size,
+                            item.sequence_b.data, item.sequence_b.size,
+                            pipeline.mode);
+    CachedResult cached;
+    if (pipeline.cache.get(key, cached))
+    {
+      result.length = cached.length;
+      result.subsequence = cached.subsequence;
+    }
+    else
+    {
+      std::unique_ptr<LongestCommonSubsequence> lcs;
+      if (pipeline.engine == "parallel")
+      {
+        lcs.reset(new LongestCommonSubsequenceParallel(
+            item.sequence_a, item.sequence_b, pipeline.n_threads, 0, 1, &arena));
+      }
+      else
+      {
+        lcs.reset(new LongestCommonSubsequenceSerial(
+            item.sequence_a, item.sequence_b, &arena));
+      }
+      cancellation.reset();
+      cancellation.setTimeLimit(pipeline.time_limit);
+      lcs->setCancellationToken(&cancellation);
+      lcs->solve();
+      bool cancelled = lcs->wasCancelled();
+      result.length = lcs->getLongestSubsequenceLength();
+      if (pipeline.mode == LCS_MODE_STRING)
+        result.subsequence = lcs->getLongestCommonSubsequence();
+      pipeline.n_cells += lcs->getCompletedCells();
+      lcs.reset();
+      arena.reset();
+
+      // Only complete results are worth remembering.
+      if (cancelled)
+      {
+        pipeline.n_cancelled++;
+      }
+      else
+      {
+        cached.length = result.length;
+        cached.subsequence = result.subsequence;
+        pipeline.cache.put(key, cached);
+      }
+    }
+
+    pipeline.n_pairs++;
+    pipeline.results.push(result);
+  }
+  // The last worker to finish tells the writer there are no more results.
+  if (--pipeline.n_active_workers == 0)
+    pipeline.results.close();
+}
+
+// Writer stage: formats results as "index,length[,subsequence]" lines. The
+// length of a cancelled pair is -1.
+void write_results(Pipeline &pipeline, FILE *out_file, bool ordered)
+{
+  std::map<long long, BatchResult> pending; // Results that arrived early.
+  long long next_index = 0;
+  BatchResult result;
+
+  auto write = [&](const BatchResult &result)
+  {
+    fprintf(out_file, "%lld,%d", result.index, result.length);
+    if (pipeline.mode == LCS_MODE_STRING)
+    {
+      fputc(',', out_file);
+      fwrite(result.subsequence.data(), 1, result.subsequence.length(), out_file);
+    }
+    fputc('\n', out_file);
+  };
+
+  while (pipeline.results.pop(result))
+  {
+    if (!ordered)
+    {
+      write(result);
+    }
+    else
+    {
+      pending[result.index] = std::move(result);
+      // Write every result that is now next in line.
+      for (auto it = pending.begin();
+           it != pending.end() && it->first == next_index;
+           it = pending.erase(it), next_index++)
+      {
+        write(it->second);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  Timer program_timer;
+  program_timer.start();
+
+  cxxopts::Options options("lcs_batch",
+                           "Pipelined LCS of every pair in a batch file.");
+
+  int n_cores = std::max(1u, std::thread::hardware_concurrency());
+  options.add_options(
+      "inputs",
+      {
+          {"input_file", "Path to input .csv file with one pair per line.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"output_file", "Path to write the results to (default: stdout).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"engine", "Solver for each pair: serial or parallel.",
+           cxxopts::value<std::string>()->default_value("serial")},
+          {"n_workers", "Number of pairs solved at the same time.",
+           cxxopts::value<int>()->default_value(std::to_string(n_cores))},
+          {"n_threads", "Threads per pair for the parallel engine.",
+           cxxopts::value<int>()->default_value("1")},
+          {"string", "Output the LCS as well as its length.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"unordered", "Write results as soon as they are solved.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"queue_size", "Capacity of the queues between stages.",
+           cxxopts::value<int>()->default_value("1024")},
+          {"arena_size", "Scratch memory preallocated for each worker, in megabytes.",
+           cxxopts::value<int>()->default_value("16")},
+          {"cache_size", "Memory for cached results, in megabytes (0 = no cache).",
+           cxxopts::value<int>()->default_value("64")},
+          {"cache_file", "Load cached results from this file at startup and save them on exit.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"time_limit", "Cancel the solve of a pair after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  std::string input_file = command_options["input_file"].as<std::string>();
+  std::string output_file = command_options["output_file"].as<std::string>();
+  std::string engine = command_options["engine"].as<std::string>();
+  int n_workers = std::max(1, command_options["n_workers"].as<int>());
+  std::string cache_file = command_options["cache_file"].as<std::string>();
+  size_t cache_size = std::max(0, command_options["cache_size"].as<int>());
+
+  if (input_file == "")
+  {
+    std::cerr << "Error: --input_file is required." << std::endl;
+    exit(1);
+  }
+  if (engine != "serial" && engine != "parallel")
+  {
+    std::cerr << "Error: unknown engine: " << engine << std::endl;
+    exit(1);
+  }
+
+  // Map the whole input file so the reader can parse it without copying.
+  int fd = open(input_file.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if (fd < 0 || fstat(fd, &file_stat) < 0)
+  {
+    std::cerr << "Error reading file: " << input_file << std::endl;
+    exit(1);
+  }
+  size_t size = file_stat.st_size;
+  const char *data = NULL;
+  if (size > 0)
+  {
+    data = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      std::cerr << "Error reading file: " << input_file << std::endl;
+      exit(1);
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+  }
+
+  FILE *out_file = stdout;
+  if (output_file != "")
+  {
+    out_file = fopen(output_file.c_str(), "w");
+    if (!out_file)
+    {
+      std::cerr << "Error writing file: " << output_file << std::endl;
+      exit(1);
+    }
+  }
+  // Results are small, so write them in large blocks.
+  static char out_buffer[1 << 20];
+  setvbuf(out_file, out_buffer, _IOFBF, sizeof(out_buffer));
+
+  Pipeline pipeline(std::max(2, command_options["queue_size"].as<int>()),
+                    cache_size << 20);
+  pipeline.engine = engine;
+  pipeline.n_threads = std::max(1, command_options["n_threads"].as<int>());
+  pipeline.mode = command_options["string"].as<bool>() ? LCS_MODE_STRING : LCS_MODE_LENGTH;
+  pipeline.arena_size = (size_t)std::max(1, command_options["arena_size"].as<int>()) << 20;
+  pipeline.time_limit = command_options["time_limit"].as<double>();
+  if (cache_file != "")
+  {
+    pipeline.cache.load(cache_file);
+  }
+
+  Timer pipeline_timer;
+  pipeline_timer.start();
+  pipeline.n_active_workers = n_workers;
+  std::thread reader(read_pairs, std::ref(pipeline), data, size);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < n_workers; i++)
+  {
+    workers.emplace_back(solve_pairs, std::ref(pipeline));
+  }
+  write_results(pipeline, out_file, !command_options["unordered"].as<bool>());
+
+  reader.join();
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+  fflush(out_file);
+  double pipeline_time_taken = pipeline_timer.stop();
+
+  if (out_file != stdout)
+    fclose(out_file);
+  if (data)
+    munmap((void *)data, size);
+  close(fd);
+
+  if (cache_file != "" && !pipeline.cache.save(cache_file))
+  {
+    std::cerr << "Error writing file: " << cache_file << std::endl;
+  }
+
+  // Print the statistics of the run, after any results written to stdout.
+  printf("-------------------- LCS Batch --------------------\n");
+  printf("Pairs: %lld\n", pipeline.n_pairs.load());
+  if (pipeline.n_cancelled > 0)
+    printf("Pairs cancelled: %lld\n", pipeline.n_cancelled.load());
+  printf("Workers: %d (%s engine)\n", n_workers, engine.c_str());
+  printf("Pipeline time taken: %lf\n", pipeline_time_taken);
+  if (pipeline_time_taken > 0.0)
+  {
+    printf("Pairs per second: %.1f\n", pipeline.n_pairs / pipeline_time_taken);
+    printf("Cells per second: %.3e\n", pipeline.n_cells / pipeline_time_taken);
+  }
+  pipeline.cache.printStats();
+  AllocationCounters::print();
+  printf("Total time taken: %lf\n", program_timer.stop());
+
+  return 0;
+}
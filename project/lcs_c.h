@@ -0,0 +1,106 @@
+#ifndef _LCS_C_H_
+#define _LCS_C_H_
+
+/**
+ * C interface to liblcs.
+ *
+ * Typical use:
+ *
+ *   lcs_options options;
+ *   lcs_options_init(&options);
+ *   options.engine = LCS_ENGINE_PARALLEL;
+ *   options.n_threads = 4;
+ *
+ *   lcs_solver *solver = lcs_create(a, strlen(a), b, strlen(b), &options);
+ *   if (solver && lcs_solve(solver) == LCS_OK)
+ *   {
+ *     int length = lcs_length(solver);
+ *     ...
+ *   }
+ *   lcs_destroy(solver);
+ *
+ * None of these functions print anything.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* Status codes returned by the functions below. */
+  enum
+  {
+    LCS_OK = 0,
+    LCS_ERROR_INVALID_ARGUMENT = 1,
+    LCS_ERROR_NOT_SOLVED = 2,
+    LCS_ERROR_INTERNAL = 3,
+    LCS_ERROR_CANCELLED = 4 /* lcs_solve() was cancelled before finishing. */
+  };
+
+  /* Algorithms available to the library. */
+  typedef enum
+  {
+    LCS_ENGINE_SERIAL = 0,
+    LCS_ENGINE_PARALLEL = 1
+  } lcs_engine;
+
+  typedef struct
+  {
+    lcs_engine engine;
+    int n_threads;   /* Threads used by LCS_ENGINE_PARALLEL. */
+    int tile_width;  /* Columns per tile (0 = whole strip). */
+    int tile_height; /* Rows per tile between thread synchronizations. */
+    double time_limit; /* Seconds after which lcs_solve() is cancelled (0 = no limit). */
+  } lcs_options;
+
+  typedef struct
+  {
+    int length;          /* Length of the longest common subsequence. */
+    long long cells;     /* Number of matrix entries computed. */
+    double matrix_time;  /* Seconds spent computing the matrix. */
+    double total_time;   /* Seconds spent in lcs_solve(). */
+  } lcs_stats;
+
+  typedef struct lcs_solver lcs_solver;
+
+  /* Fills in the default options (serial engine). */
+  void lcs_options_init(lcs_options *options);
+
+  /* Creates a solver for the two sequences, which are copied. Passing NULL
+  options selects the defaults. Returns NULL on failure. */
+  lcs_solver *lcs_create(const char *sequence_a, size_t length_a,
+                         const char *sequence_b, size_t length_b,
+                         const lcs_options *options);
+
+  /* Computes the longest common subsequence. Returns LCS_ERROR_CANCELLED if
+  the solve ran past options.time_limit or lcs_cancel() was called. */
+  int lcs_solve(lcs_solver *solver);
+
+  /* Makes a running lcs_solve() on the solver stop as soon as possible. May
+  be called from any thread while lcs_solve() is running. */
+  void lcs_cancel(lcs_solver *solver);
+
+  /* Returns the length of the longest common subsequence, or -1 if the solver
+  has not been solved. */
+  int lcs_length(const lcs_solver *solver);
+
+  /* Copies the longest common subsequence into buffer as a null-terminated
+  string, truncating it to buffer_size - 1 characters. Returns the full length
+  of the subsequence, or -1 if the solver has not been solved. */
+  int lcs_subsequence(const lcs_solver *solver, char *buffer, size_t buffer_size);
+
+  /* Fills in the statistics of the last call to lcs_solve(). After a
+  cancelled solve, length is -1 and cells counts the entries computed before
+  it stopped. */
+  int lcs_get_stats(const lcs_solver *solver, lcs_stats *stats);
+
+  /* Frees the solver. Passing NULL is allowed. */
+  void lcs_destroy(lcs_solver *solver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
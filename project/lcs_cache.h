@@ -0,0 +1,286 @@
+#ifndef _LCS_CACHE_H_
+#define _LCS_CACHE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/* A cache file starts with this magic number and version, both uint32_t in
+host byte order, followed by the entries. */
+#define LCS_CACHE_MAGIC 0x4353434c // "LCSC" in little-endian memory.
+#define LCS_CACHE_VERSION 1
+
+/**
+ * @brief 128-bit hash of an input pair and the kind of result wanted.
+ */
+struct PairHash
+{
+  uint64_t low = 0;
+  uint64_t high = 0;
+
+  bool operator==(const PairHash &other) const
+  {
+    return low == other.low && high == other.high;
+  }
+};
+
+/* Hash functor so PairHash can be used as an std::unordered_map key. */
+struct PairHashHasher
+{
+  size_t operator()(const PairHash &hash) const
+  {
+    return hash.low ^ (hash.high * 0x9e3779b97f4a7c15ULL);
+  }
+};
+
+/* MurmurHash3 x64 finalizer. */
+inline uint64_t mix64(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+/* Feeds a block of bytes into a 128-bit state, 16 bytes at a time, in the
+style of MurmurHash3 x64_128. */
+inline void hashBytes(PairHash &state, const char *data, size_t n)
+{
+  const uint64_t c1 = 0x87c37b91114253d5ULL;
+  const uint64_t c2 = 0x4cf5ad432745937fULL;
+  uint64_t h1 = state.low;
+  uint64_t h2 = state.high;
+
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    uint64_t k1, k2;
+    memcpy(&k1, data + i, 8);
+    memcpy(&k2, data + i + 8, 8);
+
+    k1 *= c1;
+    k1 = (k1 << 31) | (k1 >> 33);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = (h1 << 27) | (h1 >> 37);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= c2;
+    k2 = (k2 << 33) | (k2 >> 31);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = (h2 << 31) | (h2 >> 33);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  // Remaining bytes, padded with zeros.
+  uint64_t tail[2] = {0, 0};
+  memcpy(tail, data + i, n - i);
+  h1 ^= mix64(tail[0] * c1);
+  h2 ^= mix64(tail[1] * c2);
+
+  // Include the length so "AB" + "C" and "A" + "BC" differ.
+  h1 ^= n;
+  h2 ^= n;
+  h1 += h2;
+  h2 += h1;
+  state.low = mix64(h1);
+  state.high = mix64(h2);
+}
+
+/* Hash of (sequence_a, sequence_b, mode). */
+inline PairHash hashPair(const char *sequence_a, size_t length_a,
+                         const char *sequence_b, size_t length_b,
+                         const uint32_t mode)
+{
+  PairHash hash;
+  hash.low = 0x243f6a8885a308d3ULL ^ mode;
+  hash.high = 0x13198a2e03707344ULL;
+  hashBytes(hash, sequence_a, length_a);
+  hashBytes(hash, sequence_b, length_b);
+  return hash;
+}
+
+inline PairHash hashPair(const std::string &sequence_a,
+                         const std::string &sequence_b, const uint32_t mode)
+{
+  return hashPair(sequence_a.data(), sequence_a.length(),
+                  sequence_b.data(), sequence_b.length(), mode);
+}
+
+/* Cached result of a pair. The subsequence is empty for length-only results. */
+struct CachedResult
+{
+  int length = 0;
+  std::string subsequence;
+};
+
+/**
+ * @brief Thread-safe LRU cache of LCS results keyed by the hash of their input.
+ *
+ * The cache holds at most `capacity_bytes` of results (counting the
+ * subsequences and a fixed overhead per entry) and evicts the least recently
+ * used results when it is full. It can be saved to and loaded from disk so
+ * that results survive a restart.
+ */
+class ResultCache
+{
+private:
+  /* Approximate bookkeeping cost of an entry besides its subsequence. */
+  static const size_t ENTRY_OVERHEAD = 96;
+
+  struct Entry
+  {
+    PairHash key;
+    CachedResult result;
+  };
+
+  const size_t capacity_bytes;
+  std::list<Entry> entries; // Most recently used first.
+  std::unordered_map<PairHash, std::list<Entry>::iterator, PairHashHasher> index;
+  size_t used_bytes = 0;
+  long long n_hits = 0;
+  long long n_misses = 0;
+  long long n_evictions = 0;
+  mutable std::mutex mutex;
+
+  static size_t entrySize(const CachedResult &result)
+  {
+    return ENTRY_OVERHEAD + result.subsequence.capacity();
+  }
+
+  void evict()
+  {
+    while (used_bytes > capacity_bytes && !entries.empty())
+    {
+      used_bytes -= entrySize(entries.back().result);
+      index.erase(entries.back().key);
+      entries.pop_back();
+      n_evictions++;
+    }
+  }
+
+public:
+  ResultCache(size_t capacity_bytes) : capacity_bytes(capacity_bytes) {}
+
+  /* Looks up a result. Returns false on a miss. */
+  bool get(const PairHash &key, CachedResult &result)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+      n_misses++;
+      return false;
+    }
+    n_hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    result = it->second->result;
+    return true;
+  }
+
+  /* Stores a result, replacing any previous result for the same key. */
+  void put(const PairHash &key, const CachedResult &result)
+  {
+    if (capacity_bytes == 0)
+      return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+      used_bytes -= entrySize(it->second->result);
+      entries.erase(it->second);
+    }
+    entries.push_front(Entry{key, result});
+    index[key] = entries.begin();
+    used_bytes += entrySize(result);
+    evict();
+  }
+
+  /* Writes every entry to the given file, least recently used first, so that
+  loading the file restores the same order. */
+  bool save(const std::string &path) const
+  {
+    std::ofstream out_file(path, std::ios::binary);
+    if (!out_file.is_open())
+      return false;
+
+    uint32_t magic = LCS_CACHE_MAGIC, version = LCS_CACHE_VERSION;
+    out_file.write((const char *)&magic, sizeof(magic));
+    out_file.write((const char *)&version, sizeof(version));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+    {
+      uint32_t length = it->result.length;
+      uint32_t n_bytes = it->result.subsequence.length();
+      out_file.write((const char *)&it->key, sizeof(it->key));
+      out_file.write((const char *)&length, sizeof(length));
+      out_file.write((const char *)&n_bytes, sizeof(n_bytes));
+      out_file.write(it->result.subsequence.data(), n_bytes);
+    }
+    return out_file.good();
+  }
+
+  /* Adds the entries of a file written by save(). Returns false if the file
+  could not be opened or was not written by this version of save(), in which
+  case nothing is added. */
+  bool load(const std::string &path)
+  {
+    std::ifstream in_file(path, std::ios::binary);
+    if (!in_file.is_open())
+      return false;
+
+    uint32_t magic, version;
+    if (!in_file.read((char *)&magic, sizeof(magic)) || magic != LCS_CACHE_MAGIC ||
+        !in_file.read((char *)&version, sizeof(version)) ||
+        version != LCS_CACHE_VERSION)
+    {
+      std::cerr << "Ignoring cache file in an unknown format: " << path << std::endl;
+      return false;
+    }
+
+    PairHash key;
+    uint32_t length, n_bytes;
+    while (in_file.read((char *)&key, sizeof(key)) &&
+           in_file.read((char *)&length, sizeof(length)) &&
+           in_file.read((char *)&n_bytes, sizeof(n_bytes)))
+    {
+      CachedResult result;
+      result.length = length;
+      result.subsequence.resize(n_bytes);
+      if (n_bytes > 0 && !in_file.read(&result.subsequence[0], n_bytes))
+        break;
+      put(key, result);
+    }
+    return true;
+  }
+
+  // Print hit/miss rates and memory usage.
+  void printStats() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    long long n_lookups = n_hits + n_misses;
+    double hit_rate = n_lookups > 0 ? 100.0 * n_hits / n_lookups : 0.0;
+    printf("Cache entries: %zu\n", entries.size());
+    printf("Cache hits: %lld (%.1f%%)\n", n_hits, hit_rate);
+    printf("Cache misses: %lld (%.1f%%)\n", n_misses,
+           n_lookups > 0 ? 100.0 - hit_rate : 0.0);
+    printf("Cache evictions: %lld\n", n_evictions);
+    printf("Cache memory used: %zu / %zu bytes\n", used_bytes, capacity_bytes);
+  }
+};
+
+#endif
@@ -0,0 +1,83 @@
+import os
+import socket
+import struct
+import sys
+
+"""
+Usage: python lcs_client.py <input-file> [socket-path] [--string]
+
+Sends every line of <input-file> (two sequences separated by a comma, as
+written by generate_sequences.py) to lcs_server as a single batch request and
+prints the results in the order the server streams them back.
+
+The message layout is described in lcs_protocol.h.
+"""
+
+REQUEST_MAGIC = 0x5253434c
+RESPONSE_MAGIC = 0x4153434c
+MODE_LENGTH = 0
+MODE_STRING = 1
+STATUS_CANCELLED = 2
+
+REQUEST_HEADER = struct.Struct('=IIII')
+PAIR_HEADER = struct.Struct('=II')
+RESPONSE_HEADER = struct.Struct('=IIIIII')
+
+
+def read_exactly(sock, n):
+  data = b''
+  while len(data) < n:
+    chunk = sock.recv(n - len(data))
+    if not chunk:
+      raise Exception("Error: server closed the connection.")
+    data += chunk
+  return data
+
+
+def get_pairs(input_file):
+  pairs = []
+  with open(input_file) as csv_file:
+    for line in csv_file.read().splitlines():
+      sequences = [s.strip() for s in line.split(sep=',')]
+      if len(sequences) >= 2:
+        pairs.append((sequences[0], sequences[1]))
+  return pairs
+
+
+def main():
+  args = [arg for arg in sys.argv[1:] if not arg.startswith('--')]
+  if len(args) < 1:
+    raise Exception("Error: not enough arguments. Usage: python lcs_client.py <input-file> [socket-path] [--string]")
+
+  input_file = args[0]
+  socket_path = args[1] if len(args) > 1 else '/tmp/lcs_server.sock'
+  mode = MODE_STRING if '--string' in sys.argv else MODE_LENGTH
+  pairs = get_pairs(input_file)
+
+  sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+  sock.connect(socket_path)
+
+  request = REQUEST_HEADER.pack(REQUEST_MAGIC, os.getpid(), len(pairs), mode)
+  for sequence_a, sequence_b in pairs:
+    a, b = sequence_a.encode(), sequence_b.encode()
+    request += PAIR_HEADER.pack(len(a), len(b)) + a + b
+  sock.sendall(request)
+
+  for _ in pairs:
+    magic, request_id, pair_index, status, length, n_bytes = RESPONSE_HEADER.unpack(
+      read_exactly(sock, RESPONSE_HEADER.size))
+    if magic != RESPONSE_MAGIC:
+      raise Exception("Error: bad response from server.")
+    subsequence = read_exactly(sock, n_bytes).decode() if n_bytes else ''
+    if status == STATUS_CANCELLED:
+      print(f"{pair_index}: cancelled")
+    elif status != 0:
+      print(f"{pair_index}: error")
+    else:
+      print(f"{pair_index}: {length} {subsequence}".rstrip())
+
+  sock.close()
+
+
+if __name__ == '__main__':
+  main()
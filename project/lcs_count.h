@@ -0,0 +1,135 @@
+#ifndef _LCS_COUNT_H_
+#define _LCS_COUNT_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "lcs.h"
+
+/* Default modulus of the count: the number of distinct LCSs grows
+exponentially with the length of the sequences. */
+#define LCS_COUNT_MODULUS 1000000007u
+
+/* Computes cells first_col to last_col of a row of the LCS matrix together
+with the same cells of the count matrix, from the rows above them. count_row[j]
+is the number of distinct longest common subsequences, modulo modulus, of the
+prefixes the cell covers:
+
+  a == b[j - 1]:  the LCSs of the diagonal cell, each extended by a.
+  otherwise:      those of the cells above and to the left that are as long
+                  as this one; a subsequence that is an LCS of both is also
+                  one of the diagonal cell, so those are subtracted once. */
+inline void computeCountedRow(const char a, const char *b, const int *above,
+                              int *row, const uint32_t *count_above,
+                              uint32_t *count_row, const int first_col,
+                              const int last_col, const uint32_t modulus)
+{
+  for (int col = first_col; col <= last_col; col++)
+  {
+    const int diagonal = above[col - 1];
+    if (a == b[col - 1])
+    {
+      row[col] = diagonal + 1;
+      count_row[col] = count_above[col - 1];
+      continue;
+    }
+    const int top = above[col], left = row[col - 1];
+    const int current = std::max(top, left);
+    // Every count is below modulus, so a subtraction reduces each step
+    // without a division.
+    uint64_t count = (top == current ? count_above[col] : 0) +
+                     (left == current ? (uint64_t)count_row[col - 1] : 0);
+    if (count >= modulus)
+      count -= modulus;
+    if (diagonal == current)
+    {
+      const uint32_t both = count_above[col - 1];
+      count = count >= both ? count - both : count + modulus - both;
+    }
+    row[col] = current;
+    count_row[col] = count;
+  }
+}
+
+/**
+ * @brief An LCS engine that also counts the distinct LCSs.
+ *
+ * LongestCommonSubsequenceCounted<Engine> is the engine (the serial or
+ * parallel solver) with a second matrix of counts beside its matrix of
+ * lengths. computeRow() fills a row segment of both, so the counts follow the
+ * engine's own tiles and strips and cost no second pass over the matrix.
+ *
+ * Two alignments that match the same characters are one subsequence, so this
+ * counts strings, not paths through the matrix. The count is kept modulo a
+ * 32-bit modulus; the exact number can have as many digits as the sequences
+ * have characters.
+ */
+template <class Engine>
+class LongestCommonSubsequenceCounted : public Engine
+{
+protected:
+  const uint32_t modulus;
+  std::vector<uint32_t> count_cells;
+  std::vector<uint32_t *> counts; // counts[i][j] beside matrix[i][j].
+
+  virtual void computeRow(const int row, const int first_col, const int last_col) override
+  {
+    computeCountedRow(this->sequence_a[row - 1], this->sequence_b.data,
+                      this->matrix[row - 1], this->matrix[row], counts[row - 1],
+                      counts[row], first_col, last_col, modulus);
+  }
+
+  // The counts depend on every cell, so no row may be left unfilled.
+  virtual bool tracesUnfilledRows() const override
+  {
+    return false;
+  }
+
+public:
+  /* The remaining arguments are passed on to the engine's constructor. */
+  template <class... Args>
+  LongestCommonSubsequenceCounted(const uint32_t modulus, Args &&...args)
+      : Engine(std::forward<Args>(args)...), modulus(modulus)
+  {
+    // The empty subsequence is the only LCS of an empty prefix, so the top
+    // row and left column are all 1s.
+    count_cells.assign((size_t)this->matrix_height * this->matrix_width, 1 % modulus);
+    counts.resize(this->matrix_height);
+    for (int i = 0; i < this->matrix_height; i++)
+    {
+      counts[i] = count_cells.data() + (size_t)i * this->matrix_width;
+    }
+  }
+
+  // Returns the number of distinct LCSs, modulo getCountModulus().
+  uint32_t getLCSCount() const
+  {
+    return counts[this->matrix_height - 1][this->matrix_width - 1];
+  }
+
+  uint32_t getCountModulus() const
+  {
+    return modulus;
+  }
+
+  virtual void printLCSLength() override
+  {
+    Engine::printLCSLength();
+    std::cout << "Number of distinct longest common subsequences (mod " << modulus
+              << "): " << getLCSCount() << "\n";
+  }
+};
+
+/* Creates the engine with a count matrix, passing the remaining arguments on
+to its constructor. */
+template <class Engine, class... Args>
+std::unique_ptr<Engine> makeCountedSolver(const uint32_t modulus, Args &&...args)
+{
+  return std::unique_ptr<Engine>(
+      new LongestCommonSubsequenceCounted<Engine>(modulus, std::forward<Args>(args)...));
+}
+
+#endif
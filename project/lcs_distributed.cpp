@@ -1,11 +1,79 @@
 
 
 #include <algorithm> // std::max, std::min
+#include <atomic>
+#include <deque>
+#include <glob.h>
 #include <iostream>
 #include <mpi.h>
+#include <new>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
 
 #include "cxxopts.hpp"
 #include "lcs.h"
+#include "lcs_output.h"
+#include "lcs_scored.h"
+#include "tuning.h"
+
+/* Tag used for the boundary column messages sent between neighbors. */
+#define BOUNDARY_TAG 0
+/* Tag used for the progress messages sent to the root process. */
+#define PROGRESS_TAG 1
+
+/* How the boundary column values travel from a rank to its right neighbor. */
+enum LCSBoundaryExchange
+{
+  BOUNDARY_EXCHANGE_SEND,  // A matched MPI_Send and MPI_Recv per block of rows.
+  BOUNDARY_EXCHANGE_RMA,   // An MPI_Put into the neighbor's window per block.
+  BOUNDARY_EXCHANGE_SHARED // A store into the neighbor's shared memory on the
+                           // same node, and messages between nodes.
+};
+
+/* Parses the value of --boundary_exchange. Returns false if it is unknown. */
+bool parseBoundaryExchange(const std::string &name, LCSBoundaryExchange &exchange)
+{
+  if (name == "send")
+    exchange = BOUNDARY_EXCHANGE_SEND;
+  else if (name == "rma")
+    exchange = BOUNDARY_EXCHANGE_RMA;
+  else if (name == "shared")
+    exchange = BOUNDARY_EXCHANGE_SHARED;
+  else
+    return false;
+  return true;
+}
+
+const char *boundaryExchangeName(const LCSBoundaryExchange exchange)
+{
+  switch (exchange)
+  {
+  case BOUNDARY_EXCHANGE_RMA:
+    return "rma";
+  case BOUNDARY_EXCHANGE_SHARED:
+    return "shared";
+  default:
+    return "send";
+  }
+}
+
+/* Flag sent after the boundary values of a block of rows: the sender was
+cancelled, or the block's last row is to be saved in a checkpoint. */
+enum BoundaryFlag
+{
+  BOUNDARY_CONTINUE = 0,
+  BOUNDARY_STOP = 1,
+  BOUNDARY_CHECKPOINT = 2,
+};
+
+/* The block count in a boundary window is the number of blocks put there, n,
+or -(n + 1) once the sender has been cancelled. Returns n. */
+inline int decodeBlockCount(const int count, bool &stopped)
+{
+  stopped = count < 0;
+  return stopped ? -count - 1 : count;
+}
 
 /**
  * If the specific longest common subsequence is required, then the sub-matrices
@@ -30,42 +98,524 @@ protected:
   int *sub_str_widths;
   std::string global_sequence_b;
 
-  virtual void computeCell(const int row, const int col)
+  /* Number of rows whose boundary values are exchanged in a single message. */
+  const int block_height;
+  /* Staging buffer for the boundary column values of one block of rows,
+  followed by a BoundaryFlag. */
+  std::vector<int> boundary_buffer;
+  /* Whether the block of rows being filled ends with a checkpoint. The root
+  process decides with its timer, and the flag is passed on with the boundary
+  values, so every rank saves the same rows. */
+  bool checkpoint_block = false;
+  /* Last row completed by the main fill on this rank. */
+  int completed_rows = 0;
+
+  LCSBoundaryExchange boundary_exchange = BOUNDARY_EXCHANGE_SEND;
+  /* With BOUNDARY_EXCHANGE_RMA or BOUNDARY_EXCHANGE_SHARED, every rank
+  exposes a window of its left boundary column, one value per row, followed
+  by the block count (see decodeBlockCount()) of its left neighbor, then by
+  one checkpoint mark per row, set at the first row of a block that ends with
+  a checkpoint. */
+  MPI_Win boundary_window = MPI_WIN_NULL;
+  int *window_values = nullptr;
+  int blocks_sent = 0;
+  int blocks_received = 0;
+
+  /* With BOUNDARY_EXCHANGE_SHARED, the window is shared by the ranks of a
+  node, and a neighbor on the same node is written to and read from directly.
+  The count is an atomic in the window, so that it is stored after the
+  values. */
+  MPI_Comm node_comm = MPI_COMM_NULL;
+  int ranks_per_node = 0; // If positive, a node is split into groups of ranks.
+  bool left_shared = false;  // The left neighbor is on this node.
+  bool right_shared = false; // The right neighbor is on this node.
+  int *right_window_values = nullptr;
+  std::atomic<int> *window_count = nullptr;
+  std::atomic<int> *right_window_count = nullptr;
+
+  /* Returns the rank in node_comm of a rank of MPI_COMM_WORLD, or
+  MPI_UNDEFINED if it is on another node. */
+  int nodeRank(const int rank) const
+  {
+    MPI_Group world_group, node_group;
+    MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+    MPI_Comm_group(node_comm, &node_group);
+    int node_rank;
+    MPI_Group_translate_ranks(world_group, 1, &rank, node_group, &node_rank);
+    MPI_Group_free(&world_group);
+    MPI_Group_free(&node_group);
+    return node_rank;
+  }
+
+  int windowSize() const { return 2 * matrix_height + 1; }
+  int markSlot(const int block_start) const { return matrix_height + 1 + block_start; }
+
+  /* Groups the ranks by node and allocates their windows in memory that
+  the ranks of a node share, then finds the window of the right neighbor if
+  it is on the same node. */
+  void openSharedWindow()
   {
-    int comm_value;
-    /* If we are computing a cell in the leftmost column of our local matrix,
-      then we need to get data from the cells in the rightmost column of our
-      neighboring process to the left. Unless we are the leftmost process. */
-    if (col == 1 && world_rank != 0)
+    static_assert(sizeof(std::atomic<int>) == sizeof(int),
+                  "The block count must fit in the window.");
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, world_rank,
+                        MPI_INFO_NULL, &node_comm);
+    if (ranks_per_node > 0)
     {
-      MPI_Recv(
-          &comm_value,
-          1, // Only need a single value.
-          MPI_UNSIGNED,
-          world_rank - 1, // Source: Get from neighbor to the left.
-          row,            // Tag: Row index.
-          MPI_COMM_WORLD,
-          MPI_STATUS_IGNORE);
-      // Store the value in the local matrix.
-      matrix[row][col - 1] = comm_value;
+      MPI_Comm whole_node = node_comm;
+      MPI_Comm_split(whole_node, world_rank / ranks_per_node, world_rank, &node_comm);
+      MPI_Comm_free(&whole_node);
     }
+    // Each rank's part may then be placed in memory close to it.
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+    MPI_Win_allocate_shared((MPI_Aint)windowSize() * sizeof(int), sizeof(int),
+                            info, node_comm, &window_values, &boundary_window);
+    MPI_Info_free(&info);
+    window_count = new (&window_values[matrix_height]) std::atomic<int>(0);
 
-    LongestCommonSubsequence::computeCell(row, col);
+    left_shared = world_rank > 0 && nodeRank(world_rank - 1) != MPI_UNDEFINED;
+    right_shared = world_rank < world_size - 1 &&
+                   nodeRank(world_rank + 1) != MPI_UNDEFINED;
+    if (right_shared)
+    {
+      MPI_Aint size;
+      int disp_unit;
+      MPI_Win_shared_query(boundary_window, nodeRank(world_rank + 1), &size,
+                           &disp_unit, &right_window_values);
+      right_window_count =
+          reinterpret_cast<std::atomic<int> *>(&right_window_values[matrix_height]);
+    }
+  }
 
-    /* If we are computing a cell in the rightmost column of our local
-    matrix, we must send the results to our neighbor to the right once we
-    are done. Unless we are the rightmost process. */
-    if (col == matrix_width - 1 && world_rank != world_size - 1)
+  /* Creates the boundary window and opens a passive target epoch on every
+  rank for the whole fill. Collective. */
+  void openBoundaryWindow()
+  {
+    blocks_sent = blocks_received = 0;
+    if (boundary_exchange == BOUNDARY_EXCHANGE_SEND)
+      return;
+    if (boundary_exchange == BOUNDARY_EXCHANGE_SHARED)
     {
-      comm_value = matrix[row][col];
-      MPI_Send(
-          &comm_value,
-          1,
-          MPI_UNSIGNED,
-          world_rank + 1, // Destination: Send to neighbor to the right.
-          row,
-          MPI_COMM_WORLD);
+      openSharedWindow();
+    }
+    else
+    {
+      MPI_Win_allocate((MPI_Aint)windowSize() * sizeof(int), sizeof(int),
+                       MPI_INFO_NULL, MPI_COMM_WORLD, &window_values, &boundary_window);
+      window_values[matrix_height] = 0;
+    }
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, boundary_window);
+    MPI_Win_sync(boundary_window);
+    // No neighbor may put a block before the count is reset.
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  /* Closes the epoch and frees the window. Collective. */
+  void closeBoundaryWindow()
+  {
+    if (boundary_window == MPI_WIN_NULL)
+      return;
+    MPI_Win_unlock_all(boundary_window);
+    MPI_Win_free(&boundary_window);
+    window_values = right_window_values = nullptr;
+    window_count = right_window_count = nullptr;
+    left_shared = right_shared = false;
+    if (node_comm != MPI_COMM_NULL)
+      MPI_Comm_free(&node_comm);
+  }
+
+  /* Copies a block of rows from our window into the left column of the
+  matrix, and reads its checkpoint mark. */
+  void readWindowBlock(const int block_start, const int n_rows)
+  {
+    for (int i = 0; i < n_rows; i++)
+    {
+      matrix[block_start + i][0] = window_values[block_start + i];
     }
+    checkpoint_block = window_values[markSlot(block_start)];
+  }
+
+  /* Waits until the left neighbor has put the next block of rows into our
+  window, polling the count atomically, and copies the block into the left
+  column of the matrix. Returns false if the neighbor was cancelled before
+  putting the block. The blocks it put before that are still received, so
+  every rank stops at the same block, as with messages. */
+  bool receiveBoundaryRMA(const int block_start, const int n_rows)
+  {
+    int count, n_blocks;
+    bool stopped;
+    do
+    {
+      MPI_Fetch_and_op(NULL, &count, MPI_INT, world_rank, matrix_height,
+                       MPI_NO_OP, boundary_window);
+      MPI_Win_flush(world_rank, boundary_window);
+      n_blocks = decodeBlockCount(count, stopped);
+    } while (!stopped && n_blocks <= blocks_received);
+    if (n_blocks <= blocks_received)
+      return false;
+    blocks_received++;
+    // The values were put before the count, so they are in the window.
+    MPI_Win_sync(boundary_window);
+    readWindowBlock(block_start, n_rows);
+    return true;
+  }
+
+  /* The same for a left neighbor on this node, which stores the block into
+  our part of the shared window itself. The count is read without MPI calls,
+  yielding to the other ranks of the node while it has not gone up. */
+  bool receiveBoundaryShared(const int block_start, const int n_rows)
+  {
+    int n_blocks;
+    bool stopped;
+    while (true)
+    {
+      n_blocks = decodeBlockCount(window_count->load(std::memory_order_acquire), stopped);
+      if (stopped || n_blocks > blocks_received)
+        break;
+      std::this_thread::yield();
+    }
+    if (n_blocks <= blocks_received)
+      return false;
+    blocks_received++;
+    MPI_Win_sync(boundary_window);
+    readWindowBlock(block_start, n_rows);
+    return true;
+  }
+
+  /* Stores a block of rows of our right column straight into the part of the
+  shared window of a right neighbor on this node, then its count. */
+  void sendBoundaryShared(const int block_start, const int n_rows, const bool stop)
+  {
+    if (!stop)
+    {
+      for (int i = 0; i < n_rows; i++)
+      {
+        right_window_values[block_start + i] = matrix[block_start + i][matrix_width - 1];
+      }
+      right_window_values[markSlot(block_start)] = checkpoint_block;
+      MPI_Win_sync(boundary_window);
+    }
+    right_window_count->store(stop ? -blocks_sent - 1 : ++blocks_sent,
+                              std::memory_order_release);
+  }
+
+  /* Puts a block of rows of our right column into the window of the right
+  neighbor, then raises its count of blocks, or marks the count to stop. The
+  flush between them makes sure the values arrive before the count does. */
+  void sendBoundaryRMA(const int block_start, const int n_rows, const bool stop)
+  {
+    const int neighbor = world_rank + 1;
+    if (!stop)
+    {
+      for (int i = 0; i < n_rows; i++)
+      {
+        boundary_buffer[i] = matrix[block_start + i][matrix_width - 1];
+      }
+      boundary_buffer[n_rows] = checkpoint_block;
+      MPI_Put(boundary_buffer.data(), n_rows, MPI_INT, neighbor, block_start, n_rows,
+              MPI_INT, boundary_window);
+      MPI_Put(&boundary_buffer[n_rows], 1, MPI_INT, neighbor, markSlot(block_start), 1,
+              MPI_INT, boundary_window);
+      MPI_Win_flush(neighbor, boundary_window);
+    }
+    int n_blocks = stop ? -blocks_sent - 1 : ++blocks_sent;
+    MPI_Accumulate(&n_blocks, 1, MPI_INT, neighbor, matrix_height, 1, MPI_INT,
+                   MPI_REPLACE, boundary_window);
+    MPI_Win_flush(neighbor, boundary_window);
+  }
+
+  /* If we are about to compute a block of rows, then we need the values in the
+  rightmost column of our neighboring process to the left for those rows.
+  Unless we are the leftmost process.
+
+  Only the root process polls its cancellation token. It tells its neighbor
+  to stop by setting the flag after the boundary values, and every rank passes
+  the flag on, so the ranks stop one after the other, each at the block it
+  was about to compute, and no boundary message is left unreceived. The flag
+  also carries the root's checkpoint decision for the block (see
+  checkpoint_block). Returns false if the solve was cancelled. */
+  bool receiveBoundary(const int block_start, const int n_rows)
+  {
+    if (world_rank == 0)
+      return !cancellationRequested();
+    if (boundary_exchange == BOUNDARY_EXCHANGE_RMA)
+      return receiveBoundaryRMA(block_start, n_rows);
+    if (left_shared)
+      return receiveBoundaryShared(block_start, n_rows);
+
+    MPI_Recv(
+        boundary_buffer.data(),
+        n_rows + 1,
+        MPI_INT,
+        world_rank - 1, // Source: Get from neighbor to the left.
+        BOUNDARY_TAG,   // Messages between a pair of ranks arrive in order.
+        MPI_COMM_WORLD,
+        MPI_STATUS_IGNORE);
+    if (boundary_buffer[n_rows] == BOUNDARY_STOP)
+      return false;
+    checkpoint_block = boundary_buffer[n_rows] == BOUNDARY_CHECKPOINT;
+    // Store the values in the leftmost column of the local matrix.
+    for (int i = 0; i < n_rows; i++)
+    {
+      matrix[block_start + i][0] = boundary_buffer[i];
+    }
+    return true;
+  }
+
+  /* Once a block of rows is done, we must send the values in our rightmost
+  column to our neighbor to the right. Unless we are the rightmost process.
+  A cancelled rank sends the flag instead of the values. */
+  void sendBoundary(const int block_start, const int n_rows, const bool stop = false)
+  {
+    if (world_rank == world_size - 1)
+      return;
+    if (boundary_exchange == BOUNDARY_EXCHANGE_RMA)
+    {
+      sendBoundaryRMA(block_start, n_rows, stop);
+      return;
+    }
+    if (right_shared)
+    {
+      sendBoundaryShared(block_start, n_rows, stop);
+      return;
+    }
+
+    for (int i = 0; i < n_rows && !stop; i++)
+    {
+      boundary_buffer[i] = matrix[block_start + i][matrix_width - 1];
+    }
+    boundary_buffer[n_rows] = stop               ? BOUNDARY_STOP
+                              : checkpoint_block ? BOUNDARY_CHECKPOINT
+                                                 : BOUNDARY_CONTINUE;
+    MPI_Send(
+        boundary_buffer.data(),
+        n_rows + 1,
+        MPI_INT,
+        world_rank + 1, // Destination: Send to neighbor to the right.
+        BOUNDARY_TAG,
+        MPI_COMM_WORLD);
+  }
+
+  /* Progress reporting. Every rank sends its last completed row to the root
+  process at most once per progress interval, as {row, done} pairs. */
+  Timer progress_timer;
+  int progress_message[2];
+  MPI_Request progress_request = MPI_REQUEST_NULL;
+  std::vector<int> rank_rows; // Root only: last row reported by each rank.
+  long long start_cells = 0;  // Root only: cells done when reporting began.
+
+  long long completedCells() const
+  {
+    long long n_cells = 0;
+    for (int rank = 0; rank < world_size; rank++)
+    {
+      n_cells += (long long)rank_rows[rank] * sub_str_widths[rank];
+    }
+    return n_cells;
+  }
+
+  void printProgressLine()
+  {
+    printProgress(stderr, completedCells(),
+                  (long long)length_a * global_sequence_b.length(), start_cells,
+                  matrix_timer.stop());
+  }
+
+  /* Called by every rank after each block of the fill. Non-root ranks send
+  without waiting, and skip a report if the previous one is still in flight.
+  The root process picks up whatever has arrived without blocking. */
+  void reportProgress(const int row)
+  {
+    if (world_rank != 0)
+    {
+      if (progress_timer.stop() < progress_interval)
+        return;
+      int done = 1;
+      MPI_Test(&progress_request, &done, MPI_STATUS_IGNORE);
+      if (done)
+      {
+        progress_message[0] = row;
+        progress_message[1] = 0;
+        MPI_Isend(progress_message, 2, MPI_INT, 0, PROGRESS_TAG, MPI_COMM_WORLD,
+                  &progress_request);
+        progress_timer.start();
+      }
+      return;
+    }
+
+    rank_rows[0] = row;
+    int arrived = 1;
+    while (arrived)
+    {
+      MPI_Status status;
+      MPI_Iprobe(MPI_ANY_SOURCE, PROGRESS_TAG, MPI_COMM_WORLD, &arrived, &status);
+      if (arrived)
+      {
+        MPI_Recv(progress_message, 2, MPI_INT, status.MPI_SOURCE, PROGRESS_TAG,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        rank_rows[status.MPI_SOURCE] = progress_message[0];
+      }
+    }
+    if (progress_timer.stop() >= progress_interval)
+    {
+      printProgressLine();
+      progress_timer.start();
+    }
+  }
+
+  /* Called by every rank once its part of the fill is complete or has been
+  cancelled. The root process keeps reporting until every rank has said it is
+  done. */
+  void finishProgress()
+  {
+    if (world_rank != 0)
+    {
+      MPI_Wait(&progress_request, MPI_STATUS_IGNORE);
+      progress_message[0] = completed_rows;
+      progress_message[1] = 1;
+      MPI_Send(progress_message, 2, MPI_INT, 0, PROGRESS_TAG, MPI_COMM_WORLD);
+      return;
+    }
+
+    rank_rows[0] = completed_rows;
+    int n_running = world_size - 1;
+    while (n_running > 0)
+    {
+      MPI_Status status;
+      MPI_Recv(progress_message, 2, MPI_INT, MPI_ANY_SOURCE, PROGRESS_TAG,
+               MPI_COMM_WORLD, &status);
+      rank_rows[status.MPI_SOURCE] = progress_message[0];
+      n_running -= progress_message[1];
+      if (progress_timer.stop() >= progress_interval)
+      {
+        printProgressLine();
+        progress_timer.start();
+      }
+    }
+  }
+
+  /* Rows of this rank's checkpoint files that are still on disk. */
+  std::vector<int> checkpoint_rows;
+  /* Row that every rank has most recently saved, or -1. */
+  int last_saved_row = -1;
+
+  /* After each checkpoint, the ranks find out with a non-blocking reduction
+  which rows every rank has saved, without waiting for each other. */
+  struct PendingReduction
+  {
+    MPI_Request request;
+    int saved_row;
+    int common_row;
+  };
+  std::deque<PendingReduction> pending_reductions;
+
+  /* Each rank saves its checkpoints to its own files, one per row. */
+  std::string checkpointPath(const int row) const
+  {
+    return checkpoint_path + ".rank" + std::to_string(world_rank) + ".row" +
+           std::to_string(row);
+  }
+
+  /* Deletes this rank's checkpoints of rows above the given row. */
+  void removeCheckpointsBefore(const int row)
+  {
+    std::vector<int> kept_rows;
+    for (int checkpoint_row : checkpoint_rows)
+    {
+      if (checkpoint_row < row)
+        remove(checkpointPath(checkpoint_row).c_str());
+      else
+        kept_rows.push_back(checkpoint_row);
+    }
+    checkpoint_rows = kept_rows;
+  }
+
+  /* Checks the reductions started so far, and once every rank has saved a
+  row, deletes the older checkpoints, which are no longer needed to resume. */
+  void pruneCheckpoints(const bool wait)
+  {
+    while (!pending_reductions.empty())
+    {
+      int done = 1;
+      if (wait)
+        MPI_Wait(&pending_reductions.front().request, MPI_STATUS_IGNORE);
+      else
+        MPI_Test(&pending_reductions.front().request, &done, MPI_STATUS_IGNORE);
+      if (!done)
+        break;
+      removeCheckpointsBefore(pending_reductions.front().common_row);
+      pending_reductions.pop_front();
+    }
+  }
+
+  /* Saves row `row` of the local matrix, including the boundary column. The
+  ranks reach the same rows in the same order, so every rank saves the same
+  rows and the files of one row together form a consistent frontier. */
+  void saveRowCheckpoint(const int row)
+  {
+    Checkpoint checkpoint = emptyCheckpoint();
+    checkpoint.strips.push_back(snapshotStrip(0, matrix_width - 1, row, row + 1));
+    if (checkpoint.save(checkpointPath(row)))
+    {
+      checkpoint_rows.push_back(row);
+      last_saved_row = row;
+    }
+    else
+    {
+      std::cerr << "Error writing checkpoint: " << checkpointPath(row) << std::endl;
+    }
+
+    pending_reductions.emplace_back();
+    PendingReduction &reduction = pending_reductions.back();
+    reduction.saved_row = last_saved_row;
+    MPI_Iallreduce(&reduction.saved_row, &reduction.common_row, 1, MPI_INT,
+                   MPI_MIN, MPI_COMM_WORLD, &reduction.request);
+    pruneCheckpoints(false);
+  }
+
+  virtual bool checkpointFits(const Checkpoint &checkpoint) const override
+  {
+    return checkpoint.strips.size() == 1 &&
+           stripFits(checkpoint.strips[0], 0, matrix_width - 1);
+  }
+
+  /* The match runs are passed along during the traceback, as a count
+  followed by (i, j, length) triples. */
+  void sendMatchRuns(const int destination)
+  {
+    int n_runs = match_runs.size();
+    MPI_Send(&n_runs, 1, MPI_INT, destination, 0, MPI_COMM_WORLD);
+    MPI_Send(match_runs.data(), 3 * n_runs, MPI_INT, destination, 0,
+             MPI_COMM_WORLD);
+  }
+
+  void receiveMatchRuns(const int source)
+  {
+    int n_runs;
+    MPI_Recv(&n_runs, 1, MPI_INT, source, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    match_runs.resize(n_runs);
+    MPI_Recv(match_runs.data(), 3 * n_runs, MPI_INT, source, 0, MPI_COMM_WORLD,
+             MPI_STATUS_IGNORE);
+  }
+
+  /* So is the edit script, still reversed, so that the next process carries
+  on with the run the path was in when it crossed over. */
+  void sendEditRuns(const int destination)
+  {
+    int n_runs = edit_runs.size();
+    MPI_Send(&n_runs, 1, MPI_INT, destination, 0, MPI_COMM_WORLD);
+    MPI_Send(edit_runs.data(), n_runs * sizeof(EditRun), MPI_BYTE, destination, 0,
+             MPI_COMM_WORLD);
+  }
+
+  void receiveEditRuns(const int source)
+  {
+    int n_runs;
+    MPI_Recv(&n_runs, 1, MPI_INT, source, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    edit_runs.resize(n_runs);
+    MPI_Recv(edit_runs.data(), n_runs * sizeof(EditRun), MPI_BYTE, source, 0,
+             MPI_COMM_WORLD, MPI_STATUS_IGNORE);
   }
 
   virtual void determineLongestSubsequenceLength()
@@ -96,163 +646,264 @@ protected:
     }
   }
 
-  /* Broadcast the length of the LCS from the rightmost process to every other
-  process.*/
-  void broadcastLCSLength()
+  /* Finds the cell the traceback starts from, and the score of the
+  alignment, on every process. Returns the rank of the process holding the
+  cell: the rightmost process, whose bottom-right entry is the score, unless
+  the alignment is local, when it is the process with the largest entry. */
+  int findTracebackStart(int &row, int &col)
   {
-    if (world_rank == world_size - 1)
+    int local_best = tracebackStart(row, col);
+    if (!localAlignment())
     {
-      lcs_length = LongestCommonSubsequence::getLongestSubsequenceLength();
+      score = local_best;
+      MPI_Bcast(&score, 1, MPI_INT, world_size - 1, MPI_COMM_WORLD);
+      return world_size - 1;
     }
-
-    MPI_Bcast(&lcs_length, 1, MPI_INT, world_size - 1, MPI_COMM_WORLD);
+    int best[2] = {local_best, world_rank}, global_best[2];
+    MPI_Allreduce(best, global_best, 1, MPI_2INT, MPI_MAXLOC, MPI_COMM_WORLD);
+    score = global_best[0];
+    return global_best[1];
   }
 
   virtual void determineLongestCommonSubsequence() override
   {
-    /* Each process will need to know the length of the LCS so that it can
-    allocate the necessary buffer space. */
-    broadcastLCSLength();
-
-    char *lcs_buffer;
-    lcs_buffer = new char[lcs_length + 1];
-    lcs_buffer[lcs_length] = '\0';
-    int index = lcs_length - 1;
+    int row, col;
+    int start_rank = findTracebackStart(row, col);
+    match_runs.clear();
+    edit_runs.clear();
 
-    int comm_buffer[2]; // Used to transmit row index and LCS string index.
-    int row = matrix_height - 1;
-    /* Each process except the rightmost will have to wait for its neighbor to
-    the right to finish. */
+    /* Where the path is, in global coordinates, and whether it has ended:
+    at the top row, or where a local alignment starts. */
+    int position[3] = {row, column_offset + col, 0};
+    if (world_rank == start_rank)
+    {
+      // Whatever follows the start is deleted from A and inserted from B.
+      prependEdit(edit_runs, 'I', (int)global_sequence_b.length() - position[1]);
+      prependEdit(edit_runs, 'D', length_a - row);
+    }
 
-    if (world_rank != world_size - 1)
+    /* The processes to the right of where the traceback starts take no part.
+    Every other process except the one it starts on will have to wait for its
+    neighbor to the right to finish. */
+    if (world_rank < start_rank)
     {
-      /* Rightside neighbor must tell us which row to start at. */
+      /* Rightside neighbor must tell us where the path is. */
       MPI_Recv(
-          &comm_buffer,
-          2,
+          position,
+          3,
           MPI_INT,
           world_rank + 1,
           0,
           MPI_COMM_WORLD,
           MPI_STATUS_IGNORE);
-      row = comm_buffer[0];
-      index = comm_buffer[1];
 
-      /* Next, the process needs to receive the partially completed LCS from
-      the neighbor to the right. */
-      MPI_Recv(
-          lcs_buffer,
-          lcs_length,
-          MPI_CHAR,
-          world_rank + 1,
-          0,
-          MPI_COMM_WORLD,
-          MPI_STATUS_IGNORE);
+      /* And the match runs and edits found so far, which are in global
+      coordinates. */
+      receiveMatchRuns(world_rank + 1);
+      receiveEditRuns(world_rank + 1);
+
+      /* Once we have acquired the necessary data from our neighbor, we can
+      continue the trace. Always starting from the rightmost column. */
+      row = position[0];
+      col = matrix_width - 1;
     }
 
-    /* Once we have acquired the necessary data from our neighbor, we can
-    continue the trace. Always starting from the leftmost column. */
-    int col = matrix_width - 1;
+    if (world_rank <= start_rank)
+    {
+      bool ended = position[2];
+      bool traced_unfilled = false;
+      while (!ended && row > 0 && col > 0)
+      {
+        // Above the checkpoint of a resumed solve, this rank aligns what is
+        // left of both sequences, and the path ends at the top-left corner.
+        if (!tracebackStepFilled(row, col))
+        {
+          traceUnfilledRows(sequence_a, global_sequence_b, row, column_offset + col);
+          traced_unfilled = ended = true;
+          break;
+        }
+        TracebackMove move = tracebackStep(row, col);
+        if (move == TRACEBACK_STOP)
+        {
+          ended = true;
+          break;
+        }
+        prependEdit(edit_runs, editOp(move));
+        if (move == TRACEBACK_MATCH)
+        {
+          prependMatch(match_runs, row, column_offset + col);
+        }
+      }
+      if (!position[2])
+      {
+        position[0] = traced_unfilled ? 0 : row;
+        position[1] = traced_unfilled ? 0 : column_offset + col;
+        position[2] = ended || row == 0;
+      }
 
-    int current, top, left, top_left;
-    top = left = top_left = 0;
+      /* Once this process has finished tracing its sub-matrix, pass the work
+      on to the next process. */
+      if (world_rank > 0)
+      {
+        MPI_Send(
+            position,
+            3,
+            MPI_INT,
+            world_rank - 1,
+            0,
+            MPI_COMM_WORLD);
 
-    while (row > 0 && col > 0 && index >= 0)
-    {
-      current = matrix[row][col];
-      top_left = matrix[row - 1][col - 1];
-      top = matrix[row - 1][col];
-      left = matrix[row][col - 1];
+        sendMatchRuns(world_rank - 1);
+        sendEditRuns(world_rank - 1);
+      }
+    }
 
-      if (top_left == current)
+    /* Every row is on every process, so the root process reads the
+    subsequence off the match runs. */
+    if (world_rank == 0)
+    {
+      // And so is whatever precedes the end of the path.
+      prependEdit(edit_runs, 'I', position[1]);
+      prependEdit(edit_runs, 'D', position[0]);
+      std::reverse(edit_runs.begin(), edit_runs.end());
+      std::reverse(match_runs.begin(), match_runs.end());
+      longest_common_subsequence.clear();
+      for (const MatchRun &run : match_runs)
       {
-        // Go to entry to the top-left.
-        row--;
-        col--;
-        continue;
+        longest_common_subsequence.append(sequence_a.data + run.i, run.length);
       }
+      orientMatchRuns();
+      lcs_length = longest_common_subsequence.length();
+    }
+    MPI_Bcast(&lcs_length, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  }
 
-      /* If the elements above, to the left, and diagonally to the top left
-      are all the same,  */
-      if (top_left == top && top_left == left)
+  /* Fills rows first_row to end_row - 1, one block of rows at a time, until
+  the fill is complete or cancelled. The main fill also reports progress and
+  saves checkpoints, if enabled: the root process checks its timer at the
+  start of each block, and once checkpoint_interval seconds have passed, every
+  rank saves the last row of that block. */
+  void fillRows(const int first_row, const int end_row, const bool main_fill)
+  {
+    bool checkpoints = main_fill && checkpoint_path != "";
+    Timer checkpoint_timer;
+    checkpoint_timer.start();
+    for (int block_start = first_row; block_start < end_row;
+         block_start += block_height)
+    {
+      int n_rows = std::min(block_height, end_row - block_start);
+      checkpoint_block = false;
+      if (world_rank == 0 && checkpoints &&
+          checkpoint_timer.stop() >= checkpoint_interval)
+      {
+        checkpoint_block = true;
+        checkpoint_timer.start();
+      }
+      if (!receiveBoundary(block_start, n_rows))
+      {
+        cancelled = true;
+        sendBoundary(block_start, n_rows, true);
+        return;
+      }
+      for (int row = block_start; row < block_start + n_rows; row++)
       {
-        lcs_buffer[index] = sequence_a[row - 1];
-        index--;
-        // Go to entry to the top-left.
-        row--;
-        col--;
-        continue;
+        computeRow(row, 1, matrix_width - 1);
       }
+      sendBoundary(block_start, n_rows);
 
-      /* If the entry to the top left is lower than the current entry but is not
-      equal to the entries above and to the left, then either the one above or
-      the one to the left must be the same as the current. */
-      if (top == current)
+      int last_row = block_start + n_rows - 1;
+      if (main_fill)
       {
-        // Go to the entry above.
-        row--;
-        continue;
+        completed_rows = last_row;
       }
-      else
+      if (main_fill && progress_interval > 0.0)
+      {
+        reportProgress(last_row);
+      }
+      if (checkpoints && checkpoint_block)
       {
-        // If it wasn't the one above, it must be the one to the left.
-        col--;
+        saveRowCheckpoint(last_row);
       }
     }
+  }
+
+  void solveDistributed()
+  {
+    matrix_timer.start();
 
-    /* Once this process has finished tracing its sub-matrix, pass the work on
-    to the next process. */
-    if (world_rank > 0)
+    // Continue from the row saved in the checkpoint, if resuming.
+    int first_row = 1;
+    if (resuming)
     {
-      comm_buffer[0] = row;
-      comm_buffer[1] = index;
-      MPI_Send(
-          &comm_buffer,
-          2,
-          MPI_INT,
-          world_rank - 1,
-          0,
-          MPI_COMM_WORLD);
+      restoreStrip(resume_checkpoint.strips[0]);
+      first_row = resume_checkpoint.strips[0].row + 1;
+      resuming = false;
+    }
+    cancelled = false;
+    completed_rows = first_row - 1;
 
-      MPI_Send(
-          lcs_buffer,
-          lcs_length,
-          MPI_CHAR,
-          world_rank - 1,
-          0,
-          MPI_COMM_WORLD);
+    if (progress_interval > 0.0)
+    {
+      progress_timer.start();
+      rank_rows.assign(world_size, first_row - 1);
+      start_cells = world_rank == 0 ? completedCells() : 0;
+    }
+    openBoundaryWindow();
+    fillRows(first_row, matrix_height, true);
+    if (progress_interval > 0.0)
+    {
+      finishProgress();
     }
 
-    if (world_rank == 0)
+    // The rows above a checkpoint were not saved. The traceback aligns that
+    // part of the sequences in linear space, unless the recurrence needs
+    // them recomputed. Every rank refills the same rows, so the boundary
+    // messages still pair up. Every rank learns of a cancellation during the
+    // main fill, so either all of them refill or none do.
+    first_filled_rows.clear();
+    if (!cancelled && first_row > 2 && tracesUnfilledRows())
     {
-      longest_common_subsequence = lcs_buffer;
+      first_filled_rows.assign(matrix_width, first_row - 1);
     }
-    delete[] lcs_buffer;
-  }
+    else if (!cancelled)
+    {
+      fillRows(1, first_row - 1, false);
+    }
+    closeBoundaryWindow();
 
-  void solveDistributed()
-  {
-    matrix_timer.start();
-    for (int row = 1; row < matrix_height; row++)
+    if (checkpoint_path != "")
     {
-      for (int col = 1; col < matrix_width; col++)
-      {
-        computeCell(row, col);
-      }
+      pruneCheckpoints(true);
+      // Once the fill is complete, none of the checkpoints are needed. A
+      // cancelled solve keeps them, so that it can be resumed later.
+      if (!cancelled)
+        removeCheckpointsBefore(matrix_height);
     }
+
+    // Add up the cells computed by every rank.
+    long long local_cells = (long long)completed_rows * (matrix_width - 1);
+    MPI_Allreduce(&local_cells, &completed_cells, 1, MPI_LONG_LONG, MPI_SUM,
+                  MPI_COMM_WORLD);
+
     // MPI_Barrier(MPI_COMM_WORLD);
     matrix_time_taken = timer.stop();
   }
 
+public:
   virtual void solve() override
   {
     timer.start();
     solveDistributed();
+    if (cancelled)
+    {
+      lcs_length = -1;
+      finishCancelled();
+      return;
+    }
     determineLongestCommonSubsequence();
     time_taken = timer.stop();
   }
 
-public:
   LCSDistributed(
       const std::string &sequence_a,
       const std::string &sequence_b,
@@ -260,33 +911,218 @@ public:
       const int world_rank,
       int *start_cols,
       int *sub_str_widths,
-      const std::string &global_sequence_b)
+      const std::string &global_sequence_b,
+      const int block_height = 1,
+      const bool transposed = false)
       : LongestCommonSubsequence(sequence_a, sequence_b),
         world_size(world_size),
         world_rank(world_rank),
         start_cols(start_cols),
         sub_str_widths(sub_str_widths),
-        global_sequence_b(global_sequence_b)
+        global_sequence_b(global_sequence_b),
+        block_height(std::max(1, block_height)),
+        boundary_buffer(this->block_height + 1)
   {
-
-    this->solve();
+    /* The caller has already swapped the sequences before dividing them up,
+    so only the results need to be put back in the caller's orientation. */
+    this->transposed = transposed;
+    column_offset = start_cols[world_rank];
   }
 
   virtual ~LCSDistributed()
   {
   }
 
+  /* Chooses how the boundary values are exchanged by subsequent solves.
+  Every rank must choose the same. */
+  void setBoundaryExchange(const LCSBoundaryExchange exchange)
+  {
+    boundary_exchange = exchange;
+  }
+
+  /* With BOUNDARY_EXCHANGE_SHARED, treats each group of this many
+  consecutive ranks on a node as a node of its own, so that the messages
+  between nodes can be tried on a single machine. */
+  void setRanksPerNode(const int n_ranks)
+  {
+    ranks_per_node = n_ranks;
+  }
+
+  /* Loads the checkpoint of the last row that every rank has saved, from the
+  files written with the given path prefix. Collective; returns false on every
+  rank if any rank cannot resume from that row. */
+  virtual bool resumeFrom(const std::string &path) override
+  {
+    std::string saved_path = checkpoint_path;
+    checkpoint_path = path;
+
+    // Find the rows this rank has checkpoints for.
+    std::string prefix = checkpointPath(0);
+    prefix.resize(prefix.length() - 1);
+    glob_t matches;
+    int latest_row = -1;
+    if (glob((prefix + "*").c_str(), 0, NULL, &matches) == 0)
+    {
+      for (size_t i = 0; i < matches.gl_pathc; i++)
+      {
+        char *end;
+        const char *suffix = matches.gl_pathv[i] + prefix.length();
+        long row = strtol(suffix, &end, 10);
+        if (end != suffix && *end == '\0')
+        {
+          checkpoint_rows.push_back(row);
+          latest_row = std::max(latest_row, (int)row);
+        }
+      }
+    }
+    globfree(&matches);
+
+    int common_row;
+    MPI_Allreduce(&latest_row, &common_row, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    int ok = common_row >= 0 &&
+             LongestCommonSubsequence::resumeFrom(checkpointPath(common_row)) &&
+             resume_checkpoint.strips[0].row == common_row;
+    int all_ok;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+
+    resuming = all_ok;
+    checkpoint_path = saved_path;
+    // Only files under the current checkpoint path are cleaned up later.
+    if (!resuming || path != checkpoint_path)
+      checkpoint_rows.clear();
+    return resuming;
+  }
+
   virtual int getLongestSubsequenceLength() override
   {
     return lcs_length;
   }
 
+  virtual void printCancelled(FILE *out_file) override
+  {
+    if (world_rank != 0)
+      return;
+    long long total_cells = (long long)length_a * global_sequence_b.length();
+    fprintf(out_file, "Solve cancelled after %lf seconds\n", time_taken);
+    fprintf(out_file, "Cells computed: %lld of %lld (%.1f%%)\n", completed_cells,
+            total_cells, total_cells > 0 ? 100.0 * completed_cells / total_cells : 0.0);
+  }
+
   virtual void printInfo() override
   {
     std::cout << "Longest common subsequence: " << longest_common_subsequence << "\n";
     printLCSLength();
   }
 
+  /* Recomputes the rows a resumed solve left unfilled, on every rank at once
+  as in the main fill. Collective. */
+  virtual void fillUnfilledRows() override
+  {
+    if (first_filled_rows.empty())
+      return;
+    openBoundaryWindow();
+    fillRows(1, first_filled_rows[0], false);
+    closeBoundaryWindow();
+    first_filled_rows.clear();
+  }
+
+  /* Every rank writes its own strip of columns straight into the shared dump
+  file with MPI-IO, so no rank has to gather the whole matrix. Collective. */
+  virtual bool dumpMatrix(const std::string &path) override
+  {
+    fillUnfilledRows();
+    int global_length_b = global_sequence_b.length();
+    // The dump is in the caller's orientation.
+    int dump_length_a = transposed ? global_length_b : length_a;
+    int dump_length_b = transposed ? length_a : global_length_b;
+    LCSMatrixDumpHeader header = makeMatrixDumpHeader(dump_length_a, dump_length_b);
+
+    MPI_File file;
+    int error = MPI_File_open(MPI_COMM_WORLD, path.c_str(),
+                              MPI_MODE_WRONLY | MPI_MODE_CREATE,
+                              MPI_INFO_NULL, &file);
+    if (error != MPI_SUCCESS)
+      return false;
+    MPI_File_set_size(file, header.fileSize());
+
+    if (world_rank == 0)
+    {
+      const char *dump_sequence_a = transposed ? global_sequence_b.data() : sequence_a.data;
+      const char *dump_sequence_b = transposed ? sequence_a.data : global_sequence_b.data();
+      MPI_File_write_at(file, 0, &header, sizeof(header), MPI_BYTE,
+                        MPI_STATUS_IGNORE);
+      MPI_File_write_at(file, sizeof(header), dump_sequence_a, dump_length_a,
+                        MPI_CHAR, MPI_STATUS_IGNORE);
+      MPI_File_write_at(file, sizeof(header) + dump_length_a,
+                        dump_sequence_b, dump_length_b, MPI_CHAR,
+                        MPI_STATUS_IGNORE);
+      // An existing file is not truncated, so clear the padding explicitly.
+      MPI_Offset padding_start = sizeof(header) + dump_length_a + dump_length_b;
+      std::vector<char> padding(header.matrix_offset - padding_start, 0);
+      MPI_File_write_at(file, padding_start, padding.data(), padding.size(),
+                        MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+
+    /* The local column 0 is a copy of the last column of the rank to the
+    left, so only the leftmost rank writes it. */
+    int first_local_col = world_rank == 0 ? 0 : 1;
+    int n_cols = matrix_width - first_local_col;
+    int first_global_col = start_cols[world_rank] + first_local_col;
+
+    if (transposed)
+    {
+      /* The columns of this rank are consecutive rows of the dump, so they
+      are written as one contiguous block once transposed in memory. */
+      std::vector<int> rows((size_t)std::max(0, n_cols) * matrix_height);
+      for (int col = 0; col < n_cols; col++)
+      {
+        for (int row = 0; row < matrix_height; row++)
+        {
+          rows[(size_t)col * matrix_height + row] = matrix[row][first_local_col + col];
+        }
+      }
+      MPI_Offset offset = header.matrix_offset +
+                          (MPI_Offset)first_global_col * matrix_height * sizeof(int);
+      error = MPI_File_write_at_all(file, offset, rows.data(), rows.size(),
+                                    MPI_INT, MPI_STATUS_IGNORE);
+    }
+    else if (n_cols > 0)
+    {
+      int file_sizes[2] = {matrix_height, global_length_b + 1};
+      int memory_sizes[2] = {matrix_height, matrix_width};
+      int sub_sizes[2] = {matrix_height, n_cols};
+      int file_starts[2] = {0, first_global_col};
+      int memory_starts[2] = {0, first_local_col};
+      MPI_Datatype file_type, memory_type;
+      MPI_Type_create_subarray(2, file_sizes, sub_sizes, file_starts,
+                               MPI_ORDER_C, MPI_INT, &file_type);
+      MPI_Type_create_subarray(2, memory_sizes, sub_sizes, memory_starts,
+                               MPI_ORDER_C, MPI_INT, &memory_type);
+      MPI_Type_commit(&file_type);
+      MPI_Type_commit(&memory_type);
+
+      MPI_File_set_view(file, header.matrix_offset, MPI_INT, file_type,
+                        "native", MPI_INFO_NULL);
+      error = MPI_File_write_all(file, matrix[0], 1, memory_type,
+                                 MPI_STATUS_IGNORE);
+
+      MPI_Type_free(&file_type);
+      MPI_Type_free(&memory_type);
+    }
+    else
+    {
+      // Still take part in the collective write.
+      MPI_File_set_view(file, header.matrix_offset, MPI_INT, MPI_INT,
+                        "native", MPI_INFO_NULL);
+      error = MPI_File_write_all(file, NULL, 0, MPI_INT, MPI_STATUS_IGNORE);
+    }
+
+    MPI_File_close(&file);
+    int ok = error == MPI_SUCCESS, all_ok;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return all_ok;
+  }
+
   void printPerProcessMatrices()
   {
     for (int rank = 0; rank < world_size; rank++)
@@ -372,6 +1208,144 @@ public:
   }
 };
 
+/* Candidate block heights tried by --tune_block_height. */
+static const int BLOCK_HEIGHT_CANDIDATES[] = {1, 4, 16, 64, 256, 1024};
+
+/* Returns the mean time of n_runs solves of the same input with the given
+block height and boundary exchange. Every rank takes part in each solve. */
+double timeSolves(
+    const std::string &sequence_a,
+    const std::string &local_sequence_b,
+    const int world_size,
+    const int world_rank,
+    int *start_cols,
+    int *sub_str_widths,
+    const std::string &sequence_b,
+    const int block_height,
+    const LCSBoundaryExchange exchange,
+    const int n_runs)
+{
+  double time_taken = 0.0;
+  for (int run = 0; run < n_runs; run++)
+  {
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
+    LCSDistributed lcs(
+        sequence_a,
+        local_sequence_b,
+        world_size,
+        world_rank,
+        start_cols,
+        sub_str_widths,
+        sequence_b,
+        block_height);
+    lcs.setBoundaryExchange(exchange);
+    lcs.solve();
+    MPI_Barrier(MPI_COMM_WORLD);
+    time_taken += MPI_Wtime() - start_time;
+  }
+  return time_taken / n_runs;
+}
+
+/* Solves the same input once for every candidate block height and records the
+fastest one in the tuning file. Every rank takes part in each solve; only the
+root process reads and writes the file. */
+void tuneBlockHeight(
+    const std::string &sequence_a,
+    const std::string &local_sequence_b,
+    const int world_size,
+    const int world_rank,
+    int *start_cols,
+    int *sub_str_widths,
+    const std::string &sequence_b,
+    const std::string &tuning_file,
+    const LCSBoundaryExchange exchange,
+    const int n_runs)
+{
+  int best_block_height = 1;
+  double best_time = -1.0;
+
+  if (world_rank == 0)
+  {
+    printf("block_height | time_taken\n");
+  }
+  for (int block_height : BLOCK_HEIGHT_CANDIDATES)
+  {
+    if (block_height > 1 && block_height / 4 >= (int)sequence_a.length())
+      break; // Larger blocks would all behave the same.
+
+    double time_taken = timeSolves(sequence_a, local_sequence_b, world_size, world_rank,
+                                   start_cols, sub_str_widths, sequence_b, block_height,
+                                   exchange, n_runs);
+
+    if (world_rank == 0)
+    {
+      printf("%12d | %lf\n", block_height, time_taken);
+    }
+    if (best_time < 0.0 || time_taken < best_time)
+    {
+      best_time = time_taken;
+      best_block_height = block_height;
+    }
+  }
+
+  if (world_rank == 0)
+  {
+    TuningTable tuning_table;
+    tuning_table.load(tuning_file);
+    int size_class = sizeClass(sequence_a.length(), sequence_b.length());
+    if (!tuning_table.contains(size_class))
+    {
+      // Start from the defaults rather than a smaller size class.
+      tuning_table[size_class] = TuningConfig();
+    }
+    tuning_table[size_class].block_height = best_block_height;
+    if (tuning_table.save(tuning_file))
+    {
+      printf("Best block_height for size class %d: %d (saved to %s)\n",
+             size_class, best_block_height, tuning_file.c_str());
+    }
+  }
+}
+
+/* Times every boundary exchange on the same input, for every candidate block
+height, and prints them side by side. */
+void benchmarkBoundaryExchange(
+    const std::string &sequence_a,
+    const std::string &local_sequence_b,
+    const int world_size,
+    const int world_rank,
+    int *start_cols,
+    int *sub_str_widths,
+    const std::string &sequence_b,
+    const int n_runs)
+{
+  const LCSBoundaryExchange exchanges[] = {
+      BOUNDARY_EXCHANGE_SEND, BOUNDARY_EXCHANGE_RMA, BOUNDARY_EXCHANGE_SHARED};
+  if (world_rank == 0)
+  {
+    printf("block_height |       send |        rma |     shared\n");
+  }
+  for (int block_height : BLOCK_HEIGHT_CANDIDATES)
+  {
+    if (block_height > 1 && block_height / 4 >= (int)sequence_a.length())
+      break; // Larger blocks would all behave the same.
+
+    if (world_rank == 0)
+      printf("%12d", block_height);
+    for (LCSBoundaryExchange exchange : exchanges)
+    {
+      double time_taken = timeSolves(sequence_a, local_sequence_b, world_size, world_rank,
+                                     start_cols, sub_str_widths, sequence_b, block_height,
+                                     exchange, n_runs);
+      if (world_rank == 0)
+        printf(" | %10lf", time_taken);
+    }
+    if (world_rank == 0)
+      printf("\n");
+  }
+}
+
 int main(int argc, char *argv[])
 {
   cxxopts::Options options("lcs_distributed",
@@ -385,7 +1359,51 @@ int main(int argc, char *argv[])
           {"sequence_b", "Second input sequence.",
            cxxopts::value<std::string>()->default_value("")}, // Second input sequence
           {"input_file", "Path to input .csv file.",
-           cxxopts::value<std::string>()->default_value("")} // Input file.
+           cxxopts::value<std::string>()->default_value("")}, // Input file.
+          {"block_height", "Rows per boundary message between processes.",
+           cxxopts::value<int>()->default_value("1")},
+          {"orientation", "Sequence divided between the processes: auto (the longer one), keep (B) or transpose (A).",
+           cxxopts::value<std::string>()->default_value("auto")},
+          {"tuning_file", "Path to tuning .csv file written by lcs_tune.",
+           cxxopts::value<std::string>()->default_value(DEFAULT_TUNING_FILE)},
+          {"tune_block_height", "Time each candidate block height and save the best to the tuning file.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"boundary_exchange", "How boundary values reach the next process: send (MPI_Send/MPI_Recv), rma (MPI_Put into a window) or shared (shared memory on a node, messages between nodes).",
+           cxxopts::value<std::string>()->default_value("send")},
+          {"tune_runs", "Number of runs per candidate when tuning or benchmarking.",
+           cxxopts::value<int>()->default_value("3")},
+          {"ranks_per_node", "With --boundary_exchange=shared, treat at most this many consecutive processes as one node (0 = the actual nodes).",
+           cxxopts::value<int>()->default_value("0")},
+          {"benchmark_exchange", "Time every boundary exchange at each candidate block height.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"output_format", "Result format: text, binary, jsonl or edits.",
+           cxxopts::value<std::string>()->default_value("text")},
+          {"output_file", "Path to write binary or jsonl results to (default: stdout).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"alignment", "Include the alignment as runs of matches in binary or jsonl results.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"dump_matrix", "Write the matrix to this binary file, for lcs_matrix_view.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"checkpoint_file", "Save checkpoints of the fill to files starting with this path.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"checkpoint_interval", "Seconds between checkpoints.",
+           cxxopts::value<double>()->default_value("600")},
+          {"resume", "Continue from the last row that every process has a checkpoint for, without recomputing the rows above it.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"progress_interval", "Print progress to stderr every this many seconds (0 disables it).",
+           cxxopts::value<double>()->default_value("0")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+          {"scoring", "Recurrence to solve: lcs, weighted, global (Needleman-Wunsch) or local (Smith-Waterman).",
+           cxxopts::value<std::string>()->default_value("lcs")},
+          {"match", "Score of a match, for global and local scoring.",
+           cxxopts::value<int>()->default_value("1")},
+          {"mismatch", "Score of a mismatch, for global and local scoring.",
+           cxxopts::value<int>()->default_value("-1")},
+          {"gap", "Penalty per character aligned with a gap, for global and local scoring.",
+           cxxopts::value<int>()->default_value("1")},
+          {"weights", "Character weights for weighted scoring, as A:2,C:3 (others weigh 1).",
+           cxxopts::value<std::string>()->default_value("")},
       });
 
   auto command_options = options.parse(argc, argv);
@@ -393,6 +1411,58 @@ int main(int argc, char *argv[])
   std::string sequence_a = command_options["sequence_a"].as<std::string>();
   std::string sequence_b = command_options["sequence_b"].as<std::string>();
   std::string input_file = command_options["input_file"].as<std::string>();
+  int block_height = command_options["block_height"].as<int>();
+  std::string tuning_file = command_options["tuning_file"].as<std::string>();
+  bool tune = command_options["tune_block_height"].as<bool>();
+  int tune_runs = std::max(1, command_options["tune_runs"].as<int>());
+  bool benchmark_exchange = command_options["benchmark_exchange"].as<bool>();
+  int ranks_per_node = std::max(0, command_options["ranks_per_node"].as<int>());
+  LCSBoundaryExchange boundary_exchange;
+  if (!parseBoundaryExchange(command_options["boundary_exchange"].as<std::string>(),
+                             boundary_exchange))
+  {
+    std::cerr << "Error: unknown boundary exchange: "
+              << command_options["boundary_exchange"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  LCSOutputFormat output_format;
+  if (!parseOutputFormat(command_options["output_format"].as<std::string>(), output_format))
+  {
+    std::cerr << "Error: unknown output format: "
+              << command_options["output_format"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  LCSOrientation orientation;
+  if (!parseOrientation(command_options["orientation"].as<std::string>(), orientation))
+  {
+    std::cerr << "Error: unknown orientation: "
+              << command_options["orientation"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  std::string output_file = command_options["output_file"].as<std::string>();
+  bool include_alignment = command_options["alignment"].as<bool>();
+  std::string dump_file = command_options["dump_matrix"].as<std::string>();
+  std::string checkpoint_file = command_options["checkpoint_file"].as<std::string>();
+  double checkpoint_interval = command_options["checkpoint_interval"].as<double>();
+  bool resume = command_options["resume"].as<bool>();
+  double progress_interval = command_options["progress_interval"].as<double>();
+  double time_limit = command_options["time_limit"].as<double>();
+  ScoringOptions scoring;
+  if (!parseScoringScheme(command_options["scoring"].as<std::string>(), scoring.scheme))
+  {
+    std::cerr << "Error: unknown scoring: "
+              << command_options["scoring"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  scoring.match = command_options["match"].as<int>();
+  scoring.mismatch = command_options["mismatch"].as<int>();
+  scoring.gap = command_options["gap"].as<int>();
+  if (!scoring.weights.parse(command_options["weights"].as<std::string>()))
+  {
+    std::cerr << "Error: malformed weights: "
+              << command_options["weights"].as<std::string>() << std::endl;
+    exit(1);
+  }
 
   if (input_file != "")
   {
@@ -406,25 +1476,48 @@ int main(int argc, char *argv[])
     exit(1);
   }
 
+  /* Use the tuned block height unless one was given on the command line. */
+  TuningTable tuning_table;
+  if (!command_options.count("block_height") && tuning_table.load(tuning_file))
+  {
+    block_height =
+        tuning_table.lookup(sequence_a.length(), sequence_b.length()).block_height;
+  }
+
   MPI_Init(NULL, NULL);
+  int exit_code = 0;
 
   int world_size;
   MPI_Comm_size(MPI_COMM_WORLD, &world_size);
   int world_rank;
   MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
 
-  if (world_rank == 0)
+  if (world_rank == 0 && output_format == LCS_OUTPUT_TEXT)
   {
     printf("-------------------- LCS Distributed --------------------\n");
-    printf("n_processes: %d\n\n", world_size);
+    printf("n_processes: %d\n", world_size);
+    printf("block_height: %d\n", block_height);
+    printf("boundary_exchange: %s\n", boundaryExchangeName(boundary_exchange));
+    if (shouldTranspose(orientation, sequence_a.length(), sequence_b.length(), world_size))
+      printf("transposed: sequence A is divided between the processes\n");
+    printf("\n");
   }
   MPI_Barrier(MPI_COMM_WORLD);
 
   int length_a = sequence_a.length();
   int length_b = sequence_b.length();
 
-  const int min_n_cols_per_process = length_b / world_size;
-  const int excess = length_b % world_size;
+  /* Divide the longer sequence between the processes unless told otherwise,
+  so that each process gets a wider strip of columns. */
+  bool transposed = shouldTranspose(orientation, length_a, length_b, world_size);
+  if (transposed)
+  {
+    std::swap(sequence_a, sequence_b);
+  }
+  int n_columns = sequence_b.length();
+
+  const int min_n_cols_per_process = n_columns / world_size;
+  const int excess = n_columns % world_size;
 
   /* We need to keep track of which columns are mapped to which processes so
   we can gather them together again at the end with MPI_Gatherv.*/
@@ -451,25 +1544,94 @@ int main(int argc, char *argv[])
   int start_col = start_cols[world_rank];
   int n_cols = sub_str_widths[world_rank];
 
-  // Divide up sequence B.
+  // Divide up the sequence along the columns.
   std::string local_sequence_b = sequence_b.substr(start_col, n_cols);
 
-  LCSDistributed lcs(
-      sequence_a,
-      local_sequence_b,
-      world_size,
-      world_rank,
-      start_cols,
-      sub_str_widths,
-      sequence_b);
+  if (tune)
+  {
+    tuneBlockHeight(sequence_a, local_sequence_b, world_size, world_rank,
+                    start_cols, sub_str_widths, sequence_b, tuning_file,
+                    boundary_exchange, tune_runs);
+  }
+  else if (benchmark_exchange)
+  {
+    benchmarkBoundaryExchange(sequence_a, local_sequence_b, world_size, world_rank,
+                              start_cols, sub_str_widths, sequence_b, tune_runs);
+  }
+  else
+  {
+    std::unique_ptr<LCSDistributed> solver = makeScoredSolver<LCSDistributed>(
+        scoring,
+        sequence_a,
+        local_sequence_b,
+        world_size,
+        world_rank,
+        start_cols,
+        sub_str_widths,
+        sequence_b,
+        block_height,
+        transposed);
+    LCSDistributed &lcs = *solver;
+    lcs.setBoundaryExchange(boundary_exchange);
+    lcs.setRanksPerNode(ranks_per_node);
+    if (checkpoint_file != "")
+    {
+      lcs.enableCheckpoints(checkpoint_file, checkpoint_interval);
+      if (resume && !lcs.resumeFrom(checkpoint_file) && world_rank == 0)
+      {
+        std::cerr << "No checkpoint that every process can resume from; "
+                     "starting from the beginning."
+                  << std::endl;
+      }
+    }
+    lcs.enableProgress(progress_interval);
+    // Only the root process enforces the time limit; it tells the others.
+    CancellationToken cancellation;
+    if (world_rank == 0)
+    {
+      cancellation.setTimeLimit(time_limit);
+      lcs.setCancellationToken(&cancellation);
+    }
+    lcs.solve();
+
+    if (lcs.wasCancelled())
+    {
+      // There is no result, only how far the solve got.
+      lcs.printCancelled(output_format == LCS_OUTPUT_TEXT ? stdout : stderr);
+      exit_code = 2;
+    }
+    else
+    {
+      if (dump_file != "" && !lcs.dumpMatrix(dump_file) && world_rank == 0)
+      {
+        std::cerr << "Error writing file: " << dump_file << std::endl;
+      }
 
-  // Print solution.
-  lcs.print();
+      if (output_format != LCS_OUTPUT_TEXT)
+      {
+        // The root process holds the whole LCS and alignment.
+        if (world_rank == 0 &&
+            !writeResult(output_file, output_format, length_a, length_b,
+                         lcs.getLongestSubsequenceLength(), lcs.getScore(),
+                         lcs.getMatrixTimeTaken(), lcs.getTimeTaken(),
+                         include_alignment ? &lcs.getMatchRuns() : NULL,
+                         &lcs.getEditScript()))
+        {
+          std::cerr << "Error writing file: " << output_file << std::endl;
+        }
+      }
+      else
+      {
+        // Print solution.
+        lcs.print();
+      }
+    }
+  }
 
   delete[] sub_str_widths;
   delete[] start_cols;
 
   MPI_Finalize();
 
-  return 0;
+  return exit_code;
 }
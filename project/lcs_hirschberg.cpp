@@ -0,0 +1,128 @@
+#include <iostream>
+#include <string>
+
+#include "cxxopts.hpp"      // Command-line option parser library
+#include "lcs_hirschberg.h" // Header file containing the LongestCommonSubsequenceHirschberg class
+#include "lcs_output.h"     // Binary and JSONL result formats
+
+// ***
+//  This is the Hirschberg version of the LCS program. It finds the LCS and
+//  its alignment in memory linear in the length of the sequences, by
+//  splitting the problem in two recursively, on multiple threads.
+// ***
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_hirschberg",
+                           "LCS program for CMPT 431 project in linear memory");
+
+  options.add_options(
+      "inputs",
+      {
+          {"n_threads", "Number of threads for the program",
+           cxxopts::value<int>()->default_value("1")},
+          {"base_cells", "Solve subproblems of at most this many cells with a full matrix.",
+           cxxopts::value<long long>()->default_value("65536")},
+          {"sequence_a", "First input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_b", "Second input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"input_file", "Path to input .csv file.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"output_format", "Result format: text, binary, jsonl or edits.",
+           cxxopts::value<std::string>()->default_value("text")},
+          {"output_file", "Path to write binary or jsonl results to (default: stdout).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"alignment", "Include the alignment as runs of matches in binary or jsonl results.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  int n_threads = command_options["n_threads"].as<int>();
+  long long base_cells = command_options["base_cells"].as<long long>();
+
+  std::string sequence_a = command_options["sequence_a"].as<std::string>();
+  std::string sequence_b = command_options["sequence_b"].as<std::string>();
+  std::string input_file = command_options["input_file"].as<std::string>();
+  LCSOutputFormat output_format;
+  if (!parseOutputFormat(command_options["output_format"].as<std::string>(), output_format))
+  {
+    std::cerr << "Error: unknown output format: "
+              << command_options["output_format"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  std::string output_file = command_options["output_file"].as<std::string>();
+  double time_limit = command_options["time_limit"].as<double>();
+
+  if (input_file != "")
+  {
+    // Read sequences from .csv file if file path was provided.
+    read_input_csv(input_file, sequence_a, sequence_b);
+  }
+
+  if (sequence_a.length() < 1 || sequence_b.length() < 1)
+  {
+    std::cerr << "Error: sequences cannot be empty." << std::endl;
+    exit(1);
+  }
+  if (n_threads <= 0)
+  {
+    std::cerr << "Error: Number of threads must be greater than zero.\n";
+    return 1;
+  }
+  if (base_cells <= 0)
+  {
+    std::cerr << "Error: base_cells must be greater than zero.\n";
+    return 1;
+  }
+
+  LongestCommonSubsequenceHirschberg lcs(sequence_a, sequence_b, n_threads,
+                                         base_cells);
+  CancellationToken cancellation;
+  cancellation.setTimeLimit(time_limit);
+  lcs.setCancellationToken(&cancellation);
+
+  if (output_format != LCS_OUTPUT_TEXT)
+  {
+    lcs.solve();
+    if (lcs.wasCancelled())
+    {
+      fprintf(stderr, "Solve cancelled after %lf seconds\n", lcs.getTimeTaken());
+      return 2;
+    }
+    // Plain LCS, so the score is the length.
+    int length = lcs.getLongestSubsequenceLength();
+    if (!writeResult(output_file, output_format, lcs.getLengthA(), lcs.getLengthB(),
+                     length, length, lcs.getTimeTaken(),
+                     lcs.getTimeTaken(),
+                     command_options["alignment"].as<bool>() ? &lcs.getMatchRuns() : NULL,
+                     &lcs.getEditScript()))
+    {
+      std::cerr << "Error writing file: " << output_file << std::endl;
+      exit(1);
+    }
+    return 0;
+  }
+
+  printf("_-_-_-_-_-_-_-_-_ LCS Hirschberg _-_-_-_-_-_-_-_-_\n");
+  printf("Number of Threads: %d\n", n_threads);
+  printf("Base Case Size: %lld cells\n", base_cells);
+  printf("Starting LCS Hirschberg Solver\n");
+  lcs.solve();
+
+  if (lcs.wasCancelled())
+  {
+    printf("LCS Hirschberg Solver Cancelled\n\n");
+    printf("Solve cancelled after %lf seconds\n", lcs.getTimeTaken());
+    return 2;
+  }
+  printf("LCS Hirschberg Solver Finished\n\n");
+
+  printf("-_-_-_-_-_-_-_ LCS Hirschberg Results _-_-_-_-_-_-_-\n");
+  lcs.printInfo();
+  lcs.printHirschbergStats();
+
+  return 0;
+}
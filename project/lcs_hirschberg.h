@@ -0,0 +1,402 @@
+#ifndef _LCS_HIRSCHBERG_H_
+#define _LCS_HIRSCHBERG_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "lcs.h"
+#include "lcs_serial.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Finds the LCS and its alignment in linear memory, on several threads.
+ *
+ * Hirschberg's algorithm splits sequence_a in half and computes only the last
+ * row of the matrix of the top half (the forward pass) and of the bottom half
+ * with both sequences reversed (the reverse pass). The column where the sum
+ * of the two rows is largest is where an optimal alignment crosses the middle
+ * row, which splits the problem into two independent subproblems: the top
+ * half against the left part of sequence_b, and the bottom half against the
+ * right part. Those are solved recursively, and subproblems of at most
+ * base_cells cells are solved directly with a full matrix.
+ *
+ * Both the split and the recursion are parallel: the two passes run
+ * concurrently, and so do the two subproblems. Passes with more than
+ * WAVEFRONT_CELLS cells are themselves divided into strips of columns that
+ * are computed as a wavefront, like the parallel solver, except that each
+ * strip keeps only its current row and hands its last column to the next
+ * strip. Everything runs as tasks of one thread pool; the pool hands out the
+ * strips of a pass in order, so a strip only ever waits for a strip that is
+ * being computed.
+ *
+ * Only a few rows and the base cases are ever held in memory, so it is not a
+ * LongestCommonSubsequence, which holds the whole matrix.
+ */
+class LongestCommonSubsequenceHirschberg
+{
+protected:
+  // Passes smaller than this are computed by a single thread.
+  static const long long WAVEFRONT_CELLS = 1 << 22;
+  // Subproblems smaller than this are not worth a second task.
+  static const long long FORK_CELLS = 1 << 18;
+  // Rows computed by a strip of a wavefront pass between synchronizations.
+  static const int PASS_BLOCK_HEIGHT = 64;
+
+  std::string sequence_a;
+  std::string sequence_b;
+  int numThreads;
+  long long base_cells; // Largest subproblem solved with a full matrix.
+
+  ThreadPool thread_pool;
+
+  std::string longest_common_subsequence;
+  std::vector<MatchRun> match_runs;
+  std::vector<EditRun> edit_runs; // The same alignment as an edit script.
+  int lcs_length = 0;
+
+  CancellationToken *cancellation_token = nullptr;
+  bool cancelled = false;
+  std::atomic<int> n_base_cases;
+  std::atomic<int> n_wavefront_passes;
+
+  Timer timer;
+  double time_taken = 0.0;
+
+  bool cancellationRequested()
+  {
+    return cancellation_token && cancellation_token->isCancelled();
+  }
+
+  /* Computes the last row of the matrix of a against b into row, which has
+  length_b + 1 entries, using a single row of memory. */
+  void passSerial(const char *a, const int length_a, const char *b,
+                  const int length_b, int *row)
+  {
+    std::fill(row, row + length_b + 1, 0);
+    for (int i = 0; i < length_a; i++)
+    {
+      if (i % 1024 == 0 && cancellationRequested())
+        return;
+      int diagonal = 0; // row[j - 1] of the previous row.
+      for (int j = 1; j <= length_b; j++)
+      {
+        int top = row[j];
+        row[j] = a[i] == b[j - 1] ? diagonal + 1 : std::max(top, row[j - 1]);
+        diagonal = top;
+      }
+    }
+  }
+
+  /* Like passSerial, but with n_strips strips of columns computed as a
+  wavefront on the pool. Strip s keeps its part of the row in row and writes
+  its last column for every row to edges[s], which is all strip s + 1 needs:
+  the value to its left in the current row and in the row above. */
+  void passWavefront(const char *a, const int length_a, const char *b,
+                     const int length_b, int *row, const int n_strips)
+  {
+    std::fill(row, row + length_b + 1, 0);
+    std::vector<std::vector<int>> edges(n_strips, std::vector<int>(length_a + 1, 0));
+    std::vector<std::atomic<int>> done_rows(n_strips); // Rows finished by each strip.
+    for (std::atomic<int> &done : done_rows)
+    {
+      done = 0;
+    }
+    std::atomic<bool> stopping(false);
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    thread_pool.run(n_strips, [&](int strip)
+                    {
+      int start_col = 1 + (long long)length_b * strip / n_strips;
+      int end_col = (long long)length_b * (strip + 1) / n_strips;
+      for (int block_start = 0; block_start < length_a; block_start += PASS_BLOCK_HEIGHT)
+      {
+        int block_end = std::min(block_start + PASS_BLOCK_HEIGHT, length_a);
+        if (stopping || cancellationRequested())
+        {
+          stopping = true;
+          break;
+        }
+        // Wait until the strip to the left has finished this block.
+        if (strip > 0 && done_rows[strip - 1] < block_end)
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&]
+                  { return done_rows[strip - 1] >= block_end || stopping; });
+          if (stopping)
+            break;
+        }
+        for (int i = block_start; i < block_end; i++)
+        {
+          int left = strip > 0 ? edges[strip - 1][i + 1] : 0;
+          int diagonal = strip > 0 ? edges[strip - 1][i] : 0;
+          for (int j = start_col; j <= end_col; j++)
+          {
+            int top = row[j];
+            left = a[i] == b[j - 1] ? diagonal + 1 : std::max(top, left);
+            row[j] = left;
+            diagonal = top;
+          }
+          edges[strip][i + 1] = end_col >= start_col ? row[end_col] : left;
+        }
+        done_rows[strip] = block_end;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+        }
+        cv.notify_all();
+      }
+      if (stopping)
+      {
+        // Wake the strips to the right so that they stop too.
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+        }
+        cv.notify_all();
+      } });
+  }
+
+  /* Computes the last row of the matrix of a against b, on a wavefront if it
+  is large enough and there are threads to spare. */
+  void pass(const char *a, const int length_a, const char *b,
+            const int length_b, int *row, const int n_threads)
+  {
+    int n_strips = std::min(n_threads, length_b / 1024);
+    if (n_strips > 1 && (long long)length_a * length_b >= WAVEFRONT_CELLS)
+    {
+      n_wavefront_passes++;
+      passWavefront(a, length_a, b, length_b, row, n_strips);
+    }
+    else
+    {
+      passSerial(a, length_a, b, length_b, row);
+    }
+  }
+
+  /* Appends the alignment of sequence_a[a_start, a_end) and
+  sequence_b[b_start, b_end) to runs, and its edit script to edits. n_threads
+  is the share of the threads that this subproblem may use. */
+  void solveRange(const int a_start, const int a_end, const int b_start,
+                  const int b_end, const int n_threads,
+                  std::vector<MatchRun> &runs, std::vector<EditRun> &edits)
+  {
+    const int length_a = a_end - a_start;
+    const int length_b = b_end - b_start;
+    if (cancellationRequested())
+      return;
+    if (length_a == 0 || length_b == 0)
+    {
+      // Only one of the sequences is left, so its characters are all edits.
+      appendEditRun(edits, EditRun{length_a, 'D'});
+      appendEditRun(edits, EditRun{length_b, 'I'});
+      return;
+    }
+
+    if ((long long)length_a * length_b <= base_cells || length_a == 1)
+    {
+      n_base_cases++;
+      LongestCommonSubsequenceSerial lcs(Sequence(&sequence_a[a_start], length_a),
+                                         Sequence(&sequence_b[b_start], length_b));
+      lcs.solve();
+      for (const MatchRun &run : lcs.getMatchRuns())
+      {
+        appendMatchRun(runs, MatchRun{run.i + a_start, run.j + b_start, run.length});
+      }
+      for (const EditRun &run : lcs.getEditScript())
+      {
+        appendEditRun(edits, run);
+      }
+      return;
+    }
+
+    // The forward pass of the top half and the reverse pass of the bottom
+    // half, each with half of the threads.
+    const int a_mid = a_start + length_a / 2;
+    std::vector<int> forward(length_b + 1), reverse(length_b + 1);
+    std::string bottom_reversed(sequence_a.rbegin() + (sequence_a.length() - a_end),
+                                sequence_a.rbegin() + (sequence_a.length() - a_mid));
+    std::string b_reversed(sequence_b.rbegin() + (sequence_b.length() - b_end),
+                           sequence_b.rbegin() + (sequence_b.length() - b_start));
+    const int half_threads = std::max(1, n_threads / 2);
+    auto run_pass = [&](int task)
+    {
+      if (task == 0)
+        pass(&sequence_a[a_start], a_mid - a_start, &sequence_b[b_start],
+             length_b, forward.data(), half_threads);
+      else
+        pass(bottom_reversed.data(), a_end - a_mid, b_reversed.data(),
+             length_b, reverse.data(), n_threads - half_threads);
+    };
+    if (n_threads > 1)
+    {
+      thread_pool.run(2, run_pass);
+    }
+    else
+    {
+      run_pass(0);
+      run_pass(1);
+    }
+    if (cancellationRequested())
+      return;
+
+    // The column where an optimal alignment crosses the middle row.
+    int split = 0;
+    int best = -1;
+    for (int j = 0; j <= length_b; j++)
+    {
+      int total = forward[j] + reverse[length_b - j];
+      if (total > best)
+      {
+        best = total;
+        split = j;
+      }
+    }
+    std::vector<int>().swap(forward);
+    std::vector<int>().swap(reverse);
+
+    // The two halves are independent.
+    const int b_split = b_start + split;
+    const bool fork = n_threads > 1 &&
+                      (long long)(a_mid - a_start) * split >= FORK_CELLS &&
+                      (long long)(a_end - a_mid) * (b_end - b_split) >= FORK_CELLS;
+    if (fork)
+    {
+      std::vector<MatchRun> bottom_runs;
+      std::vector<EditRun> bottom_edits;
+      thread_pool.run(2, [&](int task)
+                      {
+        if (task == 0)
+          solveRange(a_start, a_mid, b_start, b_split, half_threads, runs, edits);
+        else
+          solveRange(a_mid, a_end, b_split, b_end, n_threads - half_threads,
+                     bottom_runs, bottom_edits); });
+      for (const MatchRun &run : bottom_runs)
+      {
+        appendMatchRun(runs, run);
+      }
+      // The halves meet on the middle line, so the runs either side of it
+      // may join.
+      for (const EditRun &run : bottom_edits)
+      {
+        appendEditRun(edits, run);
+      }
+    }
+    else
+    {
+      solveRange(a_start, a_mid, b_start, b_split, n_threads, runs, edits);
+      solveRange(a_mid, a_end, b_split, b_end, n_threads, runs, edits);
+    }
+  }
+
+public:
+  /* Subproblems of at most base_cells cells are solved with a full matrix,
+  which bounds the memory of the base cases. */
+  LongestCommonSubsequenceHirschberg(const std::string &sequence_a,
+                                     const std::string &sequence_b,
+                                     const int n_threads,
+                                     const long long base_cells = 1 << 16)
+      : sequence_a(sequence_a), sequence_b(sequence_b),
+        numThreads(std::max(1, n_threads)),
+        base_cells(std::max(1LL, base_cells)),
+        thread_pool(std::max(1, n_threads) - 1),
+        n_base_cases(0), n_wavefront_passes(0)
+  {
+  }
+
+  void solve()
+  {
+    timer.start();
+    cancelled = false;
+    n_base_cases = 0;
+    n_wavefront_passes = 0;
+    match_runs.clear();
+    edit_runs.clear();
+
+    solveRange(0, sequence_a.length(), 0, sequence_b.length(), numThreads,
+               match_runs, edit_runs);
+
+    longest_common_subsequence.clear();
+    lcs_length = 0;
+    if (cancellationRequested())
+    {
+      cancelled = true;
+      match_runs.clear();
+      edit_runs.clear();
+    }
+    for (const MatchRun &run : match_runs)
+    {
+      longest_common_subsequence.append(sequence_a, run.i, run.length);
+      lcs_length += run.length;
+    }
+    time_taken = timer.stop();
+  }
+
+  /* Subsequent solves stop soon after the token is cancelled. The token
+  must outlive the solves. */
+  void setCancellationToken(CancellationToken *token)
+  {
+    cancellation_token = token;
+  }
+
+  bool wasCancelled() const
+  {
+    return cancelled;
+  }
+
+  // Returns the length of the LCS, or -1 if the last solve was cancelled.
+  int getLongestSubsequenceLength() const
+  {
+    return cancelled ? -1 : lcs_length;
+  }
+
+  const std::string &getLongestCommonSubsequence() const
+  {
+    return longest_common_subsequence;
+  }
+
+  const std::vector<MatchRun> &getMatchRuns() const
+  {
+    return match_runs;
+  }
+
+  const std::vector<EditRun> &getEditScript() const
+  {
+    return edit_runs;
+  }
+
+  int getLengthA() const
+  {
+    return sequence_a.length();
+  }
+
+  int getLengthB() const
+  {
+    return sequence_b.length();
+  }
+
+  double getTimeTaken() const
+  {
+    return time_taken;
+  }
+
+  void printInfo()
+  {
+    std::cout << "Sequence A: " << sequence_a << "\n";
+    std::cout << "Sequence B: " << sequence_b << "\n";
+    std::cout << "Longest common subsequence: " << longest_common_subsequence << "\n";
+    std::cout << "Length of the longest common subsequence: " << getLongestSubsequenceLength() << "\n";
+  }
+
+  void printHirschbergStats()
+  {
+    printf("\n-_-_-_-_-_-_-_ LCS Hirschberg Statistics _-_-_-_-_-_-_-\n\n");
+    printf("Subproblems solved with a full matrix: %d\n", n_base_cases.load());
+    printf("Passes computed as a wavefront: %d\n", n_wavefront_passes.load());
+    printf("Total time taken: %lf\n", time_taken);
+  }
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include <algorithm> // std::max, std::min
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cxxopts.hpp"
+#include "matrix_dump.h"
+
+// ***
+//  Viewer for the matrix dumps written with --dump_matrix. The dump is memory
+//  mapped, so printing a region only reads the pages that hold it, however
+//  large the matrix is.
+// ***
+
+/* Parses "start:end" into a half-open range, clamped to [0, size). Either
+end may be omitted. Returns false if the range is malformed. */
+bool parse_range(const std::string &text, const uint64_t size,
+                 uint64_t &start, uint64_t &end)
+{
+  size_t colon = text.find(':');
+  if (colon == std::string::npos)
+    return false;
+  try
+  {
+    std::string first = text.substr(0, colon);
+    std::string last = text.substr(colon + 1);
+    start = first == "" ? 0 : std::stoull(first);
+    end = last == "" ? size : std::stoull(last);
+  }
+  catch (const std::exception &)
+  {
+    return false;
+  }
+  end = std::min(end, size);
+  start = std::min(start, end);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_matrix_view",
+                           "Print regions of a matrix dump written with --dump_matrix.");
+
+  options.add_options(
+      "inputs",
+      {
+          {"dump_file", "Path to the matrix dump.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"rows", "Rows to print, as start:end (end exclusive).",
+           cxxopts::value<std::string>()->default_value("0:20")},
+          {"cols", "Columns to print, as start:end (end exclusive).",
+           cxxopts::value<std::string>()->default_value("0:20")},
+          {"cell", "Print the single cell at row,col.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"info", "Only print the sizes of the matrix.",
+           cxxopts::value<bool>()->default_value("false")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  std::string dump_file = command_options["dump_file"].as<std::string>();
+  std::string cell = command_options["cell"].as<std::string>();
+
+  if (dump_file == "")
+  {
+    std::cerr << "Error: --dump_file is required." << std::endl;
+    exit(1);
+  }
+
+  int fd = open(dump_file.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if (fd < 0 || fstat(fd, &file_stat) < 0)
+  {
+    std::cerr << "Error reading file: " << dump_file << std::endl;
+    exit(1);
+  }
+  size_t size = file_stat.st_size;
+  const char *data = NULL;
+  if (size >= sizeof(LCSMatrixDumpHeader))
+  {
+    data = (const char *)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  LCSMatrixDumpHeader header;
+  bool valid = data != NULL && data != MAP_FAILED;
+  if (valid)
+  {
+    memcpy(&header, data, sizeof(header));
+    valid = header.magic == LCS_MATRIX_DUMP_MAGIC &&
+            header.version == LCS_MATRIX_DUMP_VERSION &&
+            size >= header.fileSize();
+  }
+  if (!valid)
+  {
+    std::cerr << "Error: not a matrix dump: " << dump_file << std::endl;
+    exit(1);
+  }
+
+  const char *sequence_a = data + sizeof(header);
+  const char *sequence_b = sequence_a + header.length_a;
+  const int *cells = (const int *)(data + header.matrix_offset);
+  const uint64_t n_cols = header.n_cols();
+
+  if (command_options["info"].as<bool>())
+  {
+    printf("Length of sequence A: %u\n", header.length_a);
+    printf("Length of sequence B: %u\n", header.length_b);
+    printf("Matrix: %llu x %llu\n", (unsigned long long)header.n_rows(),
+           (unsigned long long)n_cols);
+    printf("Length of the longest common subsequence: %d\n",
+           cells[header.n_rows() * n_cols - 1]);
+    return 0;
+  }
+
+  if (cell != "")
+  {
+    unsigned long long row, col;
+    if (sscanf(cell.c_str(), "%llu,%llu", &row, &col) != 2 ||
+        row >= header.n_rows() || col >= n_cols)
+    {
+      std::cerr << "Error: cell out of range: " << cell << std::endl;
+      exit(1);
+    }
+    printf("%d\n", cells[row * n_cols + col]);
+    return 0;
+  }
+
+  uint64_t row_start, row_end, col_start, col_end;
+  if (!parse_range(command_options["rows"].as<std::string>(), header.n_rows(),
+                   row_start, row_end) ||
+      !parse_range(command_options["cols"].as<std::string>(), n_cols,
+                   col_start, col_end))
+  {
+    std::cerr << "Error: ranges must be given as start:end." << std::endl;
+    exit(1);
+  }
+
+  /* Prints the region in the same layout as printMatrix(): sequence_b along
+  the top, sequence_a down the left side. */
+  int max_num = 0;
+  for (uint64_t i = row_start; i < row_end && col_end > 0; i++)
+  {
+    // Values never decrease along a row.
+    max_num = std::max(max_num, cells[i * n_cols + col_end - 1]);
+  }
+  int field_width = std::to_string(max_num).length() + 1;
+
+  printf("rows %llu:%llu, cols %llu:%llu\n", (unsigned long long)row_start,
+         (unsigned long long)row_end, (unsigned long long)col_start,
+         (unsigned long long)col_end);
+  printf("   ");
+  for (uint64_t j = col_start; j < col_end; j++)
+  {
+    printf("%*c", field_width, j > 0 ? sequence_b[j - 1] : ' ');
+  }
+  printf("\n");
+  for (uint64_t i = row_start; i < row_end; i++)
+  {
+    printf("%c [", i > 0 ? sequence_a[i - 1] : ' ');
+    for (uint64_t j = col_start; j < col_end; j++)
+    {
+      printf("%*d", field_width, cells[i * n_cols + j]);
+    }
+    printf(" ]\n");
+  }
+
+  munmap((void *)data, size);
+  close(fd);
+  return 0;
+}
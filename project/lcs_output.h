@@ -0,0 +1,274 @@
+#ifndef _LCS_OUTPUT_H_
+#define _LCS_OUTPUT_H_
+
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "lcs.h"
+
+/**
+ * Machine-readable result formats, for runs whose text output would be too
+ * large to print or to scrape from a log.
+ *
+ * binary: an LCSResultHeader followed by n_runs MatchRun records
+ *         (three int32 each), all in host byte order. Runs are only written
+ *         when the alignment was requested.
+ * jsonl:  one JSON object per line, appended to the output file, e.g.
+ *         {"length_a":8,"length_b":9,"length":5,"score":5,
+ *          "matrix_time":0.000001,"total_time":0.000002,
+ *          "runs":[[0,1,2],[4,5,3]]}
+ *
+ * length is the number of matched characters and score the score of the
+ * alignment under --scoring; for plain LCS the two are the same.
+ *
+ * edits:  the edit script from sequence A to sequence B (see edit_script.h)
+ *         as one line per result, appended to the output file, e.g.
+ *         3=1X2D4=1I
+ *
+ * The alignment is written as runs of consecutive matches (i, j, length)
+ * instead of the LCS itself: the LCS is sequence_a[i .. i + length - 1] for
+ * each run in order.
+ */
+
+#define LCS_RESULT_MAGIC 0x4f53434c // "LCSO" in little-endian memory.
+#define LCS_RESULT_VERSION 2
+
+enum LCSOutputFormat
+{
+  LCS_OUTPUT_TEXT,
+  LCS_OUTPUT_BINARY,
+  LCS_OUTPUT_JSONL,
+  LCS_OUTPUT_EDITS
+};
+
+struct LCSResultHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t length_a;
+  uint32_t length_b;
+  uint32_t length;
+  uint32_t n_runs;
+  int32_t score;
+  uint32_t padding; // Always 0; keeps the times 8-byte aligned.
+  double matrix_time;
+  double total_time;
+};
+
+/* Parses the value of --output_format. Returns false if it is unknown. */
+inline bool parseOutputFormat(const std::string &name, LCSOutputFormat &format)
+{
+  if (name == "text")
+    format = LCS_OUTPUT_TEXT;
+  else if (name == "binary")
+    format = LCS_OUTPUT_BINARY;
+  else if (name == "jsonl")
+    format = LCS_OUTPUT_JSONL;
+  else if (name == "edits")
+    format = LCS_OUTPUT_EDITS;
+  else
+    return false;
+  return true;
+}
+
+/* Appends the decimal digits of an integer, with a sign if it is negative.
+Avoids the locale and format string handling of printf for the large run
+arrays. */
+inline void appendInt(std::string &buffer, const int value)
+{
+  // The magnitude of INT_MIN does not fit in an int.
+  unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : value;
+  if (value < 0)
+    buffer += '-';
+  char digits[12];
+  int n = 0;
+  do
+  {
+    digits[n++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  while (n > 0)
+  {
+    buffer += digits[--n];
+  }
+}
+
+/* Writes all of the given buffers to a file descriptor. */
+inline bool writeAll(const int fd, struct iovec *buffers, int n_buffers)
+{
+  while (n_buffers > 0)
+  {
+    ssize_t n_written = writev(fd, buffers, std::min(n_buffers, IOV_MAX));
+    if (n_written < 0)
+      return false;
+    // Skip past whatever was written, which may end partway through a buffer.
+    while (n_buffers > 0 && (size_t)n_written >= buffers->iov_len)
+    {
+      n_written -= buffers->iov_len;
+      buffers++;
+      n_buffers--;
+    }
+    if (n_buffers > 0)
+    {
+      buffers->iov_base = (char *)buffers->iov_base + n_written;
+      buffers->iov_len -= n_written;
+    }
+  }
+  return true;
+}
+
+/* Writes an edit script as a line of text, formatting it a block at a time
+rather than building the whole line first. */
+inline bool writeEditScript(const int fd, const std::vector<EditRun> &edit_runs)
+{
+  // Flush the buffer once it holds about this many bytes.
+  const size_t BLOCK_BYTES = 1 << 16;
+  std::string block;
+  block.reserve(BLOCK_BYTES + 16);
+  for (size_t k = 0; k <= edit_runs.size(); k++)
+  {
+    if (k < edit_runs.size())
+    {
+      appendInt(block, edit_runs[k].length);
+      block += edit_runs[k].op;
+    }
+    else
+    {
+      block += '\n';
+    }
+    if (block.length() >= BLOCK_BYTES || k == edit_runs.size())
+    {
+      struct iovec buffer;
+      buffer.iov_base = &block[0];
+      buffer.iov_len = block.length();
+      if (!writeAll(fd, &buffer, 1))
+        return false;
+      block.clear();
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Writes the result of a solve in the binary, JSONL or edits format.
+ *
+ * The output path "" means stdout. Binary files are overwritten; JSONL files
+ * are appended to, so the results of many runs can share one file. The
+ * binary run records are written straight from the solver's vector without
+ * being copied or formatted. The edits format needs the edit script.
+ */
+inline bool writeResult(const std::string &output_file,
+                        const LCSOutputFormat format,
+                        const int length_a, const int length_b,
+                        const int length, const int score,
+                        const double matrix_time, const double total_time,
+                        const std::vector<MatchRun> *match_runs,
+                        const std::vector<EditRun> *edit_runs = NULL)
+{
+  if (format == LCS_OUTPUT_EDITS && !edit_runs)
+    return false;
+  int fd = STDOUT_FILENO;
+  if (output_file != "")
+  {
+    int flags = O_WRONLY | O_CREAT | (format != LCS_OUTPUT_BINARY ? O_APPEND : O_TRUNC);
+    fd = open(output_file.c_str(), flags, 0644);
+    if (fd < 0)
+      return false;
+  }
+  // Anything printed before must come out first.
+  fflush(stdout);
+
+  bool ok;
+  if (format == LCS_OUTPUT_BINARY)
+  {
+    LCSResultHeader header;
+    header.magic = LCS_RESULT_MAGIC;
+    header.version = LCS_RESULT_VERSION;
+    header.length_a = length_a;
+    header.length_b = length_b;
+    header.length = length;
+    header.n_runs = match_runs ? match_runs->size() : 0;
+    header.score = score;
+    header.padding = 0;
+    header.matrix_time = matrix_time;
+    header.total_time = total_time;
+
+    struct iovec buffers[2];
+    buffers[0].iov_base = &header;
+    buffers[0].iov_len = sizeof(header);
+    buffers[1].iov_base = match_runs ? (void *)match_runs->data() : NULL;
+    buffers[1].iov_len = header.n_runs * sizeof(MatchRun);
+    ok = writeAll(fd, buffers, 2);
+  }
+  else if (format == LCS_OUTPUT_EDITS)
+  {
+    ok = writeEditScript(fd, *edit_runs);
+  }
+  else
+  {
+    char times[96];
+    snprintf(times, sizeof(times), ",\"matrix_time\":%f,\"total_time\":%f",
+             matrix_time, total_time);
+
+    std::string line;
+    line.reserve(128 + (match_runs ? 24 * match_runs->size() : 0));
+    line += "{\"length_a\":";
+    appendInt(line, length_a);
+    line += ",\"length_b\":";
+    appendInt(line, length_b);
+    line += ",\"length\":";
+    appendInt(line, length);
+    line += ",\"score\":";
+    appendInt(line, score);
+    line += times;
+    if (match_runs)
+    {
+      line += ",\"runs\":[";
+      for (size_t k = 0; k < match_runs->size(); k++)
+      {
+        const MatchRun &run = (*match_runs)[k];
+        line += k == 0 ? "[" : ",[";
+        appendInt(line, run.i);
+        line += ',';
+        appendInt(line, run.j);
+        line += ',';
+        appendInt(line, run.length);
+        line += ']';
+      }
+      line += ']';
+    }
+    line += "}\n";
+
+    struct iovec buffer;
+    buffer.iov_base = &line[0];
+    buffer.iov_len = line.length();
+    ok = writeAll(fd, &buffer, 1);
+  }
+
+  if (fd != STDOUT_FILENO)
+    ok = close(fd) == 0 && ok;
+  return ok;
+}
+
+/* Writes the result of a solver, with its alignment if requested. */
+inline bool writeResult(const std::string &output_file,
+                        const LCSOutputFormat format,
+                        LongestCommonSubsequence &lcs,
+                        const bool include_alignment)
+{
+  return writeResult(output_file, format, lcs.getLengthA(), lcs.getLengthB(),
+                     lcs.getLongestSubsequenceLength(), lcs.getScore(),
+                     lcs.getMatrixTimeTaken(), lcs.getTimeTaken(),
+                     include_alignment ? &lcs.getMatchRuns() : NULL,
+                     &lcs.getEditScript());
+}
+
+#endif
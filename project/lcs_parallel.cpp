@@ -1,15 +1,13 @@
-#include <algorithm>
-#include <atomic>
-#include <condition_variable>
 #include <iostream>
-#include <mutex>
 #include <string>
-#include <thread>
-#include <vector>
 
 // Include necessary headers
-#include "cxxopts.hpp" // Command-line option parser library
-#include "lcs.h"       // Header file containing the LongestCommonSubsequence class
+#include "cxxopts.hpp"     // Command-line option parser library
+#include "lcs_count.h"     // Counting the distinct LCSs
+#include "lcs_output.h"    // Binary and JSONL result formats
+#include "lcs_parallel.h"  // Header file containing the LongestCommonSubsequenceParallel class
+#include "lcs_scored.h"    // Weighted and alignment scoring
+#include "tuning.h"        // Tuned thread counts and tile sizes
 
 // ***
 //  This is the parallel version of the LCS program that calculates the longest
@@ -17,153 +15,6 @@
 //  perform computations in parallel.
 // ***
 
-// Derived class for parallel computation of Longest Common Subsequence (LCS)
-class LongestCommonSubsequenceParallel : public LongestCommonSubsequence
-{
-protected:
-  int numThreads; // Number of threads to be used for parallel computation
-  std::vector<double>
-      thread_times_taken; // Vector to store the time taken by each thread
-
-  double solve_time_taken; // Time taken to compute the overall LCS
-  std::vector<Timer>
-      thread_timers; // Timer objects to measure each thread's execution time
-  Timer solve_timer; // Timer for the overall solve process
-
-  std::vector<std::atomic<int>>
-      thread_row_indices; // Atomic indices to ensure safe row updates by each
-                          // thread
-
-  std::condition_variable
-      cv;           // Condition variable used for thread synchronization
-  std::mutex mutex; // Mutex to protect the condition variable and ensure safe
-                    // synchronization
-
-  // Function executed by each thread to compute the LCS for a portion of the
-  // matrix
-  void solveParallel(int thread_id)
-  {
-    thread_timers[thread_id].start(); // Start the timer for the current thread
-
-    int min_cols_per_thread =
-        length_b / numThreads; // Minimum columns per thread
-    int excess_cols =
-        length_b %
-        numThreads; // Extra columns that can't be evenly distributed
-
-    int start_col;
-    int n_cols = min_cols_per_thread;
-    if (thread_id < excess_cols)
-    {
-      start_col =
-          thread_id * (min_cols_per_thread +
-                       1); // Assign extra column to threads with a smaller ID
-      n_cols++;
-    }
-    else
-    {
-      start_col = (thread_id * min_cols_per_thread) +
-                  excess_cols; // Distribute the remaining columns evenly
-    }
-    start_col +=
-        1; // Offset by 1 because the first column is initialized to zero
-    int end_col = std::min(
-        start_col + n_cols - 1,
-        matrix_width - 1); // Calculate the ending column for the thread
-
-    int row, col;
-    thread_row_indices[thread_id] = 1; // Set initial row index for the thread
-    for (row = 1; row < matrix_height; row++)
-    {
-      // If this is not the leftmost thread, wait until the thread to the left
-      // finishes processing the row
-      if (thread_id > 0)
-      {
-        if (thread_row_indices[thread_id - 1] <= row)
-        {
-          std::unique_lock<std::mutex> ulock(
-              mutex); // Lock the mutex to protect shared data
-          // Wait until the thread on the left is done with the current row
-          cv.wait(ulock, [this, &thread_id, &row]
-                  { return thread_row_indices[thread_id - 1] > row; });
-          ulock.unlock(); // Unlock after waiting
-        }
-      }
-
-      // Once the left neighbor is done, process the current row for the
-      // assigned columns
-      for (col = start_col; col <= end_col; col++)
-      {
-        computeCell(row, col); // Compute the LCS value for the current cell
-      }
-
-      thread_row_indices[thread_id] +=
-          1; // Update the row index for this thread
-
-      // Notify other threads that they can wake up and continue processing
-      cv.notify_all();
-    }
-
-    thread_times_taken[thread_id] =
-        thread_timers[thread_id]
-            .stop(); // Stop the timer for the current thread
-  }
-
-public:
-  // Constructor that initializes the LCS solver with the sequences and number
-  // of threads
-  LongestCommonSubsequenceParallel(const std::string &sequence_a,
-                                   const std::string &sequence_b, int threads)
-      : LongestCommonSubsequence(sequence_a, sequence_b),
-        numThreads(std::max(1, threads)), // Ensure at least one thread
-        thread_times_taken(numThreads, 0.0),
-        thread_timers(numThreads),
-        thread_row_indices(numThreads)
-  {
-  }
-
-  // Override the solve method to compute the LCS in parallel using threads
-  virtual void solve() override
-  {
-    solve_timer.start(); // Start the overall timer for LCS computation
-
-    // Launch a vector of threads to perform parallel LCS computation
-    std::vector<std::thread> threads(numThreads);
-    for (int i = 0; i < numThreads; i++)
-    {
-      threads[i] = std::thread(&LongestCommonSubsequenceParallel::solveParallel,
-                               this, i); // Start each thread
-    }
-
-    // Wait for all threads to finish their work
-    for (int i = 0; i < numThreads; i++)
-    {
-      threads[i].join(); // Join each thread to ensure they all complete before
-                         // proceeding
-    }
-
-    solve_time_taken = solve_timer.stop(); // Stop the overall timer
-
-    // After all threads have finished, determine the LCS based on the matrix
-    determineLongestCommonSubsequence();
-  }
-
-  // Print statistics related to each thread's execution time
-  void printThreadStats()
-  {
-    printf("\n-_-_-_-_-_-_-_ LCS Parallel Statistics _-_-_-_-_-_-_-\n\n");
-    printf("Thread ID || Time Taken\n");
-    for (int id = 0; id < numThreads; id++)
-    {
-      printf("%9d || %lf\n", id,
-             thread_times_taken[id]); // Print each thread's execution time
-    }
-    printf(
-        "Solve Time Taken: %f\n",
-        solve_time_taken); // Print the total time for solving the LCS problem
-  }
-};
-
 int main(int argc, char *argv[])
 {
   Timer program_timer; // Timer for measuring total program execution time
@@ -181,12 +32,56 @@ int main(int argc, char *argv[])
       {
           {"n_threads", "Number of threads for the program",
            cxxopts::value<int>()->default_value("1")}, // Default to 1 thread
+          {"tile_width", "Columns per tile (0 = whole strip).",
+           cxxopts::value<int>()->default_value("0")},
+          {"tile_height", "Rows per tile between thread synchronizations.",
+           cxxopts::value<int>()->default_value("1")},
+          {"strip_width", "Columns per strip; threads take strips in turn (0 = one strip per thread).",
+           cxxopts::value<int>()->default_value("0")},
+          {"parallel_traceback", "Trace the alignment back through every strip concurrently.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"orientation", "Sequence divided between the threads: auto (the longer one), keep (B) or transpose (A).",
+           cxxopts::value<std::string>()->default_value("auto")},
+          {"tuning_file", "Path to tuning .csv file written by lcs_tune.",
+           cxxopts::value<std::string>()->default_value(DEFAULT_TUNING_FILE)},
           {"sequence_a", "First input sequence.",
            cxxopts::value<std::string>()->default_value("")}, // First input sequence
           {"sequence_b", "Second input sequence.",
            cxxopts::value<std::string>()->default_value("")}, // Second input sequence
           {"input_file", "Path to input .csv file.",
-           cxxopts::value<std::string>()->default_value("")} // Input file.
+           cxxopts::value<std::string>()->default_value("")}, // Input file.
+          {"output_format", "Result format: text, binary, jsonl or edits.",
+           cxxopts::value<std::string>()->default_value("text")},
+          {"output_file", "Path to write binary or jsonl results to (default: stdout).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"alignment", "Include the alignment as runs of matches in binary or jsonl results.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"dump_matrix", "Write the matrix to this binary file, for lcs_matrix_view.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"checkpoint_file", "Save checkpoints of the fill to this file.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"checkpoint_interval", "Seconds between checkpoints.",
+           cxxopts::value<double>()->default_value("600")},
+          {"resume", "Continue from the checkpoint file, if it exists, without recomputing the rows above it.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"progress_interval", "Print progress to stderr every this many seconds (0 disables it).",
+           cxxopts::value<double>()->default_value("0")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+          {"scoring", "Recurrence to solve: lcs, weighted, global (Needleman-Wunsch) or local (Smith-Waterman).",
+           cxxopts::value<std::string>()->default_value("lcs")},
+          {"match", "Score of a match, for global and local scoring.",
+           cxxopts::value<int>()->default_value("1")},
+          {"mismatch", "Score of a mismatch, for global and local scoring.",
+           cxxopts::value<int>()->default_value("-1")},
+          {"gap", "Penalty per character aligned with a gap, for global and local scoring.",
+           cxxopts::value<int>()->default_value("1")},
+          {"weights", "Character weights for weighted scoring, as A:2,C:3 (others weigh 1).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"count_lcs", "Also count the distinct longest common subsequences.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"count_modulus", "Modulus of the count of distinct longest common subsequences.",
+           cxxopts::value<long long>()->default_value("1000000007")},
 
       });
 
@@ -194,11 +89,64 @@ int main(int argc, char *argv[])
   auto command_options = options.parse(argc, argv);
   int n_threads = command_options["n_threads"]
                       .as<int>(); // Get the number of threads from user input
+  int tile_width = command_options["tile_width"].as<int>();
+  int tile_height = command_options["tile_height"].as<int>();
+  int strip_width = command_options["strip_width"].as<int>();
+  bool parallel_traceback = command_options["parallel_traceback"].as<bool>();
+  std::string tuning_file = command_options["tuning_file"].as<std::string>();
 
   // Retrieve the input sequences from command-line arguments.
   std::string sequence_a = command_options["sequence_a"].as<std::string>();
   std::string sequence_b = command_options["sequence_b"].as<std::string>();
   std::string input_file = command_options["input_file"].as<std::string>();
+  LCSOutputFormat output_format;
+  if (!parseOutputFormat(command_options["output_format"].as<std::string>(), output_format))
+  {
+    std::cerr << "Error: unknown output format: "
+              << command_options["output_format"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  std::string output_file = command_options["output_file"].as<std::string>();
+  std::string dump_file = command_options["dump_matrix"].as<std::string>();
+  std::string checkpoint_file = command_options["checkpoint_file"].as<std::string>();
+  double checkpoint_interval = command_options["checkpoint_interval"].as<double>();
+  bool resume = command_options["resume"].as<bool>();
+  double progress_interval = command_options["progress_interval"].as<double>();
+  double time_limit = command_options["time_limit"].as<double>();
+  ScoringOptions scoring;
+  if (!parseScoringScheme(command_options["scoring"].as<std::string>(), scoring.scheme))
+  {
+    std::cerr << "Error: unknown scoring: "
+              << command_options["scoring"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  scoring.match = command_options["match"].as<int>();
+  scoring.mismatch = command_options["mismatch"].as<int>();
+  scoring.gap = command_options["gap"].as<int>();
+  if (!scoring.weights.parse(command_options["weights"].as<std::string>()))
+  {
+    std::cerr << "Error: malformed weights: "
+              << command_options["weights"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  bool count_lcs = command_options["count_lcs"].as<bool>();
+  long long count_modulus = command_options["count_modulus"].as<long long>();
+  if (count_lcs && (count_modulus < 2 || count_modulus > UINT32_MAX))
+  {
+    std::cerr << "Error: count modulus must be between 2 and " << UINT32_MAX << "." << std::endl;
+    exit(1);
+  }
+  if (count_lcs && scoring.scheme != LCS_SCORING_LCS)
+  {
+    std::cerr << "Error: only the LCS can be counted (--scoring=lcs)." << std::endl;
+    exit(1);
+  }
+  // A checkpoint holds the lengths but not the counts.
+  if (count_lcs && resume)
+  {
+    std::cerr << "Error: a count cannot be resumed from a checkpoint." << std::endl;
+    exit(1);
+  }
 
   if (input_file != "")
   {
@@ -212,27 +160,132 @@ int main(int argc, char *argv[])
     exit(1);
   }
 
+  /* Options that were not given on the command line are taken from the tuning
+  file, if one exists for this size class. */
+  TuningTable tuning_table;
+  if (tuning_table.load(tuning_file))
+  {
+    TuningConfig config =
+        tuning_table.lookup(sequence_a.length(), sequence_b.length());
+    if (!command_options.count("n_threads"))
+      n_threads = config.n_threads;
+    if (!command_options.count("tile_width"))
+      tile_width = config.tile_width;
+    if (!command_options.count("tile_height"))
+      tile_height = config.tile_height;
+    if (!command_options.count("strip_width"))
+      strip_width = config.strip_width;
+  }
+
+  LCSOrientation orientation;
+  if (!parseOrientation(command_options["orientation"].as<std::string>(), orientation))
+  {
+    std::cerr << "Error: unknown orientation: "
+              << command_options["orientation"].as<std::string>() << std::endl;
+    exit(1);
+  }
+
   // Validate that the number of threads is positive
   if (n_threads <= 0)
   {
     std::cerr << "Error: Number of threads must be greater than zero.\n";
     return 1;
   }
+  if (strip_width < 0)
+  {
+    std::cerr << "Error: strip width cannot be negative.\n";
+    return 1;
+  }
+
+  if (output_format != LCS_OUTPUT_TEXT)
+  {
+    // Only the result itself is written, so stdout can carry it.
+    std::unique_ptr<LongestCommonSubsequenceParallel> solver =
+        count_lcs ? makeCountedSolver<LongestCommonSubsequenceParallel>(
+                        count_modulus, sequence_a, sequence_b, n_threads, tile_width,
+                        tile_height, nullptr, orientation)
+                  : makeScoredSolver<LongestCommonSubsequenceParallel>(
+                        scoring, sequence_a, sequence_b, n_threads, tile_width,
+                        tile_height, nullptr, orientation);
+    LongestCommonSubsequenceParallel &lcs = *solver;
+    lcs.setStripWidth(strip_width);
+    lcs.setParallelTraceback(parallel_traceback);
+    configure_checkpoints(lcs, checkpoint_file, checkpoint_interval, resume);
+    lcs.enableProgress(progress_interval);
+    CancellationToken cancellation;
+    cancellation.setTimeLimit(time_limit);
+    lcs.setCancellationToken(&cancellation);
+    lcs.solve();
+    if (lcs.wasCancelled())
+    {
+      lcs.printCancelled(stderr);
+      return 2;
+    }
+    if (dump_file != "" && !lcs.dumpMatrix(dump_file))
+    {
+      std::cerr << "Error writing file: " << dump_file << std::endl;
+    }
+    if (!writeResult(output_file, output_format, lcs,
+                     command_options["alignment"].as<bool>()))
+    {
+      std::cerr << "Error writing file: " << output_file << std::endl;
+      exit(1);
+    }
+    return 0;
+  }
 
   // Print basic information about the parallel LCS run
   printf("_-_-_-_-_-_-_-_-_ LCS Parallel _-_-_-_-_-_-_-_-_\n");
   printf("Number of Threads: %d\n", n_threads);
+  printf("Tile Size: %d x %d\n", tile_width, tile_height);
+  if (strip_width > 0)
+  {
+    printf("Strip Width: %d\n", strip_width);
+  }
   printf("Initializing Parallel Solver\n");
 
   // Create and solve the LCS problem with the specified number of threads
-  LongestCommonSubsequenceParallel lcs(sequence_a, sequence_b, n_threads);
+  std::unique_ptr<LongestCommonSubsequenceParallel> solver =
+      count_lcs ? makeCountedSolver<LongestCommonSubsequenceParallel>(
+                      count_modulus, sequence_a, sequence_b, n_threads, tile_width,
+                      tile_height, nullptr, orientation)
+                : makeScoredSolver<LongestCommonSubsequenceParallel>(
+                      scoring, sequence_a, sequence_b, n_threads, tile_width,
+                      tile_height, nullptr, orientation);
+  LongestCommonSubsequenceParallel &lcs = *solver;
+  if (lcs.isTransposed())
+  {
+    printf("Transposed: sequence A is divided between the threads\n");
+  }
+  lcs.setStripWidth(strip_width);
+  lcs.setParallelTraceback(parallel_traceback);
+
+  configure_checkpoints(lcs, checkpoint_file, checkpoint_interval, resume);
+  lcs.enableProgress(progress_interval);
+  CancellationToken cancellation;
+  cancellation.setTimeLimit(time_limit);
+  lcs.setCancellationToken(&cancellation);
 
   printf("Starting LCS Parallel Solver\n");
   lcs.solve(); // Compute the LCS using parallel threads
   total_time_taken =
       program_timer.stop(); // Stop the program timer after solving
+
+  if (lcs.wasCancelled())
+  {
+    // There is no result, only how far each thread got.
+    printf("LCS Parallel Solver Cancelled\n\n");
+    lcs.printCancelled(stdout);
+    lcs.printThreadStats();
+    return 2;
+  }
   printf("LCS Parallel Solver Finished\n\n");
 
+  if (dump_file != "" && !lcs.dumpMatrix(dump_file))
+  {
+    std::cerr << "Error writing file: " << dump_file << std::endl;
+  }
+
   // Print the results and performance statistics
   printf("-_-_-_-_-_-_-_ LCS Parallel Results _-_-_-_-_-_-_-\n");
   lcs.printInfo();
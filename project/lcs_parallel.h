@@ -0,0 +1,694 @@
+#ifndef _LCS_PARALLEL_H_
+#define _LCS_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lcs.h" // Header file containing the LongestCommonSubsequence class
+#include "thread_pool.h"
+
+// Derived class for parallel computation of Longest Common Subsequence (LCS)
+class LongestCommonSubsequenceParallel : public LongestCommonSubsequence
+{
+protected:
+  int numThreads; // Number of threads to be used for parallel computation
+  int tile_width;  // Columns per tile within a thread's strip (0 = whole strip)
+  int tile_height; // Rows computed by a thread before it notifies its neighbor
+  int strip_width; // Columns per strip, dealt out in turn (0 = one per thread)
+  int n_strips;    // Number of strips the columns are divided into
+  std::vector<double>
+      thread_times_taken; // Vector to store the time taken by each thread
+
+  double solve_time_taken; // Time taken to compute the overall LCS
+  std::vector<Timer>
+      thread_timers; // Timer objects to measure each thread's execution time
+  Timer solve_timer; // Timer for the overall solve process
+
+  std::vector<std::atomic<int>>
+      strip_row_indices; // Atomic indices of the next row of each strip, to
+                         // ensure safe row updates by each thread
+
+  std::condition_variable
+      cv;           // Condition variable used for thread synchronization
+  std::mutex mutex; // Mutex to protect the condition variable and ensure safe
+                    // synchronization
+
+  ThreadPool *thread_pool = nullptr; // Optional pool of already running threads
+
+  /* Set by the first strip to notice that the solve was cancelled. The other
+  strips stop at their next block, and waiting strips are woken up. */
+  std::atomic<bool> stopping;
+
+  /* Rows [strip_first_rows[i], strip_end_rows[i]) of strip i are filled in
+  the next run of the strips. */
+  std::vector<int> strip_first_rows;
+  std::vector<int> strip_end_rows;
+
+  /* Trace the alignment back through every strip concurrently instead of
+  walking the whole path on one thread. */
+  bool parallel_traceback = false;
+  double traceback_time_taken = 0.0;
+  long long retraced_steps = 0; // Steps retraced after the guesses.
+
+  // A move of the traceback, from cell (i, j), as its edit.
+  struct PathStep
+  {
+    int i;
+    int j;
+    char op;
+  };
+
+  /* The part of the traceback path inside one strip. */
+  struct StripTrace
+  {
+    int entry_row; // Row where the path enters the strip's last column.
+    int exit_row;  // Row where it leaves, in the column left of the strip.
+    std::vector<PathStep> steps; // Moves taken, from the last to the first.
+    // Rows of the path in each column of the strip; the path is monotone, so
+    // it visits a contiguous range of rows in each column (-1 if none).
+    std::vector<int> first_rows;
+    std::vector<int> last_rows;
+  };
+
+  // Calculates the columns of the given strip
+  void stripColumns(int strip, int &start_col, int &end_col) const
+  {
+    if (strip_width > 0)
+    {
+      // Narrow strips of strip_width columns, the last one possibly narrower
+      start_col = strip * strip_width + 1;
+      end_col = std::min(start_col + strip_width - 1, matrix_width - 1);
+      return;
+    }
+
+    int min_cols_per_thread =
+        length_b / numThreads; // Minimum columns per thread
+    int excess_cols =
+        length_b %
+        numThreads; // Extra columns that can't be evenly distributed
+
+    int n_cols = min_cols_per_thread;
+    if (strip < excess_cols)
+    {
+      start_col =
+          strip * (min_cols_per_thread +
+                   1); // Assign extra column to threads with a smaller ID
+      n_cols++;
+    }
+    else
+    {
+      start_col = (strip * min_cols_per_thread) +
+                  excess_cols; // Distribute the remaining columns evenly
+    }
+    start_col +=
+        1; // Offset by 1 because the first column is initialized to zero
+    end_col = std::min(
+        start_col + n_cols - 1,
+        matrix_width - 1); // Calculate the ending column for the thread
+  }
+
+  // Computes the rows of one strip of the matrix, block by block, each block
+  // once the strip to the left has finished it
+  void fillStrip(int strip)
+  {
+    int start_col, end_col;
+    stripColumns(strip, start_col, end_col);
+    int n_cols = end_col - start_col + 1;
+
+    // A tile width of 0 covers the whole strip in a single tile.
+    int tile_cols = tile_width > 0 ? tile_width : std::max(1, n_cols);
+
+    int row;
+    for (int block_start = strip_first_rows[strip];
+         block_start < strip_end_rows[strip]; block_start += tile_height)
+    {
+      int block_end = std::min(block_start + tile_height, strip_end_rows[strip]);
+
+      if (stopping || cancellationRequested())
+      {
+        stopStrips();
+        break;
+      }
+
+      // If this is not the leftmost strip, wait until the strip to the left
+      // has every row of this block
+      if (strip > 0)
+      {
+        if (strip_row_indices[strip - 1] < block_end)
+        {
+          std::unique_lock<std::mutex> ulock(
+              mutex); // Lock the mutex to protect shared data
+          // Wait until the strip on the left is done with the current block,
+          // or the solve is cancelled
+          cv.wait(ulock, [this, &strip, &block_end]
+                  { return strip_row_indices[strip - 1] >= block_end ||
+                           stopping; });
+          ulock.unlock(); // Unlock after waiting
+        }
+        if (stopping)
+          break;
+      }
+
+      // Once the left neighbor is done, process the block one tile at a time
+      // so that the rows of a tile stay in cache
+      for (int tile_start = start_col; tile_start <= end_col;
+           tile_start += tile_cols)
+      {
+        int tile_end = std::min(tile_start + tile_cols - 1, end_col);
+        for (row = block_start; row < block_end; row++)
+        {
+          computeRow(row, tile_start, tile_end); // Compute the LCS values for the tile's row
+        }
+      }
+
+      strip_row_indices[strip] =
+          block_end; // Update the row index for this strip
+
+      // Notify other threads that they can wake up and continue processing.
+      // Taking the lock first ensures a waiting neighbor cannot miss the update.
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+      }
+      cv.notify_all();
+    }
+  }
+
+  // Function executed by each thread to compute the LCS for a portion of the
+  // matrix: strips thread_id, thread_id + numThreads, ... in order. With
+  // narrow strips, every thread starts on row 1 after only thread_id narrow
+  // strips instead of thread_id full strip widths, and the threads also
+  // finish close together.
+  void solveParallel(int thread_id)
+  {
+    thread_timers[thread_id].start(); // Start the timer for the current thread
+
+    for (int strip = thread_id; strip < n_strips; strip += numThreads)
+    {
+      fillStrip(strip);
+    }
+
+    thread_times_taken[thread_id] +=
+        thread_timers[thread_id]
+            .stop(); // Stop the timer for the current thread
+  }
+
+  // Stops every strip at its next block, including strips that are waiting
+  // for their neighbor
+  void stopStrips()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+  }
+
+  // Runs solveParallel on every strip and waits for all of them to finish
+  void runStrips()
+  {
+    if (thread_pool)
+    {
+      // Run the strips on the pool, one task per strip. Strips are handed out
+      // left to right, so a strip only ever waits for a strip that is already
+      // being computed, however many strips each thread ends up with.
+      thread_pool->run(n_strips, [this](int strip)
+                       { fillStrip(strip); });
+    }
+    else
+    {
+      // Launch a vector of threads to perform parallel LCS computation
+      std::vector<std::thread> threads(numThreads);
+      for (int i = 0; i < numThreads; i++)
+      {
+        threads[i] = std::thread(&LongestCommonSubsequenceParallel::solveParallel,
+                                 this, i); // Start each thread
+      }
+
+      // Wait for all threads to finish their work
+      for (int i = 0; i < numThreads; i++)
+      {
+        threads[i].join(); // Join each thread to ensure they all complete before
+                           // proceeding
+      }
+    }
+  }
+
+  /* Runs task(0) ... task(n_tasks - 1) on the pool, or on numThreads new
+  threads that take the tasks in turn. The tasks must not wait for each
+  other. */
+  void runTasks(const int n_tasks, const std::function<void(int)> &task)
+  {
+    if (thread_pool)
+    {
+      thread_pool->run(n_tasks, task);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < std::min(numThreads, n_tasks); t++)
+    {
+      threads.emplace_back([this, t, n_tasks, &task]()
+                           {
+        for (int k = t; k < n_tasks; k += numThreads)
+        {
+          task(k);
+        } });
+    }
+    for (std::thread &thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+  /* Traces the path through a strip from the given row of its last column,
+  until it leaves the strip on the left or reaches the top row. */
+  void traceStrip(const int strip, const int entry_row, StripTrace &trace) const
+  {
+    int start_col, end_col;
+    stripColumns(strip, start_col, end_col);
+    int n_cols = std::max(0, end_col - start_col + 1);
+    trace.entry_row = entry_row;
+    trace.steps.clear();
+    trace.first_rows.assign(n_cols, -1);
+    trace.last_rows.assign(n_cols, -1);
+    int i = entry_row, j = end_col;
+    while (i > 0 && j >= start_col)
+    {
+      if (trace.last_rows[j - start_col] < 0)
+        trace.last_rows[j - start_col] = i;
+      trace.first_rows[j - start_col] = i;
+      PathStep step{i, j, 0};
+      step.op = editOp(tracebackStep(i, j));
+      trace.steps.push_back(step);
+    }
+    trace.exit_row = i;
+  }
+
+  /* Corrects the trace of a strip that was started from a guessed row, now
+  that the real entry row is known. The path from the real entry is followed
+  only until it meets the guessed path: the step taken from a cell does not
+  depend on how the path got there, so from then on the two are the same.
+  Returns the number of steps taken. */
+  long long retraceStrip(const int strip, const int entry_row, StripTrace &trace) const
+  {
+    if (entry_row == trace.entry_row)
+      return 0;
+
+    int start_col, end_col;
+    stripColumns(strip, start_col, end_col);
+    std::vector<PathStep> steps;
+    long long n_steps = 0;
+    int i = entry_row, j = end_col;
+    for (; i > 0 && j >= start_col; n_steps++)
+    {
+      int k = j - start_col;
+      if (trace.last_rows[k] >= 0 && trace.first_rows[k] <= i && i <= trace.last_rows[k])
+      {
+        // Keep the guessed path's moves from this cell on.
+        for (const PathStep &step : trace.steps)
+        {
+          if (step.i <= i && step.j <= j)
+            steps.push_back(step);
+        }
+        trace.steps.swap(steps);
+        trace.entry_row = entry_row;
+        return n_steps;
+      }
+      PathStep step{i, j, 0};
+      step.op = editOp(tracebackStep(i, j));
+      steps.push_back(step);
+    }
+    trace.steps.swap(steps);
+    trace.entry_row = entry_row;
+    trace.exit_row = i;
+    return n_steps;
+  }
+
+  /* Finds the same alignment as the serial traceback with every strip traced
+  concurrently. The path enters the last strip at the bottom-right corner;
+  every other strip starts from a guess of where the path crosses into it,
+  the row of the matrix's diagonal at its last column. Then, from right to
+  left, each strip's real entry row is the exit row of the strip to its
+  right, and a strip that was guessed wrong is retraced from the real row
+  until it joins its guessed path, which is usually within a few steps. */
+  void tracebackParallel()
+  {
+    Timer traceback_timer;
+    traceback_timer.start();
+
+    std::vector<StripTrace> traces(n_strips);
+    runTasks(n_strips, [this, &traces](int strip)
+             {
+      int start_col, end_col;
+      stripColumns(strip, start_col, end_col);
+      int entry_row = strip == n_strips - 1
+                          ? matrix_height - 1
+                          : (int)((long long)(matrix_height - 1) * end_col / (matrix_width - 1));
+      traceStrip(strip, entry_row, traces[strip]); });
+
+    retraced_steps = 0;
+    for (int strip = n_strips - 2; strip >= 0; strip--)
+    {
+      retraced_steps += retraceStrip(strip, traces[strip + 1].exit_row, traces[strip]);
+    }
+
+    // The strips' moves, from the leftmost strip to the rightmost. The path
+    // starts where the first of them leads, and the rest of both sequences
+    // before it is deleted and inserted.
+    score = matrix[matrix_height - 1][matrix_width - 1];
+    match_runs.clear();
+    edit_runs.clear();
+    longest_common_subsequence.clear();
+    bool started = false;
+    for (int strip = 0; strip < n_strips; strip++)
+    {
+      const std::vector<PathStep> &steps = traces[strip].steps;
+      for (auto it = steps.rbegin(); it != steps.rend(); ++it)
+      {
+        int i = it->i - (it->op != 'I');
+        int j = it->j - (it->op != 'D');
+        if (!started)
+        {
+          appendEditRun(edit_runs, EditRun{i, 'D'});
+          appendEditRun(edit_runs, EditRun{j, 'I'});
+          started = true;
+        }
+        appendEditRun(edit_runs, EditRun{1, it->op});
+        if (it->op == '=')
+        {
+          appendMatchRun(match_runs, MatchRun{i, j, 1});
+          longest_common_subsequence += sequence_a[i];
+        }
+      }
+    }
+    orientMatchRuns();
+    traceback_time_taken = traceback_timer.stop();
+  }
+
+  virtual void determineLongestCommonSubsequence() override
+  {
+    // The strips are traced from guessed rows, which may be unfilled after
+    // a resume, so that traceback goes the serial way.
+    if (parallel_traceback && n_strips > 1 && !localAlignment() &&
+        first_filled_rows.empty())
+    {
+      tracebackParallel();
+      return;
+    }
+    Timer traceback_timer;
+    traceback_timer.start();
+    LongestCommonSubsequence::determineLongestCommonSubsequence();
+    traceback_time_taken = traceback_timer.stop();
+  }
+
+  /* Takes a consistent snapshot of the frontier while the threads are running.
+  A strip never gets ahead of the strip to its left, so reading the progress
+  from right to left gives every strip a completed row at least as far down
+  as the strip to its right, and everything up to those rows is final. */
+  Checkpoint snapshotFrontier()
+  {
+    Checkpoint checkpoint = emptyCheckpoint();
+    checkpoint.strips.resize(n_strips);
+    int right_row = 0; // Completed row of the strip to the right.
+    for (int i = n_strips - 1; i >= 0; i--)
+    {
+      int start_col, end_col;
+      stripColumns(i, start_col, end_col);
+      int row = strip_row_indices[i] - 1;
+      // The last strip has no neighbor waiting for its last column.
+      int edge_first_row = i == n_strips - 1 ? row + 1 : right_row;
+      checkpoint.strips[i] = snapshotStrip(start_col, end_col, row, edge_first_row);
+      right_row = row;
+    }
+    return checkpoint;
+  }
+
+  /* Counts the cells completed so far from the progress of every strip. */
+  long long completedCells()
+  {
+    long long n_cells = 0;
+    for (int i = 0; i < n_strips; i++)
+    {
+      int start_col, end_col;
+      stripColumns(i, start_col, end_col);
+      n_cells += (long long)(strip_row_indices[i] - 1) * (end_col - start_col + 1);
+    }
+    return n_cells;
+  }
+
+  virtual bool checkpointFits(const Checkpoint &checkpoint) const override
+  {
+    if ((int)checkpoint.strips.size() != n_strips)
+      return false;
+    for (int i = 0; i < n_strips; i++)
+    {
+      int start_col, end_col;
+      stripColumns(i, start_col, end_col);
+      if (!stripFits(checkpoint.strips[i], start_col, end_col))
+        return false;
+    }
+    return true;
+  }
+
+public:
+  // Constructor that initializes the LCS solver with the sequences and number
+  // of threads. By default, the longer sequence is divided between the
+  // threads (see shouldTranspose()).
+  LongestCommonSubsequenceParallel(const Sequence &sequence_a,
+                                   const Sequence &sequence_b, int threads,
+                                   int tile_width = 0, int tile_height = 1,
+                                   Arena *arena = nullptr,
+                                   LCSOrientation orientation = LCS_ORIENTATION_AUTO)
+      : LongestCommonSubsequence(sequence_a, sequence_b, arena,
+                                 shouldTranspose(orientation, sequence_a.length(),
+                                                 sequence_b.length(),
+                                                 std::max(1, threads))),
+        numThreads(std::max(1, threads)), // Ensure at least one thread
+        tile_width(std::max(0, tile_width)),
+        tile_height(std::max(1, tile_height)),
+        strip_width(0),
+        n_strips(numThreads),
+        thread_times_taken(numThreads, 0.0),
+        thread_timers(numThreads),
+        strip_row_indices(numThreads),
+        stopping(false),
+        strip_first_rows(numThreads),
+        strip_end_rows(numThreads)
+  {
+  }
+
+  // Override the solve method to compute the LCS in parallel using threads
+  virtual void solve() override
+  {
+    solve_timer.start(); // Start the overall timer for LCS computation
+    timer.start();
+
+    for (int i = 0; i < numThreads; i++)
+    {
+      thread_times_taken[i] = 0.0;
+    }
+    for (int i = 0; i < n_strips; i++)
+    {
+      strip_first_rows[i] = 1;
+      strip_end_rows[i] = matrix_height;
+    }
+    // Continue each strip from the row saved in the checkpoint, if resuming.
+    if (resuming)
+    {
+      for (int i = 0; i < n_strips; i++)
+      {
+        restoreStrip(resume_checkpoint.strips[i]);
+        strip_first_rows[i] = resume_checkpoint.strips[i].row + 1;
+      }
+      resuming = false;
+    }
+    std::vector<int> resumed_rows = strip_first_rows;
+    // Rows above the first row of each strip are already complete
+    for (int i = 0; i < n_strips; i++)
+    {
+      strip_row_indices[i] = strip_first_rows[i];
+    }
+
+    stopping = false;
+
+    // Save checkpoints from a separate thread, so the strips never wait for it.
+    std::thread checkpointer;
+    bool fill_done = false;
+    std::mutex checkpoint_mutex;
+    std::condition_variable checkpoint_cv;
+    if (checkpoint_path != "")
+    {
+      checkpointer = std::thread([&]()
+                                 {
+        std::unique_lock<std::mutex> lock(checkpoint_mutex);
+        while (!checkpoint_cv.wait_for(
+            lock, std::chrono::duration<double>(checkpoint_interval),
+            [&] { return fill_done; }))
+        {
+          saveCheckpoint(snapshotFrontier(), checkpoint_path);
+        } });
+    }
+
+    ProgressReporter progress(progress_interval, (long long)length_a * length_b,
+                              [this]()
+                              { return completedCells(); });
+    runStrips();
+    progress.stop();
+    completed_cells = completedCells();
+
+    if (checkpoint_path != "")
+    {
+      {
+        std::lock_guard<std::mutex> lock(checkpoint_mutex);
+        fill_done = true;
+      }
+      checkpoint_cv.notify_all();
+      checkpointer.join();
+    }
+
+    // The refill below starts the strips over, so keep the frontier of the
+    // main fill for the checkpoint of a cancelled solve.
+    std::vector<int> filled_rows(n_strips);
+    for (int i = 0; i < n_strips; i++)
+    {
+      filled_rows[i] = strip_row_indices[i];
+    }
+
+    // The rows above a checkpoint were not saved. The traceback aligns that
+    // part of the sequences in linear space, so it only needs to know where
+    // each strip's saved rows start: its last completed row, and further up
+    // in its last column, the part the strip to its right had not read yet.
+    bool refill = false;
+    for (int i = 0; i < n_strips; i++)
+    {
+      refill |= resumed_rows[i] > 2;
+    }
+    first_filled_rows.clear();
+    if (refill && !stopping && tracesUnfilledRows())
+    {
+      first_filled_rows.assign(matrix_width, 0);
+      for (int i = 0; i < n_strips; i++)
+      {
+        int start_col, end_col;
+        stripColumns(i, start_col, end_col);
+        for (int j = start_col; j <= end_col; j++)
+        {
+          first_filled_rows[j] = resumed_rows[i] - 1;
+        }
+        const CheckpointStrip &strip = resume_checkpoint.strips[i];
+        if (end_col >= start_col && !strip.edge_values.empty())
+        {
+          first_filled_rows[end_col] = std::min(first_filled_rows[end_col],
+                                                strip.edge_first_row);
+        }
+      }
+      refill = false;
+    }
+
+    // Otherwise the recurrence needs the rows recomputed. Every strip has at
+    // least the rows the strip to its right needs, so the same wavefront
+    // works for the refill.
+    for (int i = 0; i < n_strips; i++)
+    {
+      strip_end_rows[i] = resumed_rows[i] - 1;
+      strip_first_rows[i] = 1;
+      strip_row_indices[i] = 1;
+    }
+    if (refill && !stopping)
+    {
+      runStrips();
+    }
+    cancelled = stopping;
+
+    solve_time_taken = solve_timer.stop(); // Stop the overall timer
+    matrix_time_taken = solve_time_taken;
+
+    // A cancelled solve leaves a checkpoint of its frontier, so that it can be
+    // resumed later.
+    if (checkpoint_path != "")
+    {
+      if (cancelled)
+      {
+        for (int i = 0; i < n_strips; i++)
+        {
+          strip_row_indices[i] = filled_rows[i];
+        }
+        saveCheckpoint(snapshotFrontier(), checkpoint_path);
+      }
+      else
+      {
+        remove(checkpoint_path.c_str());
+      }
+    }
+    if (cancelled)
+    {
+      finishCancelled();
+      return;
+    }
+
+    // After all threads have finished, determine the LCS based on the matrix
+    determineLongestCommonSubsequence();
+    time_taken = timer.stop();
+  }
+
+  /* Divides the columns into strips of `width` columns that the threads take
+  in turn, instead of one strip per thread. A width of 0 goes back to one
+  strip per thread. Must be called before resumeFrom() and solve(). */
+  void setStripWidth(int width)
+  {
+    strip_width = std::max(0, width);
+    n_strips = strip_width > 0 ? std::max(1, (length_b + strip_width - 1) / strip_width)
+                               : numThreads;
+    strip_row_indices = std::vector<std::atomic<int>>(n_strips);
+    strip_first_rows.assign(n_strips, 1);
+    strip_end_rows.assign(n_strips, matrix_height);
+  }
+
+  /* Traces the alignment of subsequent solves back through every strip
+  concurrently, instead of on one thread after the fill. */
+  void setParallelTraceback(bool enabled)
+  {
+    parallel_traceback = enabled;
+  }
+
+  /* Runs the threads of subsequent solves on the given pool instead of
+  starting new ones. The pool must outlive the solver. */
+  void setThreadPool(ThreadPool *pool)
+  {
+    thread_pool = pool;
+  }
+
+  double getSolveTimeTaken() const
+  {
+    return solve_time_taken;
+  }
+
+  // Print statistics related to each thread's execution time
+  void printThreadStats()
+  {
+    printf("\n-_-_-_-_-_-_-_ LCS Parallel Statistics _-_-_-_-_-_-_-\n\n");
+    printf("Thread ID || Time Taken\n");
+    for (int id = 0; id < numThreads; id++)
+    {
+      printf("%9d || %lf\n", id,
+             thread_times_taken[id]); // Print each thread's execution time
+    }
+    printf("Traceback Time Taken: %f\n", traceback_time_taken);
+    if (parallel_traceback && n_strips > 1 && !localAlignment())
+    {
+      printf("Steps Retraced on One Thread: %lld\n", retraced_steps);
+    }
+    printf(
+        "Solve Time Taken: %f\n",
+        solve_time_taken); // Print the total time for solving the LCS problem
+  }
+};
+
+#endif
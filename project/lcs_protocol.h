@@ -0,0 +1,64 @@
+#ifndef _LCS_PROTOCOL_H_
+#define _LCS_PROTOCOL_H_
+
+#include <stdint.h>
+
+/**
+ * Binary protocol spoken by lcs_server over its Unix domain socket. All
+ * integers are in the byte order of the host, since both ends of a Unix
+ * socket run on the same machine.
+ *
+ * A client sends any number of requests on a connection:
+ *
+ *   LCSRequestHeader
+ *   n_pairs times: LCSPairHeader, length_a bytes of A, length_b bytes of B
+ *
+ * For every pair the server streams back one response as soon as it has been
+ * solved, so responses of a batch may arrive out of order:
+ *
+ *   LCSResponseHeader, then n_bytes bytes of the LCS (LCS_MODE_STRING only)
+ */
+
+#define LCS_REQUEST_MAGIC 0x5253434c  // "LCSR"
+#define LCS_RESPONSE_MAGIC 0x4153434c // "LCSA"
+
+/* What the client wants back for each pair. */
+enum
+{
+  LCS_MODE_LENGTH = 0, // Only the length of the LCS.
+  LCS_MODE_STRING = 1  // The length and the LCS itself.
+};
+
+/* Status of a single response. */
+enum
+{
+  LCS_STATUS_OK = 0,
+  LCS_STATUS_ERROR = 1,    // Unknown mode, or a pair over the server's max_cells.
+  LCS_STATUS_CANCELLED = 2 // The solve ran past the server's time limit.
+};
+
+struct LCSRequestHeader
+{
+  uint32_t magic;      // LCS_REQUEST_MAGIC
+  uint32_t request_id; // Chosen by the client, echoed in the responses.
+  uint32_t n_pairs;    // 1 for a single pair, more for a batch.
+  uint32_t mode;       // LCS_MODE_LENGTH or LCS_MODE_STRING.
+};
+
+struct LCSPairHeader
+{
+  uint32_t length_a;
+  uint32_t length_b;
+};
+
+struct LCSResponseHeader
+{
+  uint32_t magic;      // LCS_RESPONSE_MAGIC
+  uint32_t request_id;
+  uint32_t pair_index; // Position of the pair within its request.
+  uint32_t status;     // LCS_STATUS_OK or LCS_STATUS_ERROR.
+  uint32_t length;     // Length of the LCS.
+  uint32_t n_bytes;    // Number of LCS bytes that follow.
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <string>
+
+#include "cxxopts.hpp"  // Command-line option parser library
+#include "lcs_output.h" // Binary and JSONL result formats
+#include "lcs_rle.h"    // Header file containing the LongestCommonSubsequenceRLE class
+
+// ***
+//  This is the run-length encoded version of the LCS program, for highly
+//  repetitive sequences. It compresses the sequences into runs of equal
+//  characters and computes the matrix a pair of runs at a time.
+// ***
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_rle",
+                           "LCS program for CMPT 431 project using run-length encoding");
+
+  options.add_options(
+      "inputs",
+      {
+          {"n_threads", "Number of threads for the fallback solver",
+           cxxopts::value<int>()->default_value("1")},
+          {"min_run_length", "Solve without the runs if their mean length is below this (-1 = default for the mode).",
+           cxxopts::value<double>()->default_value("-1")},
+          {"length_only", "Find only the length, keeping one row and column of blocks.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"sequence_a", "First input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_b", "Second input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"input_file", "Path to input .csv file.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"output_format", "Result format: text, binary, jsonl or edits.",
+           cxxopts::value<std::string>()->default_value("text")},
+          {"output_file", "Path to write binary or jsonl results to (default: stdout).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"alignment", "Include the alignment as runs of matches in binary or jsonl results.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  int n_threads = command_options["n_threads"].as<int>();
+  double min_run_length = command_options["min_run_length"].as<double>();
+  bool length_only = command_options["length_only"].as<bool>();
+
+  std::string sequence_a = command_options["sequence_a"].as<std::string>();
+  std::string sequence_b = command_options["sequence_b"].as<std::string>();
+  std::string input_file = command_options["input_file"].as<std::string>();
+  LCSOutputFormat output_format;
+  if (!parseOutputFormat(command_options["output_format"].as<std::string>(), output_format))
+  {
+    std::cerr << "Error: unknown output format: "
+              << command_options["output_format"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  std::string output_file = command_options["output_file"].as<std::string>();
+  double time_limit = command_options["time_limit"].as<double>();
+
+  if (input_file != "")
+  {
+    // Read sequences from .csv file if file path was provided.
+    read_input_csv(input_file, sequence_a, sequence_b);
+  }
+
+  if (sequence_a.length() < 1 || sequence_b.length() < 1)
+  {
+    std::cerr << "Error: sequences cannot be empty." << std::endl;
+    exit(1);
+  }
+  if (n_threads <= 0)
+  {
+    std::cerr << "Error: Number of threads must be greater than zero.\n";
+    return 1;
+  }
+  if (length_only && (output_format == LCS_OUTPUT_EDITS ||
+                      command_options["alignment"].as<bool>()))
+  {
+    std::cerr << "Error: --length_only finds no alignment to write.\n";
+    return 1;
+  }
+  if (min_run_length < 0)
+  {
+    // The bit-parallel kernel computes 64 cells per word, so the runs must be
+    // much longer to beat it than to beat the full matrix.
+    min_run_length = length_only ? LCS_RLE_MIN_RUN_LENGTH_ONLY : LCS_RLE_MIN_RUN_LENGTH;
+  }
+
+  LongestCommonSubsequenceRLE lcs(sequence_a, sequence_b, n_threads, min_run_length,
+                                  length_only);
+  CancellationToken cancellation;
+  cancellation.setTimeLimit(time_limit);
+  lcs.setCancellationToken(&cancellation);
+
+  if (output_format != LCS_OUTPUT_TEXT)
+  {
+    lcs.solve();
+    if (lcs.wasCancelled())
+    {
+      fprintf(stderr, "Solve cancelled after %lf seconds\n", lcs.getTimeTaken());
+      return 2;
+    }
+    // Plain LCS, so the score is the length.
+    int length = lcs.getLongestSubsequenceLength();
+    if (!writeResult(output_file, output_format, lcs.getLengthA(), lcs.getLengthB(),
+                     length, length, lcs.getMatrixTimeTaken(),
+                     lcs.getTimeTaken(),
+                     command_options["alignment"].as<bool>() ? &lcs.getMatchRuns() : NULL,
+                     &lcs.getEditScript()))
+    {
+      std::cerr << "Error writing file: " << output_file << std::endl;
+      exit(1);
+    }
+    return 0;
+  }
+
+  printf("_-_-_-_-_-_-_-_-_ LCS Run-Length _-_-_-_-_-_-_-_-_\n");
+  printf("Number of Threads: %d\n", n_threads);
+  printf("Mode: %s\n", length_only ? "length only" : "alignment");
+  printf("Starting LCS Run-Length Solver\n");
+  lcs.solve();
+
+  if (lcs.wasCancelled())
+  {
+    printf("LCS Run-Length Solver Cancelled\n\n");
+    printf("Solve cancelled after %lf seconds\n", lcs.getTimeTaken());
+    return 2;
+  }
+  printf("LCS Run-Length Solver Finished\n\n");
+
+  printf("-_-_-_-_-_-_-_ LCS Run-Length Results _-_-_-_-_-_-_-\n");
+  lcs.printInfo();
+  lcs.printRunStats();
+
+  return 0;
+}
@@ -0,0 +1,422 @@
+#ifndef _LCS_RLE_H_
+#define _LCS_RLE_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "bit_parallel.h"
+#include "lcs.h"
+#include "lcs_parallel.h"
+#include "thread_pool.h"
+
+/* Default mean run lengths below which the runs are not used, for the
+alignment and for the length only. */
+#define LCS_RLE_MIN_RUN_LENGTH 4
+#define LCS_RLE_MIN_RUN_LENGTH_ONLY 64
+
+/* A sequence as runs of equal characters: run k is lengths[k] copies of
+characters[k], starting at starts[k]. */
+struct RunLengthSequence
+{
+  std::string characters;
+  std::vector<int> lengths;
+  std::vector<int> starts;
+
+  explicit RunLengthSequence(const std::string &sequence)
+  {
+    for (int k = 0; k < (int)sequence.length(); k++)
+    {
+      if (k > 0 && sequence[k] == sequence[k - 1])
+      {
+        lengths.back()++;
+        continue;
+      }
+      characters += sequence[k];
+      lengths.push_back(1);
+      starts.push_back(k);
+    }
+  }
+
+  int n_runs() const
+  {
+    return characters.length();
+  }
+};
+
+/* Fills the bottom row and right column of a block of the LCS matrix whose
+rows are p copies of a and whose columns are q copies of b, from its top row
+and left column. top has q + 1 values and left p + 1, both starting at the
+block's top-left corner, and so do bottom and right.
+
+Along a row or column of the matrix the LCS grows by at most 1 per cell, so
+the best way into a cell from the top row or left column of the block is
+known without searching: if a == b, every cell of the block matches, and the
+path enters as late as it can while still going straight along the diagonal;
+otherwise no cell matches, and the path goes straight up or straight left. */
+inline void computeRunBlock(const char a, const int p, const char b, const int q,
+                            const int *top, const int *left, int *bottom, int *right)
+{
+  if (a != b)
+  {
+    for (int r = 0; r <= p; r++)
+    {
+      right[r] = std::max(top[q], left[r]);
+    }
+    for (int s = 0; s <= q; s++)
+    {
+      bottom[s] = std::max(top[s], left[p]);
+    }
+    return;
+  }
+  for (int r = 0; r <= p; r++)
+  {
+    int diagonal = std::min(r, q);
+    right[r] = std::max(top[q - diagonal], left[r - diagonal]) + diagonal;
+  }
+  for (int s = 0; s <= q; s++)
+  {
+    int diagonal = std::min(s, p);
+    bottom[s] = std::max(top[s - diagonal], left[p - diagonal]) + diagonal;
+  }
+}
+
+/**
+ * @brief Finds the LCS of run-length encoded sequences, a run at a time.
+ *
+ * Both sequences are compressed into runs of equal characters as they are
+ * loaded, which divides the matrix into blocks of one run of each. A block
+ * is either all matches or all mismatches, so its bottom row and right
+ * column follow from its top row and left column in O(p + q) time for a
+ * block of p x q cells (see computeRunBlock()), and the cells inside it are
+ * never computed. The whole fill takes
+ *
+ *   O(runs_a * length_b + runs_b * length_a)
+ *
+ * time instead of O(length_a * length_b), which for homopolymers and tandem
+ * repeats is many times less.
+ *
+ * The block boundaries are kept, O(runs_a * length_b + runs_b * length_a)
+ * values, and the alignment is traced back through them: straight along the
+ * diagonal of a matching block, straight up or left through any other. With
+ * length_only, only the last row and column are kept.
+ *
+ * When the runs are short, the blocks save less than they cost, so the
+ * solve falls back to the bit-parallel kernel for the length alone, or to the
+ * parallel solver for the alignment. It falls back when the harmonic mean of
+ * the average run lengths of the two sequences is below min_run_length.
+ */
+class LongestCommonSubsequenceRLE
+{
+protected:
+  std::string sequence_a;
+  std::string sequence_b;
+  const RunLengthSequence runs_a;
+  const RunLengthSequence runs_b;
+  int numThreads;
+  double min_run_length;
+  bool length_only;
+
+  ThreadPool thread_pool; // Runs the fallback solver.
+
+  /* The rows of the matrix between the runs of sequence_a: row(x) is the top
+  row of the x-th row of blocks, and row(runs_a.n_runs()) the last row. */
+  std::vector<int> rows;
+  /* The columns of the matrix between the runs of sequence_b, one row of
+  blocks after another, so that a row of blocks writes them in order:
+  column(x, y) is the left column of block (x, y), and column(x, runs_b) the
+  last column. With length_only, only the last two rows and one row of
+  blocks of columns are kept. */
+  std::vector<int> columns;
+  std::vector<size_t> column_starts; // Where each row of blocks starts.
+
+  std::string longest_common_subsequence;
+  std::vector<MatchRun> match_runs;
+  std::vector<EditRun> edit_runs; // The same alignment as an edit script.
+  int lcs_length = 0;
+  bool fell_back = false;
+  long long block_cells = 0; // Boundary cells computed by the blocks.
+
+  CancellationToken *cancellation_token = nullptr;
+  bool cancelled = false;
+
+  Timer timer;
+  double time_taken = 0.0;
+  double matrix_time_taken = 0.0;
+
+  bool cancellationRequested()
+  {
+    return cancellation_token && cancellation_token->isCancelled();
+  }
+
+  int *row(const int x)
+  {
+    return rows.data() + (size_t)(length_only ? x % 2 : x) * (sequence_b.length() + 1);
+  }
+
+  int *column(const int x, const int y)
+  {
+    return columns.data() + (length_only ? 0 : column_starts[x]) +
+           (size_t)y * (runs_a.lengths[x] + 1);
+  }
+
+  /* Fills the block boundaries a row of blocks at a time. Returns false if
+  the solve was cancelled. */
+  bool fillBlocks()
+  {
+    const int n_rows = length_only ? 2 : runs_a.n_runs() + 1;
+    rows.assign((size_t)n_rows * (sequence_b.length() + 1), 0);
+    column_starts.assign(runs_a.n_runs() + 1, 0);
+    for (int x = 0; x < runs_a.n_runs(); x++)
+    {
+      size_t size = (size_t)(runs_b.n_runs() + 1) * (runs_a.lengths[x] + 1);
+      column_starts[x + 1] = length_only ? std::max(column_starts[x], size)
+                                         : column_starts[x] + size;
+    }
+    columns.assign(column_starts.back(), 0);
+    block_cells = 0;
+
+    for (int x = 0; x < runs_a.n_runs(); x++)
+    {
+      if (cancellationRequested())
+        return false;
+      const int p = runs_a.lengths[x];
+      const int *top = row(x);
+      int *bottom = row(x + 1);
+      // The left column of the matrix is all 0s, but with length_only its
+      // buffer was used by the row of blocks before.
+      std::fill(column(x, 0), column(x, 0) + p + 1, 0);
+      for (int y = 0; y < runs_b.n_runs(); y++)
+      {
+        const int j0 = runs_b.starts[y], q = runs_b.lengths[y];
+        computeRunBlock(runs_a.characters[x], p, runs_b.characters[y], q, top + j0,
+                        column(x, y), bottom + j0, column(x, y + 1));
+        block_cells += p + q;
+      }
+    }
+    lcs_length = row(runs_a.n_runs())[sequence_b.length()];
+    return true;
+  }
+
+  /* Walks back from the far corner through the blocks to find the alignment. */
+  void traceback()
+  {
+    std::vector<MatchRun> reversed_runs;
+    int i = sequence_a.length(), j = sequence_b.length();
+    int x = runs_a.n_runs() - 1, y = runs_b.n_runs() - 1;
+    while (i > 0 && j > 0)
+    {
+      const int i0 = runs_a.starts[x], j0 = runs_b.starts[y];
+      if (runs_a.characters[x] == runs_b.characters[y])
+      {
+        int diagonal = std::min(i - i0, j - j0);
+        i -= diagonal;
+        j -= diagonal;
+        reversed_runs.push_back(MatchRun{i, j, diagonal});
+        prependEdit(edit_runs, '=', diagonal);
+      }
+      else if (row(x)[j] >= column(x, y)[i - i0])
+      {
+        prependEdit(edit_runs, 'D', i - i0);
+        i = i0;
+      }
+      else
+      {
+        prependEdit(edit_runs, 'I', j - j0);
+        j = j0;
+      }
+      if (i == i0)
+        x--;
+      if (j == j0)
+        y--;
+    }
+    prependEdit(edit_runs, 'I', j);
+    prependEdit(edit_runs, 'D', i);
+    std::reverse(edit_runs.begin(), edit_runs.end());
+
+    // Matches of consecutive blocks may continue the same diagonal.
+    for (size_t k = reversed_runs.size(); k-- > 0;)
+    {
+      appendMatchRun(match_runs, reversed_runs[k]);
+    }
+  }
+
+  /* Solves the sequences without the runs, when they are too short to help. */
+  void solveWithoutRuns()
+  {
+    if (length_only)
+    {
+      lcs_length = bitParallelLCSLength(sequence_a, sequence_b, cancellation_token);
+      cancelled = lcs_length < 0;
+      return;
+    }
+    LongestCommonSubsequenceParallel lcs(sequence_a, sequence_b, numThreads, 0, 1);
+    lcs.setThreadPool(&thread_pool);
+    lcs.setCancellationToken(cancellation_token);
+    lcs.solve();
+    if (lcs.wasCancelled())
+    {
+      cancelled = true;
+      return;
+    }
+    lcs_length = lcs.getLongestSubsequenceLength();
+    match_runs = lcs.getMatchRuns();
+    edit_runs = lcs.getEditScript();
+  }
+
+public:
+  /* The sequences are compressed here. The fallback solver runs on n_threads
+  threads. With length_only, only the length is found. */
+  LongestCommonSubsequenceRLE(const std::string &sequence_a,
+                              const std::string &sequence_b, const int n_threads,
+                              const double min_run_length, const bool length_only)
+      : sequence_a(sequence_a), sequence_b(sequence_b), runs_a(sequence_a),
+        runs_b(sequence_b), numThreads(std::max(1, n_threads)),
+        min_run_length(min_run_length), length_only(length_only),
+        thread_pool(std::max(1, n_threads) - 1)
+  {
+  }
+
+  /* Harmonic mean of the average run lengths of the two sequences: the
+  blocks compute 2 / meanRunLength() boundary cells per cell of the matrix. */
+  double meanRunLength() const
+  {
+    return 2.0 / ((double)runs_a.n_runs() / sequence_a.length() +
+                  (double)runs_b.n_runs() / sequence_b.length());
+  }
+
+  void solve()
+  {
+    timer.start();
+    cancelled = false;
+    match_runs.clear();
+    edit_runs.clear();
+    longest_common_subsequence.clear();
+
+    fell_back = meanRunLength() < min_run_length;
+    if (fell_back)
+    {
+      solveWithoutRuns();
+      matrix_time_taken = timer.stop();
+    }
+    else
+    {
+      cancelled = !fillBlocks();
+      matrix_time_taken = timer.stop();
+      if (!cancelled && !length_only)
+        traceback();
+    }
+
+    if (cancelled)
+    {
+      match_runs.clear();
+      edit_runs.clear();
+      time_taken = timer.stop();
+      return;
+    }
+
+    longest_common_subsequence.reserve(length_only ? 0 : lcs_length);
+    for (const MatchRun &run : match_runs)
+    {
+      longest_common_subsequence.append(sequence_a, run.i, run.length);
+    }
+    time_taken = timer.stop();
+  }
+
+  /* Subsequent solves stop at the next row of blocks once the token is
+  cancelled. The token must outlive the solves. */
+  void setCancellationToken(CancellationToken *token)
+  {
+    cancellation_token = token;
+  }
+
+  bool wasCancelled() const
+  {
+    return cancelled;
+  }
+
+  // Returns the length of the LCS found, or -1 if the last solve was
+  // cancelled.
+  int getLongestSubsequenceLength() const
+  {
+    return cancelled ? -1 : lcs_length;
+  }
+
+  const std::string &getLongestCommonSubsequence() const
+  {
+    return longest_common_subsequence;
+  }
+
+  const std::vector<MatchRun> &getMatchRuns() const
+  {
+    return match_runs;
+  }
+
+  const std::vector<EditRun> &getEditScript() const
+  {
+    return edit_runs;
+  }
+
+  int getLengthA() const
+  {
+    return sequence_a.length();
+  }
+
+  int getLengthB() const
+  {
+    return sequence_b.length();
+  }
+
+  double getTimeTaken() const
+  {
+    return time_taken;
+  }
+
+  double getMatrixTimeTaken() const
+  {
+    return matrix_time_taken;
+  }
+
+  bool fellBack() const
+  {
+    return fell_back;
+  }
+
+  void printInfo()
+  {
+    std::cout << "Sequence A: " << sequence_a << "\n";
+    std::cout << "Sequence B: " << sequence_b << "\n";
+    if (!length_only)
+      std::cout << "Longest common subsequence: " << longest_common_subsequence << "\n";
+    std::cout << "Length of the longest common subsequence: " << getLongestSubsequenceLength() << "\n";
+  }
+
+  // Prints how well the sequences compressed and what the blocks saved.
+  void printRunStats()
+  {
+    long long total_cells = (long long)sequence_a.length() * sequence_b.length();
+
+    printf("\n-_-_-_-_-_-_-_ LCS Run-Length Statistics _-_-_-_-_-_-_-\n\n");
+    printf("Runs in A: %d for %zu characters (compression %.2fx)\n", runs_a.n_runs(),
+           sequence_a.length(), (double)sequence_a.length() / runs_a.n_runs());
+    printf("Runs in B: %d for %zu characters (compression %.2fx)\n", runs_b.n_runs(),
+           sequence_b.length(), (double)sequence_b.length() / runs_b.n_runs());
+    printf("Mean run length: %.2f (minimum %.2f)\n", meanRunLength(), min_run_length);
+    if (fell_back)
+    {
+      printf("Engine: %s, the runs are too short to save work\n",
+             length_only ? "bit-parallel" : "parallel");
+    }
+    else
+    {
+      printf("Engine: run-length blocks, %lld x %lld\n", (long long)runs_a.n_runs(),
+             (long long)runs_b.n_runs());
+      printf("Cells computed: %lld of %lld (%.2f%%)\n", block_cells, total_cells,
+             total_cells > 0 ? 100.0 * block_cells / total_cells : 0.0);
+    }
+    printf("Time taken to compute matrix: %lf\n", matrix_time_taken);
+    printf("Total time taken: %lf\n", time_taken);
+  }
+};
+
+#endif
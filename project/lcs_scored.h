@@ -0,0 +1,143 @@
+#ifndef _LCS_SCORED_H_
+#define _LCS_SCORED_H_
+
+#include <memory>
+#include <utility>
+
+#include "lcs.h"
+#include "scoring.h"
+
+/**
+ * @brief An LCS engine that solves another recurrence.
+ *
+ * LongestCommonSubsequenceScored<Engine, Scoring> is the engine (the serial,
+ * parallel or distributed solver) with the boundary, row kernel and
+ * traceback of the policy Scoring from scoring.h. The engine divides the
+ * matrix and synchronizes exactly as before; it calls computeRow() once per
+ * row segment, and computeRow() is compiled for the policy.
+ *
+ * The matrix holds scores, so getScore() is the score of the alignment, and
+ * getLongestSubsequenceLength() is the number of characters it matches.
+ */
+template <class Engine, class Scoring>
+class LongestCommonSubsequenceScored : public Engine
+{
+protected:
+  const Scoring scoring;
+
+  virtual void computeRow(const int row, const int first_col, const int last_col) override
+  {
+    computeScoredRow(scoring, this->sequence_a[row - 1], this->sequence_b.data,
+                     this->matrix[row - 1], this->matrix[row], first_col, last_col);
+  }
+
+  /* A local alignment starts from the largest entry of the matrix, the first
+  one in row order. If every entry is 0, the alignment is empty. */
+  virtual int tracebackStart(int &i, int &j) override
+  {
+    int best = Engine::tracebackStart(i, j);
+    if (!Scoring::local)
+      return best;
+    best = 0;
+    i = j = 0;
+    for (int row = 1; row < this->matrix_height; row++)
+    {
+      const int *values = this->matrix[row];
+      for (int col = 1; col < this->matrix_width; col++)
+      {
+        if (values[col] > best)
+        {
+          best = values[col];
+          i = row;
+          j = col;
+        }
+      }
+    }
+    return best;
+  }
+
+  virtual TracebackMove tracebackStep(int &i, int &j) const override
+  {
+    return scoredTracebackStep(scoring, this->matrix, this->sequence_a.data,
+                               this->sequence_b.data, i, j);
+  }
+
+  virtual bool localAlignment() const override
+  {
+    return Scoring::local;
+  }
+
+  virtual bool tracesUnfilledRows() const override
+  {
+    return false;
+  }
+
+public:
+  /* The remaining arguments are passed on to the engine's constructor. */
+  template <class... Args>
+  LongestCommonSubsequenceScored(const Scoring &scoring, Args &&...args)
+      : Engine(std::forward<Args>(args)...), scoring(scoring)
+  {
+    // The engine filled the top row and left column with 0s.
+    for (int i = 0; i < this->matrix_height; i++)
+    {
+      this->matrix[i][0] = scoring.boundary(i);
+    }
+    for (int j = 0; j < this->matrix_width; j++)
+    {
+      this->matrix[0][j] = scoring.boundary(this->column_offset + j);
+    }
+  }
+
+  virtual int getLongestSubsequenceLength() override
+  {
+    if (this->cancelled)
+      return -1;
+    return this->longest_common_subsequence.length();
+  }
+
+  virtual void printLCSLength() override
+  {
+    Engine::printLCSLength();
+    std::cout << "Score of the alignment: " << this->getScore() << "\n";
+  }
+};
+
+/* The recurrence chosen with the --scoring, --match, --mismatch, --gap and
+--weights options. */
+struct ScoringOptions
+{
+  LCSScoringScheme scheme = LCS_SCORING_LCS;
+  int match = 1;
+  int mismatch = -1;
+  int gap = 1;
+  WeightedLCSScoring weights;
+};
+
+/* Creates the engine for the chosen recurrence, passing the remaining
+arguments on to its constructor. Plain LCS is the engine itself. */
+template <class Engine, class... Args>
+std::unique_ptr<Engine> makeScoredSolver(const ScoringOptions &options, Args &&...args)
+{
+  switch (options.scheme)
+  {
+  case LCS_SCORING_WEIGHTED:
+    return std::unique_ptr<Engine>(
+        new LongestCommonSubsequenceScored<Engine, WeightedLCSScoring>(
+            options.weights, std::forward<Args>(args)...));
+  case LCS_SCORING_GLOBAL:
+    return std::unique_ptr<Engine>(
+        new LongestCommonSubsequenceScored<Engine, GlobalAlignmentScoring>(
+            GlobalAlignmentScoring(options.match, options.mismatch, options.gap),
+            std::forward<Args>(args)...));
+  case LCS_SCORING_LOCAL:
+    return std::unique_ptr<Engine>(
+        new LongestCommonSubsequenceScored<Engine, LocalAlignmentScoring>(
+            LocalAlignmentScoring(options.match, options.mismatch, options.gap),
+            std::forward<Args>(args)...));
+  default:
+    return std::unique_ptr<Engine>(new Engine(std::forward<Args>(args)...));
+  }
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef _LCS_SEAWEED_H_
+#define _LCS_SEAWEED_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "lcs.h"
+#include "seaweed.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Parallel solver that divides the rows, instead of the columns.
+ *
+ * The parallel solver gives each thread a strip of columns, and every strip
+ * waits for the strip to its left, so a thread cannot start until the
+ * wavefront reaches it. When sequence_b is short, the strips are narrow and
+ * the threads spend most of their time waiting. This solver divides
+ * sequence_a into bands of rows instead, and no band waits for another to be
+ * computed:
+ *
+ * 1. Every band combs its seaweed braid against the whole of sequence_b (see
+ *    seaweed.h). The braid describes the band whatever the rows above it, so
+ *    the bands are combed at once.
+ * 2. The braids are multiplied together from the top band down, to find the
+ *    seaweeds that cross the line between each pair of bands. Only the
+ *    length_b seaweeds in the columns matter below a line, so each product
+ *    has the size of a band's braid, and its halves run on the pool.
+ * 3. The seaweeds crossing the line above a band give the row of the matrix
+ *    above it, so every band fills its rows of the matrix at once.
+ *
+ * Combing costs about as much as filling, so the bands compute each cell
+ * twice, but with no pipeline to fill or drain. The alignment is traced back
+ * on one thread, as in the serial solver.
+ */
+class LongestCommonSubsequenceSeaweed : public LongestCommonSubsequence
+{
+protected:
+  int numThreads;
+  int n_bands;
+
+  ThreadPool thread_pool;
+
+  double comb_time_taken = 0.0;
+  double multiply_time_taken = 0.0;
+  double fill_time_taken = 0.0;
+  double traceback_time_taken = 0.0;
+
+  /* The seaweeds in the columns of a line between two bands: the order in
+  which the seaweed in each column entered the matrix, and how many of them
+  entered on the left. Those entered before any that came in at the top. */
+  struct ColumnSeaweeds
+  {
+    std::vector<int> ranks;
+    int n_left = 0;
+  };
+
+  // Rows [bandStart(k), bandStart(k + 1)) of sequence_a form band k.
+  int bandStart(const int band) const
+  {
+    return (int)((long long)length_a * band / n_bands);
+  }
+
+  /* Moves the seaweeds in the columns across a band with the given braid.
+  The band's own rows enter before any seaweed in the columns, so in the
+  product they come first and pass straight through the line above. */
+  void crossBand(const int band, const std::vector<int> &braid,
+                 ColumnSeaweeds &columns)
+  {
+    const int height = bandStart(band + 1) - bandStart(band);
+    std::vector<int> above(height + length_b);
+    for (int s = 0; s < height; s++)
+    {
+      above[s] = s;
+    }
+    for (int j = 0; j < length_b; j++)
+    {
+      above[height + columns.ranks[j]] = height + j;
+    }
+    std::vector<int> product = stickyBraidProduct(above, braid, &thread_pool);
+
+    int rank = 0, n_left = 0;
+    for (int s = 0; s < height + length_b; s++)
+    {
+      if (product[s] < length_b)
+      {
+        columns.ranks[product[s]] = rank++;
+        n_left += s < height + columns.n_left;
+      }
+    }
+    columns.n_left = n_left;
+  }
+
+  /* Writes the row of the matrix below the given line: it increases where
+  the seaweed in a column entered on the left, rather than at the top. */
+  void rowBelow(const ColumnSeaweeds &columns, std::vector<int> &row)
+  {
+    row.assign(matrix_width, 0);
+    for (int j = 1; j < matrix_width; j++)
+    {
+      row[j] = row[j - 1] + (columns.ranks[j - 1] < columns.n_left);
+    }
+  }
+
+  /* Fills the rows of a band from the row above it. Returns false if the
+  solve was cancelled. */
+  bool fillBand(const int band, const int *boundary)
+  {
+    for (int i = bandStart(band) + 1; i <= bandStart(band + 1); i++)
+    {
+      if (i % 64 == 0 && cancellationRequested())
+        return false;
+      int *row = matrix[i];
+      const int *above = i == bandStart(band) + 1 ? boundary : matrix[i - 1];
+      const char a = sequence_a[i - 1];
+      for (int j = 1; j < matrix_width; j++)
+      {
+        row[j] = a == sequence_b[j - 1] ? above[j - 1] + 1
+                                        : std::max(above[j], row[j - 1]);
+      }
+    }
+    return true;
+  }
+
+public:
+  /* With LCS_ORIENTATION_AUTO, the longer sequence is divided into bands of
+  rows. By default there is one band per thread. */
+  LongestCommonSubsequenceSeaweed(const Sequence &sequence_a,
+                                  const Sequence &sequence_b, const int threads,
+                                  const int bands = 0,
+                                  const LCSOrientation orientation = LCS_ORIENTATION_AUTO)
+      : LongestCommonSubsequence(sequence_a, sequence_b, nullptr,
+                                 orientation == LCS_ORIENTATION_AUTO
+                                     ? sequence_b.length() > sequence_a.length()
+                                     : orientation == LCS_ORIENTATION_TRANSPOSE),
+        numThreads(std::max(1, threads)),
+        thread_pool(std::max(1, threads) - 1)
+  {
+    n_bands = std::max(1, std::min(bands > 0 ? bands : numThreads, length_a));
+  }
+
+  virtual void solve() override
+  {
+    timer.start();
+    cancelled = false;
+
+    // 1. Comb every band.
+    Timer stage_timer;
+    stage_timer.start();
+    std::vector<std::vector<int>> braids(n_bands);
+    thread_pool.run(n_bands, [this, &braids](int band)
+                    {
+      int row_start = bandStart(band), height = bandStart(band + 1) - row_start;
+      braids[band].resize(height + length_b);
+      combBraid(sequence_a.data + row_start, height, sequence_b.data, length_b,
+                braids[band].data(), cancellation_token); });
+    comb_time_taken = stage_timer.stop();
+
+    // 2. Find the seaweeds in the columns of every line between two bands,
+    // and the rows of the matrix there.
+    stage_timer.start();
+    std::vector<std::vector<int>> boundaries(n_bands);
+    ColumnSeaweeds columns;
+    columns.ranks.resize(length_b);
+    for (int j = 0; j < length_b; j++)
+    {
+      columns.ranks[j] = j;
+    }
+    for (int band = 0; band + 1 < n_bands && !cancellationRequested(); band++)
+    {
+      crossBand(band, braids[band], columns);
+      rowBelow(columns, boundaries[band + 1]);
+    }
+    multiply_time_taken = stage_timer.stop();
+
+    // 3. Fill every band from the row above it.
+    stage_timer.start();
+    thread_pool.run(n_bands, [this, &boundaries](int band)
+                    {
+      if (!cancellationRequested())
+        fillBand(band, band == 0 ? matrix[0] : boundaries[band].data()); });
+    fill_time_taken = stage_timer.stop();
+    matrix_time_taken = comb_time_taken + multiply_time_taken + fill_time_taken;
+
+    cancelled = cancellationRequested();
+    if (cancelled)
+    {
+      completed_cells = 0;
+      finishCancelled();
+      return;
+    }
+    completed_cells = (long long)length_a * length_b;
+
+    stage_timer.start();
+    determineLongestCommonSubsequence();
+    traceback_time_taken = stage_timer.stop();
+    time_taken = timer.stop();
+  }
+
+  // Print how long each stage of the solve took
+  void printSeaweedStats()
+  {
+    printf("\n-_-_-_-_-_-_-_ LCS Seaweed Statistics _-_-_-_-_-_-_-\n\n");
+    printf("Bands: %d\n", n_bands);
+    printf("Comb Time Taken: %f\n", comb_time_taken);
+    printf("Multiply Time Taken: %f\n", multiply_time_taken);
+    printf("Fill Time Taken: %f\n", fill_time_taken);
+    printf("Traceback Time Taken: %f\n", traceback_time_taken);
+  }
+};
+
+#endif
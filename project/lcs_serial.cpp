@@ -1,59 +1,10 @@
 #include <iostream>
 
 #include "cxxopts.hpp" // Header file for option parsing library (cxxopts)
-#include "lcs.h"
-
-// Class implementing the Serial version of the Longest Common Subsequence
-// algorithm
-class LongestCommonSubsequenceSerial : public LongestCommonSubsequence
-{
-private:
-  // Override the solve method from LongestCommonSubsequence class
-  virtual void solve() override
-  {
-    timer.start();        // Start the overall timer to measure the execution time
-    matrix_timer.start(); // Start the matrix computation timer
-
-    // Nested loops to iterate through each cell in the matrix and compute the
-    // LCS values
-    for (int i = 1; i < matrix_height; i++)
-    {
-      for (int j = 1; j < matrix_width; j++)
-      {
-        computeCell(i, j); // Calculate the LCS value for cell (i, j)
-      }
-    }
-
-    // Stop the matrix timer and record the time taken for matrix computations
-    matrix_time_taken = matrix_timer.stop();
-
-    // After the matrix is filled, determine the longest common subsequence from
-    // the matrix
-    determineLongestCommonSubsequence();
-
-    // Stop the overall timer and record the total time taken
-    time_taken = timer.stop();
-  }
-
-public:
-  // Constructor that initializes the sequences and calls the solve method
-  LongestCommonSubsequenceSerial(const std::string &sequence_a,
-                                 const std::string &sequence_b)
-      : LongestCommonSubsequence(sequence_a, sequence_b)
-  {
-    this->solve(); // Solve the LCS for the given sequences
-  }
-
-  // Destructor
-  virtual ~LongestCommonSubsequenceSerial() {}
-
-  // Override the print method to display the results
-  virtual void print() override
-  {
-    printInfo();      // Print information about the LCS problem
-    printTimeTaken(); // Print the time taken to compute the LCS
-  }
-};
+#include "lcs_count.h"
+#include "lcs_output.h"
+#include "lcs_scored.h"
+#include "lcs_serial.h"
 
 // Main function for running the serial LCS algorithm
 int main(int argc, char *argv[])
@@ -68,7 +19,39 @@ int main(int argc, char *argv[])
                     {"sequence_b", "Second input sequence.",
                      cxxopts::value<std::string>()->default_value("")}, // Second input sequence
                     {"input_file", "Path to input .csv file.",
-                     cxxopts::value<std::string>()->default_value("")} // Input file.
+                     cxxopts::value<std::string>()->default_value("")}, // Input file.
+                    {"output_format", "Result format: text, binary, jsonl or edits.",
+                     cxxopts::value<std::string>()->default_value("text")},
+                    {"output_file", "Path to write binary or jsonl results to (default: stdout).",
+                     cxxopts::value<std::string>()->default_value("")},
+                    {"alignment", "Include the alignment as runs of matches in binary or jsonl results.",
+                     cxxopts::value<bool>()->default_value("false")},
+                    {"dump_matrix", "Write the matrix to this binary file, for lcs_matrix_view.",
+                     cxxopts::value<std::string>()->default_value("")},
+                    {"checkpoint_file", "Save checkpoints of the fill to this file.",
+                     cxxopts::value<std::string>()->default_value("")},
+                    {"checkpoint_interval", "Seconds between checkpoints.",
+                     cxxopts::value<double>()->default_value("600")},
+                    {"resume", "Continue from the checkpoint file, if it exists, without recomputing the rows above it.",
+                     cxxopts::value<bool>()->default_value("false")},
+                    {"progress_interval", "Print progress to stderr every this many seconds (0 disables it).",
+                     cxxopts::value<double>()->default_value("0")},
+                    {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+                     cxxopts::value<double>()->default_value("0")},
+                    {"scoring", "Recurrence to solve: lcs, weighted, global (Needleman-Wunsch) or local (Smith-Waterman).",
+                     cxxopts::value<std::string>()->default_value("lcs")},
+                    {"match", "Score of a match, for global and local scoring.",
+                     cxxopts::value<int>()->default_value("1")},
+                    {"mismatch", "Score of a mismatch, for global and local scoring.",
+                     cxxopts::value<int>()->default_value("-1")},
+                    {"gap", "Penalty per character aligned with a gap, for global and local scoring.",
+                     cxxopts::value<int>()->default_value("1")},
+                    {"weights", "Character weights for weighted scoring, as A:2,C:3 (others weigh 1).",
+                     cxxopts::value<std::string>()->default_value("")},
+                    {"count_lcs", "Also count the distinct longest common subsequences.",
+                     cxxopts::value<bool>()->default_value("false")},
+                    {"count_modulus", "Modulus of the count of distinct longest common subsequences.",
+                     cxxopts::value<long long>()->default_value("1000000007")},
                 });
 
   // Parse the command-line options
@@ -78,6 +61,54 @@ int main(int argc, char *argv[])
   std::string sequence_a = command_options["sequence_a"].as<std::string>();
   std::string sequence_b = command_options["sequence_b"].as<std::string>();
   std::string input_file = command_options["input_file"].as<std::string>();
+  LCSOutputFormat output_format;
+  if (!parseOutputFormat(command_options["output_format"].as<std::string>(), output_format))
+  {
+    std::cerr << "Error: unknown output format: "
+              << command_options["output_format"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  std::string output_file = command_options["output_file"].as<std::string>();
+  std::string dump_file = command_options["dump_matrix"].as<std::string>();
+  std::string checkpoint_file = command_options["checkpoint_file"].as<std::string>();
+  double checkpoint_interval = command_options["checkpoint_interval"].as<double>();
+  bool resume = command_options["resume"].as<bool>();
+  double progress_interval = command_options["progress_interval"].as<double>();
+  double time_limit = command_options["time_limit"].as<double>();
+  ScoringOptions scoring;
+  if (!parseScoringScheme(command_options["scoring"].as<std::string>(), scoring.scheme))
+  {
+    std::cerr << "Error: unknown scoring: "
+              << command_options["scoring"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  scoring.match = command_options["match"].as<int>();
+  scoring.mismatch = command_options["mismatch"].as<int>();
+  scoring.gap = command_options["gap"].as<int>();
+  if (!scoring.weights.parse(command_options["weights"].as<std::string>()))
+  {
+    std::cerr << "Error: malformed weights: "
+              << command_options["weights"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  bool count_lcs = command_options["count_lcs"].as<bool>();
+  long long count_modulus = command_options["count_modulus"].as<long long>();
+  if (count_lcs && (count_modulus < 2 || count_modulus > UINT32_MAX))
+  {
+    std::cerr << "Error: count modulus must be between 2 and " << UINT32_MAX << "." << std::endl;
+    exit(1);
+  }
+  if (count_lcs && scoring.scheme != LCS_SCORING_LCS)
+  {
+    std::cerr << "Error: only the LCS can be counted (--scoring=lcs)." << std::endl;
+    exit(1);
+  }
+  // A checkpoint holds the lengths but not the counts.
+  if (count_lcs && resume)
+  {
+    std::cerr << "Error: a count cannot be resumed from a checkpoint." << std::endl;
+    exit(1);
+  }
 
   if (input_file != "")
   {
@@ -91,12 +122,47 @@ int main(int argc, char *argv[])
     exit(1);
   }
 
+  // Create an instance of LongestCommonSubsequenceSerial for the chosen
+  // scoring, or one that also counts the LCSs, and solve the LCS
+  std::unique_ptr<LongestCommonSubsequenceSerial> solver =
+      count_lcs ? makeCountedSolver<LongestCommonSubsequenceSerial>(
+                      count_modulus, sequence_a, sequence_b)
+                : makeScoredSolver<LongestCommonSubsequenceSerial>(scoring, sequence_a,
+                                                                   sequence_b);
+  LongestCommonSubsequenceSerial &lcs = *solver;
+  configure_checkpoints(lcs, checkpoint_file, checkpoint_interval, resume);
+  lcs.enableProgress(progress_interval);
+  CancellationToken cancellation;
+  cancellation.setTimeLimit(time_limit);
+  lcs.setCancellationToken(&cancellation);
+  lcs.solve();
+
+  if (lcs.wasCancelled())
+  {
+    // There is no result, only how far the solve got.
+    lcs.printCancelled(output_format == LCS_OUTPUT_TEXT ? stdout : stderr);
+    return 2;
+  }
+
+  if (dump_file != "" && !lcs.dumpMatrix(dump_file))
+  {
+    std::cerr << "Error writing file: " << dump_file << std::endl;
+  }
+
+  if (output_format != LCS_OUTPUT_TEXT)
+  {
+    if (!writeResult(output_file, output_format, lcs,
+                     command_options["alignment"].as<bool>()))
+    {
+      std::cerr << "Error writing file: " << output_file << std::endl;
+      exit(1);
+    }
+    return 0;
+  }
+
   // Print a separator line for clarity in the output
   printf("-------------------- LCS Serial --------------------\n");
 
-  // Create an instance of LongestCommonSubsequenceSerial and solve the LCS
-  LongestCommonSubsequenceSerial lcs(sequence_a, sequence_b);
-
   // Print the length of the LCS and the time taken to compute it
   lcs.printInfo();
   lcs.printTimeTaken();
@@ -0,0 +1,143 @@
+#ifndef _LCS_SERIAL_H_
+#define _LCS_SERIAL_H_
+
+#include <atomic>
+#include <string>
+
+#include "lcs.h"
+
+// Class implementing the Serial version of the Longest Common Subsequence
+// algorithm
+class LongestCommonSubsequenceSerial : public LongestCommonSubsequence
+{
+protected:
+  // Last row completed by the fill, for the progress reporter
+  std::atomic<int> completed_rows;
+
+  // Saves the last row completed by the main fill as a checkpoint
+  void saveRowCheckpoint(const int row)
+  {
+    Checkpoint checkpoint = emptyCheckpoint();
+    checkpoint.strips.push_back(snapshotStrip(1, matrix_width - 1, row, row + 1));
+    saveCheckpoint(checkpoint, checkpoint_path);
+  }
+
+  // Fills rows first_row to end_row - 1 of the matrix, stopping early if the
+  // solve is cancelled. For the main fill, also records progress and saves a
+  // checkpoint of the last completed row every checkpoint_interval seconds if
+  // enabled.
+  void fillRows(const int first_row, const int end_row, const bool main_fill)
+  {
+    bool checkpoints = main_fill && checkpoint_path != "";
+    Timer checkpoint_timer;
+    checkpoint_timer.start();
+    for (int i = first_row; i < end_row; i++)
+    {
+      if (cancellationRequested())
+      {
+        cancelled = true;
+        return;
+      }
+      computeRow(i, 1, matrix_width - 1); // Calculate the LCS values for row i
+      if (main_fill)
+      {
+        completed_rows.store(i, std::memory_order_relaxed);
+      }
+
+      // One clock read per row is negligible next to the row itself.
+      if (checkpoints && checkpoint_timer.stop() >= checkpoint_interval)
+      {
+        saveRowCheckpoint(i);
+        checkpoint_timer.start();
+      }
+    }
+  }
+
+public:
+  // Override the solve method from LongestCommonSubsequence class
+  virtual void solve() override
+  {
+    timer.start();        // Start the overall timer to measure the execution time
+    matrix_timer.start(); // Start the matrix computation timer
+
+    // Continue from the row saved in the checkpoint, if resuming.
+    int first_row = 1;
+    if (resuming)
+    {
+      restoreStrip(resume_checkpoint.strips[0]);
+      first_row = resume_checkpoint.strips[0].row + 1;
+      resuming = false;
+    }
+    cancelled = false;
+
+    // Iterate through each remaining row of the matrix and compute the LCS
+    // values
+    completed_rows = first_row - 1;
+    ProgressReporter progress(progress_interval, (long long)length_a * length_b,
+                              [this]()
+                              { return (long long)completed_rows.load() * length_b; });
+    fillRows(first_row, matrix_height, true);
+    progress.stop();
+    completed_cells = (long long)completed_rows * length_b;
+
+    // The rows above a checkpoint were not saved. The traceback aligns that
+    // part of the sequences in linear space, unless the recurrence needs
+    // them recomputed.
+    first_filled_rows.clear();
+    if (!cancelled && first_row > 2 && tracesUnfilledRows())
+    {
+      first_filled_rows.assign(matrix_width, first_row - 1);
+      first_filled_rows[0] = 0;
+    }
+    else if (!cancelled)
+    {
+      fillRows(1, first_row - 1, false);
+    }
+
+    // Stop the matrix timer and record the time taken for matrix computations
+    matrix_time_taken = matrix_timer.stop();
+
+    // A cancelled solve leaves a checkpoint of its last row, so that it can be
+    // resumed later.
+    if (checkpoint_path != "")
+    {
+      if (cancelled)
+        saveRowCheckpoint(completed_rows);
+      else
+        remove(checkpoint_path.c_str());
+    }
+    if (cancelled)
+    {
+      finishCancelled();
+      return;
+    }
+
+    // After the matrix is filled, determine the longest common subsequence from
+    // the matrix
+    determineLongestCommonSubsequence();
+
+    // Stop the overall timer and record the total time taken
+    time_taken = timer.stop();
+  }
+
+  // Constructor that initializes the sequences. Call solve() to compute the LCS.
+  LongestCommonSubsequenceSerial(const Sequence &sequence_a,
+                                 const Sequence &sequence_b,
+                                 Arena *arena = nullptr)
+      : LongestCommonSubsequence(sequence_a, sequence_b, arena),
+        completed_rows(0)
+  {
+  }
+
+  // Destructor
+  virtual ~LongestCommonSubsequenceSerial() {}
+
+  // Override the print method to display the results
+  virtual void print() override
+  {
+    printInfo();      // Print information about the LCS problem
+    printTimeTaken(); // Print the time taken to compute the LCS
+  }
+};
+
+#endif
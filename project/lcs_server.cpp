@@ -0,0 +1,561 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cxxopts.hpp"
+#include "lcs_cache.h"
+#include "lcs_parallel.h"
+#include "lcs_protocol.h"
+#include "lcs_serial.h"
+#include "thread_pool.h"
+
+// ***
+//  Long-running LCS server. It keeps a pool of compute threads alive and
+//  answers requests sent over a Unix domain socket using the protocol in
+//  lcs_protocol.h, so small jobs do not pay for process startup, option
+//  parsing and thread creation.
+//
+//  Small pairs are solved serially by the scheduler's runner threads. Pairs
+//  with more than --parallel_threshold matrix entries are solved by the
+//  parallel solver on the shared thread pool, one at a time, while the other
+//  runners keep working through the small pairs.
+//
+//  Results are kept in an LRU cache keyed by a hash of the pair, so repeated
+//  pairs are answered without being solved again.
+//
+//  Every runner has a cancellation token, which stops its solve once the job
+//  has run for --time_limit seconds or the server shuts down.
+// ***
+
+static std::atomic<bool> shutdown_requested(false);
+static std::atomic<bool> stats_requested(false);
+
+static void handle_signal(int signal_number)
+{
+  if (signal_number == SIGUSR1)
+    stats_requested = true;
+  else
+    shutdown_requested = true;
+}
+
+// Reads exactly n bytes. Returns false on end of file or error.
+static bool read_all(int fd, void *buffer, size_t n)
+{
+  char *data = (char *)buffer;
+  while (n > 0)
+  {
+    ssize_t n_read = recv(fd, data, n, 0);
+    if (n_read <= 0)
+      return false;
+    data += n_read;
+    n -= n_read;
+  }
+  return true;
+}
+
+// Reads and drops n bytes a chunk at a time, for input the server refuses
+// but must get past to reach the next pair. Returns false on end of stream.
+static bool skip_bytes(int fd, uint64_t n)
+{
+  char chunk[1 << 16];
+  while (n > 0)
+  {
+    size_t n_chunk = std::min<uint64_t>(n, sizeof(chunk));
+    if (!read_all(fd, chunk, n_chunk))
+      return false;
+    n -= n_chunk;
+  }
+  return true;
+}
+
+// Writes exactly n bytes. Returns false if the client went away.
+static bool write_all(int fd, const void *buffer, size_t n)
+{
+  const char *data = (const char *)buffer;
+  while (n > 0)
+  {
+    ssize_t n_written = send(fd, data, n, MSG_NOSIGNAL);
+    if (n_written <= 0)
+      return false;
+    data += n_written;
+    n -= n_written;
+  }
+  return true;
+}
+
+/* A client connection. Responses may be written by several runners at once,
+so writes are serialized per connection. The socket is closed once the reader
+and every outstanding job are done with it. */
+struct Connection
+{
+  const int fd;
+  std::mutex write_mutex;
+
+  Connection(int fd) : fd(fd) {}
+  ~Connection() { close(fd); }
+
+  bool respond(const LCSResponseHeader &header, const std::string &payload)
+  {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    return write_all(fd, &header, sizeof(header)) &&
+           write_all(fd, payload.data(), payload.length());
+  }
+};
+
+/* Connections whose reader thread is still running, so that they can be shut
+down before the scheduler goes away. */
+static std::mutex connections_mutex;
+static std::condition_variable connections_cv;
+static std::vector<std::weak_ptr<Connection>> open_connections;
+
+/* A single pair waiting to be solved. */
+struct Job
+{
+  std::shared_ptr<Connection> connection;
+  uint32_t request_id;
+  uint32_t pair_index;
+  uint32_t mode;
+  std::string sequence_a;
+  std::string sequence_b;
+  PairHash key; // Cache key of the pair.
+
+  long long cells() const
+  {
+    return (long long)sequence_a.length() * (long long)sequence_b.length();
+  }
+};
+
+/**
+ * @brief Hands jobs to runner threads, interleaving small and large jobs.
+ *
+ * Runners prefer to start a large job whenever none is running, and otherwise
+ * keep taking small jobs, so a long parallel solve never holds up the small
+ * jobs queued behind it.
+ */
+class Scheduler
+{
+private:
+  ThreadPool thread_pool;
+  ResultCache &cache;
+  const long long parallel_threshold;
+  const int large_job_threads;
+  const size_t arena_size; // Initial size of each runner's arena in bytes.
+  const double time_limit; // Seconds a job may run for, or 0 for no limit.
+
+  std::deque<Job> small_jobs;
+  std::deque<Job> large_jobs;
+  bool large_job_running = false;
+  bool stopping = false;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::thread> runners;
+  std::unique_ptr<CancellationToken[]> runner_tokens; // One per runner.
+
+  std::atomic<long long> n_small_jobs_done;
+  std::atomic<long long> n_large_jobs_done;
+  std::atomic<long long> n_jobs_cancelled;
+
+  /* Waits for the next job. Returns false when the scheduler is stopping.
+  The runner's token is armed while the lock is held, so a shutdown either
+  stops the runner here or cancels the job it has just taken. */
+  bool nextJob(Job &job, bool &large, CancellationToken &token)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]
+            { return stopping || !small_jobs.empty() ||
+                     (!large_jobs.empty() && !large_job_running); });
+    if (stopping)
+      return false;
+
+    large = !large_jobs.empty() && !large_job_running;
+    std::deque<Job> &queue = large ? large_jobs : small_jobs;
+    job = std::move(queue.front());
+    queue.pop_front();
+    if (large)
+      large_job_running = true;
+    token.reset();
+    token.setTimeLimit(time_limit);
+    return true;
+  }
+
+  void solve(Job &job, bool large, Arena &arena, CancellationToken &token)
+  {
+    LCSResponseHeader header;
+    header.magic = LCS_RESPONSE_MAGIC;
+    header.request_id = job.request_id;
+    header.pair_index = job.pair_index;
+    header.status = LCS_STATUS_OK;
+
+    std::string subsequence;
+    bool cancelled;
+    if (large)
+    {
+      LongestCommonSubsequenceParallel lcs(job.sequence_a, job.sequence_b,
+                                           large_job_threads, 0, 1, &arena);
+      lcs.setThreadPool(&thread_pool);
+      lcs.setCancellationToken(&token);
+      lcs.solve();
+      cancelled = lcs.wasCancelled();
+      subsequence = lcs.getLongestCommonSubsequence();
+    }
+    else
+    {
+      LongestCommonSubsequenceSerial lcs(job.sequence_a, job.sequence_b, &arena);
+      lcs.setCancellationToken(&token);
+      lcs.solve();
+      cancelled = lcs.wasCancelled();
+      subsequence = lcs.getLongestCommonSubsequence();
+    }
+
+    if (cancelled)
+    {
+      n_jobs_cancelled++;
+      header.status = LCS_STATUS_CANCELLED;
+      header.length = 0;
+      header.n_bytes = 0;
+      job.connection->respond(header, "");
+      return;
+    }
+
+    header.length = subsequence.length();
+
+    // A string result also answers later length-only requests for the pair.
+    CachedResult result;
+    result.length = subsequence.length();
+    cache.put(hashPair(job.sequence_a, job.sequence_b, LCS_MODE_LENGTH), result);
+    if (job.mode == LCS_MODE_STRING)
+    {
+      result.subsequence = subsequence;
+      cache.put(job.key, result);
+    }
+    else
+    {
+      subsequence.clear();
+    }
+    header.n_bytes = subsequence.length();
+    job.connection->respond(header, subsequence);
+  }
+
+  void runnerLoop(int runner_id)
+  {
+    // Scratch memory of this runner, reused from one job to the next.
+    Arena arena(arena_size);
+    CancellationToken &token = runner_tokens[runner_id];
+    Job job;
+    bool large;
+    while (nextJob(job, large, token))
+    {
+      solve(job, large, arena, token);
+      arena.reset();
+      job.connection.reset();
+
+      if (large)
+      {
+        n_large_jobs_done++;
+        std::lock_guard<std::mutex> lock(mutex);
+        large_job_running = false;
+        cv.notify_all();
+      }
+      else
+      {
+        n_small_jobs_done++;
+      }
+    }
+  }
+
+public:
+  Scheduler(int n_runners, int n_workers, ResultCache &cache,
+            long long parallel_threshold, int large_job_threads,
+            size_t arena_size, double time_limit)
+      : thread_pool(n_workers),
+        cache(cache),
+        parallel_threshold(parallel_threshold),
+        large_job_threads(large_job_threads),
+        arena_size(arena_size),
+        time_limit(time_limit),
+        runner_tokens(new CancellationToken[n_runners]),
+        n_small_jobs_done(0),
+        n_large_jobs_done(0),
+        n_jobs_cancelled(0)
+  {
+    for (int i = 0; i < n_runners; i++)
+    {
+      runners.emplace_back(&Scheduler::runnerLoop, this, i);
+    }
+  }
+
+  /* Cancels the jobs that are running, so that shutting down does not wait
+  for a long solve, and stops the runners. */
+  ~Scheduler()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    for (size_t i = 0; i < runners.size(); i++)
+    {
+      runner_tokens[i].cancel();
+    }
+    cv.notify_all();
+    for (std::thread &runner : runners)
+    {
+      runner.join();
+    }
+  }
+
+  void submit(Job &&job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (job.cells() > parallel_threshold)
+        large_jobs.push_back(std::move(job));
+      else
+        small_jobs.push_back(std::move(job));
+    }
+    cv.notify_one();
+  }
+
+  void printStats()
+  {
+    printf("Small jobs solved: %lld\n", n_small_jobs_done.load());
+    printf("Large jobs solved: %lld\n", n_large_jobs_done.load());
+    printf("Jobs cancelled: %lld\n", n_jobs_cancelled.load());
+    AllocationCounters::print();
+  }
+};
+
+static void read_requests(std::shared_ptr<Connection> connection,
+                          Scheduler &scheduler, ResultCache &cache,
+                          long long max_cells);
+
+// Reads requests from a client until it disconnects.
+static void serve_connection(std::shared_ptr<Connection> connection,
+                             Scheduler &scheduler, ResultCache &cache,
+                             long long max_cells)
+{
+  read_requests(connection, scheduler, cache, max_cells);
+
+  std::lock_guard<std::mutex> lock(connections_mutex);
+  for (auto it = open_connections.begin(); it != open_connections.end(); ++it)
+  {
+    if (it->lock() == connection)
+    {
+      open_connections.erase(it);
+      break;
+    }
+  }
+  connections_cv.notify_all();
+}
+
+static void read_requests(std::shared_ptr<Connection> connection,
+                          Scheduler &scheduler, ResultCache &cache,
+                          long long max_cells)
+{
+  LCSRequestHeader request;
+  while (read_all(connection->fd, &request, sizeof(request)))
+  {
+    if (request.magic != LCS_REQUEST_MAGIC)
+    {
+      std::cerr << "Error: bad request header, closing connection." << std::endl;
+      return;
+    }
+    // The pairs of a request with an unknown mode are read but not solved.
+    bool known_mode = request.mode == LCS_MODE_LENGTH || request.mode == LCS_MODE_STRING;
+
+    for (uint32_t pair_index = 0; pair_index < request.n_pairs; pair_index++)
+    {
+      LCSPairHeader pair;
+      if (!read_all(connection->fd, &pair, sizeof(pair)))
+        return;
+
+      if (!known_mode ||
+          ((long long)pair.length_a + 1) * ((long long)pair.length_b + 1) > max_cells)
+      {
+        // Unknown mode, or too large to hold the matrix: answer straight
+        // away, without allocating the sequences.
+        if (!skip_bytes(connection->fd, (uint64_t)pair.length_a + pair.length_b))
+          return;
+        LCSResponseHeader header = {LCS_RESPONSE_MAGIC, request.request_id,
+                                    pair_index, LCS_STATUS_ERROR, 0, 0};
+        connection->respond(header, "");
+        continue;
+      }
+
+      Job job;
+      job.connection = connection;
+      job.request_id = request.request_id;
+      job.pair_index = pair_index;
+      job.mode = request.mode;
+      job.sequence_a.resize(pair.length_a);
+      job.sequence_b.resize(pair.length_b);
+      if (!read_all(connection->fd, &job.sequence_a[0], pair.length_a) ||
+          !read_all(connection->fd, &job.sequence_b[0], pair.length_b))
+        return;
+
+      // Answer repeated pairs straight from the cache.
+      job.key = hashPair(job.sequence_a, job.sequence_b, job.mode);
+      CachedResult result;
+      if (cache.get(job.key, result))
+      {
+        LCSResponseHeader header = {LCS_RESPONSE_MAGIC, request.request_id,
+                                    pair_index, LCS_STATUS_OK,
+                                    (uint32_t)result.length,
+                                    (uint32_t)result.subsequence.length()};
+        connection->respond(header, result.subsequence);
+        continue;
+      }
+      scheduler.submit(std::move(job));
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_server",
+                           "LCS server listening on a Unix domain socket.");
+
+  int n_cores = std::max(1u, std::thread::hardware_concurrency());
+  options.add_options(
+      "server",
+      {
+          {"socket_path", "Path of the Unix domain socket to listen on.",
+           cxxopts::value<std::string>()->default_value("/tmp/lcs_server.sock")},
+          {"n_runners", "Number of jobs solved at the same time.",
+           cxxopts::value<int>()->default_value("2")},
+          {"n_threads", "Threads used by a large job (including its runner).",
+           cxxopts::value<int>()->default_value(std::to_string(n_cores))},
+          {"parallel_threshold", "Matrix entries above which a job uses the parallel solver.",
+           cxxopts::value<long long>()->default_value("4000000")},
+          {"max_cells", "Largest matrix a single job may allocate.",
+           cxxopts::value<long long>()->default_value("1000000000")},
+          {"arena_size", "Scratch memory preallocated for each runner, in megabytes.",
+           cxxopts::value<int>()->default_value("16")},
+          {"cache_size", "Memory for cached results, in megabytes (0 = no cache).",
+           cxxopts::value<int>()->default_value("64")},
+          {"cache_file", "Load cached results from this file at startup and save them on exit.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"time_limit", "Cancel a job after it has run for this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  std::string socket_path = command_options["socket_path"].as<std::string>();
+  int n_runners = std::max(1, command_options["n_runners"].as<int>());
+  int n_threads = std::max(1, command_options["n_threads"].as<int>());
+  long long parallel_threshold = command_options["parallel_threshold"].as<long long>();
+  long long max_cells = command_options["max_cells"].as<long long>();
+  size_t arena_size = std::max(1, command_options["arena_size"].as<int>());
+  size_t cache_size = std::max(0, command_options["cache_size"].as<int>());
+  std::string cache_file = command_options["cache_file"].as<std::string>();
+  double time_limit = command_options["time_limit"].as<double>();
+
+  ResultCache cache(cache_size << 20);
+  if (cache_file != "")
+  {
+    cache.load(cache_file);
+  }
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0)
+  {
+    perror("socket");
+    exit(1);
+  }
+
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socket_path.length() >= sizeof(address.sun_path))
+  {
+    std::cerr << "Error: socket path is too long." << std::endl;
+    exit(1);
+  }
+  strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+  unlink(socket_path.c_str());
+  if (bind(listen_fd, (sockaddr *)&address, sizeof(address)) < 0 ||
+      listen(listen_fd, 64) < 0)
+  {
+    perror("bind");
+    exit(1);
+  }
+
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+  signal(SIGUSR1, handle_signal); // Print statistics.
+  signal(SIGPIPE, SIG_IGN);
+
+  printf("-------------------- LCS Server --------------------\n");
+  printf("Listening on %s\n", socket_path.c_str());
+  printf("Runners: %d, threads per large job: %d\n", n_runners, n_threads);
+  fflush(stdout);
+
+  {
+    /* The runner of a large job computes one of its strips itself, so the
+    pool needs one thread less than the job uses. */
+    Scheduler scheduler(n_runners, n_threads - 1, cache, parallel_threshold,
+                        n_threads, arena_size << 20, time_limit);
+
+    while (!shutdown_requested)
+    {
+      if (stats_requested.exchange(false))
+      {
+        scheduler.printStats();
+        cache.printStats();
+        fflush(stdout);
+      }
+
+      pollfd poll_fd = {listen_fd, POLLIN, 0};
+      if (poll(&poll_fd, 1, 200) <= 0)
+        continue;
+
+      int client_fd = accept(listen_fd, NULL, NULL);
+      if (client_fd < 0)
+        continue;
+
+      auto connection = std::make_shared<Connection>(client_fd);
+      {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        open_connections.push_back(connection);
+      }
+      std::thread(serve_connection, connection, std::ref(scheduler),
+                  std::ref(cache), max_cells)
+          .detach();
+    }
+
+    printf("\nShutting down\n");
+    // Wake up the readers and wait for them to stop submitting jobs.
+    std::unique_lock<std::mutex> lock(connections_mutex);
+    for (auto &weak_connection : open_connections)
+    {
+      if (auto connection = weak_connection.lock())
+        shutdown(connection->fd, SHUT_RDWR);
+    }
+    connections_cv.wait(lock, []
+                        { return open_connections.empty(); });
+    lock.unlock();
+    scheduler.printStats();
+    cache.printStats();
+
+  }
+
+  if (cache_file != "" && !cache.save(cache_file))
+  {
+    std::cerr << "Error writing file: " << cache_file << std::endl;
+  }
+  close(listen_fd);
+  unlink(socket_path.c_str());
+  return 0;
+}
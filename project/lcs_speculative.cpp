@@ -0,0 +1,166 @@
+#include <iostream>
+#include <string>
+
+#include "cxxopts.hpp"       // Command-line option parser library
+#include "lcs_output.h"      // Binary and JSONL result formats
+#include "lcs_speculative.h" // Header file containing the LongestCommonSubsequenceSpeculative class
+
+// ***
+//  This is the experimental speculative version of the LCS program. Every
+//  thread fills its strip of columns at once from a guessed boundary, and the
+//  strips are corrected afterwards, instead of running as a pipeline.
+// ***
+
+int main(int argc, char *argv[])
+{
+  Timer program_timer;
+  program_timer.start();
+
+  cxxopts::Options options("lcs_speculative",
+                           "LCS program for CMPT 431 project using speculative threads");
+
+  options.add_options(
+      "inputs",
+      {
+          {"n_threads", "Number of threads for the program",
+           cxxopts::value<int>()->default_value("1")},
+          {"strip_width", "Columns per strip; threads take strips in turn (0 = one strip per thread).",
+           cxxopts::value<int>()->default_value("0")},
+          {"guess_columns", "Columns left of each strip used to guess its boundary (0 = all, which makes the guess exact).",
+           cxxopts::value<int>()->default_value(std::to_string(LongestCommonSubsequenceSpeculative::DEFAULT_GUESS_COLUMNS))},
+          {"parallel_traceback", "Trace the alignment back through every strip concurrently.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"orientation", "Sequence divided between the threads: auto (the longer one), keep (B) or transpose (A).",
+           cxxopts::value<std::string>()->default_value("auto")},
+          {"sequence_a", "First input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_b", "Second input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"input_file", "Path to input .csv file.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"output_format", "Result format: text, binary, jsonl or edits.",
+           cxxopts::value<std::string>()->default_value("text")},
+          {"output_file", "Path to write binary or jsonl results to (default: stdout).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"alignment", "Include the alignment as runs of matches in binary or jsonl results.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"dump_matrix", "Write the matrix to this binary file, for lcs_matrix_view.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  int n_threads = command_options["n_threads"].as<int>();
+  int strip_width = command_options["strip_width"].as<int>();
+  int guess_columns = command_options["guess_columns"].as<int>();
+  bool parallel_traceback = command_options["parallel_traceback"].as<bool>();
+
+  std::string sequence_a = command_options["sequence_a"].as<std::string>();
+  std::string sequence_b = command_options["sequence_b"].as<std::string>();
+  std::string input_file = command_options["input_file"].as<std::string>();
+  LCSOutputFormat output_format;
+  if (!parseOutputFormat(command_options["output_format"].as<std::string>(), output_format))
+  {
+    std::cerr << "Error: unknown output format: "
+              << command_options["output_format"].as<std::string>() << std::endl;
+    exit(1);
+  }
+  std::string output_file = command_options["output_file"].as<std::string>();
+  std::string dump_file = command_options["dump_matrix"].as<std::string>();
+  double time_limit = command_options["time_limit"].as<double>();
+
+  if (input_file != "")
+  {
+    // Read sequences from .csv file if file path was provided.
+    read_input_csv(input_file, sequence_a, sequence_b);
+  }
+
+  if (sequence_a.length() < 1 || sequence_b.length() < 1)
+  {
+    std::cerr << "Error: sequences cannot be empty." << std::endl;
+    exit(1);
+  }
+
+  LCSOrientation orientation;
+  if (!parseOrientation(command_options["orientation"].as<std::string>(), orientation))
+  {
+    std::cerr << "Error: unknown orientation: "
+              << command_options["orientation"].as<std::string>() << std::endl;
+    exit(1);
+  }
+
+  if (n_threads <= 0)
+  {
+    std::cerr << "Error: Number of threads must be greater than zero.\n";
+    return 1;
+  }
+  if (strip_width < 0 || guess_columns < 0)
+  {
+    std::cerr << "Error: strip width and guess columns cannot be negative.\n";
+    return 1;
+  }
+
+  LongestCommonSubsequenceSpeculative lcs(sequence_a, sequence_b, n_threads,
+                                          guess_columns, orientation);
+  lcs.setStripWidth(strip_width);
+  lcs.setParallelTraceback(parallel_traceback);
+  CancellationToken cancellation;
+  cancellation.setTimeLimit(time_limit);
+  lcs.setCancellationToken(&cancellation);
+
+  if (output_format != LCS_OUTPUT_TEXT)
+  {
+    lcs.solve();
+    if (lcs.wasCancelled())
+    {
+      lcs.printCancelled(stderr);
+      return 2;
+    }
+    if (dump_file != "" && !lcs.dumpMatrix(dump_file))
+    {
+      std::cerr << "Error writing file: " << dump_file << std::endl;
+    }
+    if (!writeResult(output_file, output_format, lcs,
+                     command_options["alignment"].as<bool>()))
+    {
+      std::cerr << "Error writing file: " << output_file << std::endl;
+      exit(1);
+    }
+    return 0;
+  }
+
+  printf("_-_-_-_-_-_-_-_-_ LCS Speculative _-_-_-_-_-_-_-_-_\n");
+  printf("Number of Threads: %d\n", n_threads);
+  if (guess_columns > 0)
+  {
+    printf("Guess Columns: %d\n", guess_columns);
+  }
+  if (lcs.isTransposed())
+  {
+    printf("Transposed: sequence A is divided between the threads\n");
+  }
+  printf("Starting LCS Speculative Solver\n");
+  lcs.solve();
+  double total_time_taken = program_timer.stop();
+
+  if (lcs.wasCancelled())
+  {
+    printf("LCS Speculative Solver Cancelled\n\n");
+    lcs.printCancelled(stdout);
+    return 2;
+  }
+  printf("LCS Speculative Solver Finished\n\n");
+
+  if (dump_file != "" && !lcs.dumpMatrix(dump_file))
+  {
+    std::cerr << "Error writing file: " << dump_file << std::endl;
+  }
+
+  printf("-_-_-_-_-_-_-_ LCS Speculative Results _-_-_-_-_-_-_-\n");
+  lcs.printInfo();
+  lcs.printSpeculationStats();
+  printf("Total time taken: %lf\n", total_time_taken);
+
+  return 0;
+}
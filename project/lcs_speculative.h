@@ -0,0 +1,212 @@
+#ifndef _LCS_SPECULATIVE_H_
+#define _LCS_SPECULATIVE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "bit_parallel.h"
+#include "lcs_parallel.h"
+
+/**
+ * @brief Experimental parallel solver that fills the strips speculatively.
+ *
+ * The parallel solver runs its strips as a pipeline: a strip cannot start a
+ * row until the strip to its left has finished it. This solver instead
+ * starts every strip at once from a guess of its left boundary column, the
+ * last column of the strip to its left, and then corrects the strips in
+ * fix-up passes:
+ *
+ * 1. In the first pass, every strip guesses its left boundary with the
+ *    bit-parallel kernel run over the guess_columns columns to the left of
+ *    the strip (all of them if guess_columns is 0, which makes the guess
+ *    exact), and fills itself from it. Strip 0 starts from the real
+ *    boundary, the column of 0s.
+ * 2. After each pass, every strip whose boundary no longer matches the
+ *    last column of the strip to its left is recomputed from that column,
+ *    all of them concurrently. Cell (i, j) depends only on rows 0 to i of
+ *    the columns before it, so the rows above the first changed row of the
+ *    boundary are already right and are left alone. The strip is recomputed
+ *    in blocks of columns, and after each block the rows above the first
+ *    row whose last column changed are final for the rest of the strip too,
+ *    so the next block starts there, and the strip stops once a block's
+ *    last column is unchanged. The top row of 0s pins every column, so a
+ *    wrong guess converges row by row from the top rather than by a shift.
+ * 3. When no strip's boundary has changed, the matrix is the same as the
+ *    serial one. Strip k is final after pass k + 1 at the latest, so there
+ *    are at most as many passes as strips.
+ *
+ * Each strip fills from its own copy of its boundary, so strips never read
+ * cells that another strip is writing and need no synchronization within a
+ * pass. Checkpoints and progress reports are not supported.
+ */
+class LongestCommonSubsequenceSpeculative : public LongestCommonSubsequenceParallel
+{
+protected:
+  // Columns recomputed between checks for convergence in the fix-up passes.
+  static const int FIXUP_BLOCK_WIDTH = 64;
+
+public:
+  // Columns left of each strip the guesses look at by default.
+  static const int DEFAULT_GUESS_COLUMNS = 1024;
+
+protected:
+  int guess_columns; // Columns the guesses look at (0 = all, exact).
+
+  std::vector<std::vector<int>> boundaries; // Left boundary of each strip.
+  std::atomic<long long> computed_cells;    // Cells computed in all passes.
+  int n_passes = 0;
+  double guess_time_taken = 0.0;
+
+  /* Guesses the left boundary of a strip from the columns before it. */
+  void guessBoundary(const int strip, std::vector<int> &boundary)
+  {
+    int start_col, end_col;
+    stripColumns(strip, start_col, end_col);
+    int first_col = guess_columns > 0 ? std::max(0, start_col - 1 - guess_columns) : 0;
+    bitParallelLastColumn(sequence_a,
+                          Sequence(sequence_b.data + first_col, start_col - 1 - first_col),
+                          boundary.data(), cancellation_token);
+  }
+
+  /* Fills rows first_row onwards of a strip from the given left boundary.
+  Unless the whole strip must be filled, each block of columns starts at the
+  first row whose last column changed in the block before, and the strip
+  stops after the first block with no changed row. Returns false if the
+  solve was cancelled. */
+  bool fillFromBoundary(const int strip, const std::vector<int> &boundary,
+                        const bool whole_strip, int first_row = 1)
+  {
+    int start_col, end_col;
+    stripColumns(strip, start_col, end_col);
+    const int block_width = whole_strip ? std::max(1, end_col - start_col + 1)
+                                        : FIXUP_BLOCK_WIDTH;
+    for (int block_start = start_col; block_start <= end_col; block_start += block_width)
+    {
+      int block_end = std::min(block_start + block_width - 1, end_col);
+      int first_changed = whole_strip ? first_row : matrix_height;
+      for (int i = first_row; i < matrix_height; i++)
+      {
+        if (i % 1024 == 0 && cancellationRequested())
+          return false;
+        int *row = matrix[i];
+        const int *above = matrix[i - 1];
+        const char a = sequence_a[i - 1];
+        int left = block_start == start_col ? boundary[i] : row[block_start - 1];
+        int diagonal = block_start == start_col ? boundary[i - 1] : above[block_start - 1];
+        int previous_last = row[block_end];
+        for (int j = block_start; j <= block_end; j++)
+        {
+          int top = above[j];
+          left = a == sequence_b[j - 1] ? diagonal + 1 : std::max(top, left);
+          diagonal = top;
+          row[j] = left;
+        }
+        if (first_changed == matrix_height && row[block_end] != previous_last)
+          first_changed = i;
+      }
+      computed_cells += (long long)(matrix_height - first_row) * (block_end - block_start + 1);
+      if (first_changed == matrix_height)
+        break;
+      first_row = first_changed;
+    }
+    return true;
+  }
+
+public:
+  LongestCommonSubsequenceSpeculative(const Sequence &sequence_a,
+                                      const Sequence &sequence_b, int threads,
+                                      int guess_columns = DEFAULT_GUESS_COLUMNS,
+                                      LCSOrientation orientation = LCS_ORIENTATION_AUTO)
+      : LongestCommonSubsequenceParallel(sequence_a, sequence_b, threads, 0, 1,
+                                         nullptr, orientation),
+        guess_columns(std::max(0, guess_columns)), computed_cells(0)
+  {
+  }
+
+  virtual void solve() override
+  {
+    solve_timer.start();
+    timer.start();
+    cancelled = false;
+    computed_cells = 0;
+
+    // First pass: every strip guesses its boundary and fills itself.
+    boundaries.assign(n_strips, std::vector<int>(matrix_height, 0));
+    std::vector<double> guess_times(n_strips, 0.0);
+    runTasks(n_strips, [this, &guess_times](int strip)
+             {
+      if (strip > 0)
+      {
+        Timer guess_timer;
+        guess_timer.start();
+        guessBoundary(strip, boundaries[strip]);
+        guess_times[strip] = guess_timer.stop();
+      }
+      if (!cancellationRequested())
+        fillFromBoundary(strip, boundaries[strip], true); });
+    guess_time_taken = *std::max_element(guess_times.begin(), guess_times.end());
+    n_passes = 1;
+
+    // Fix-up passes, until every boundary matches the strip to its left.
+    std::vector<int> changed_strips;
+    std::vector<int> first_rows(n_strips, 1);
+    while (!cancellationRequested())
+    {
+      changed_strips.clear();
+      for (int strip = 1; strip < n_strips; strip++)
+      {
+        int start_col, end_col;
+        stripColumns(strip, start_col, end_col);
+        std::vector<int> &boundary = boundaries[strip];
+        first_rows[strip] = matrix_height;
+        for (int i = 1; i < matrix_height; i++)
+        {
+          if (first_rows[strip] == matrix_height && boundary[i] != matrix[i][start_col - 1])
+            first_rows[strip] = i;
+          boundary[i] = matrix[i][start_col - 1];
+        }
+        if (first_rows[strip] < matrix_height)
+          changed_strips.push_back(strip);
+      }
+      if (changed_strips.empty())
+        break;
+      runTasks(changed_strips.size(), [this, &changed_strips, &first_rows](int k)
+               {
+        int strip = changed_strips[k];
+        fillFromBoundary(strip, boundaries[strip], false, first_rows[strip]); });
+      n_passes++;
+    }
+    cancelled = cancellationRequested();
+
+    solve_time_taken = solve_timer.stop();
+    matrix_time_taken = solve_time_taken;
+    if (cancelled)
+    {
+      // Speculative cells are not known to be right until the fix-up ends.
+      completed_cells = 0;
+      finishCancelled();
+      return;
+    }
+    completed_cells = (long long)length_a * length_b;
+
+    determineLongestCommonSubsequence();
+    time_taken = timer.stop();
+  }
+
+  // Prints how much work the speculation took compared with a single fill.
+  void printSpeculationStats()
+  {
+    long long total_cells = (long long)length_a * length_b;
+    printf("\n-_-_-_-_-_-_-_ LCS Speculative Statistics _-_-_-_-_-_-_-\n\n");
+    printf("Strips: %d\n", n_strips);
+    printf("Passes: %d\n", n_passes);
+    printf("Cells computed: %lld (%.2fx the matrix)\n", computed_cells.load(),
+           total_cells > 0 ? (double)computed_cells.load() / total_cells : 0.0);
+    printf("Time taken to guess boundaries: %f\n", guess_time_taken);
+    printf("Traceback Time Taken: %f\n", traceback_time_taken);
+    printf("Solve Time Taken: %f\n", solve_time_taken);
+  }
+};
+
+#endif
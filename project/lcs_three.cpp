@@ -0,0 +1,97 @@
+#include <iostream>
+#include <string>
+
+#include "cxxopts.hpp"  // Command-line option parser library
+#include "lcs_three.h"  // Header file containing the LongestCommonSubsequenceThree class
+
+// ***
+//  This is the three-sequence version of the LCS program. It finds the LCS
+//  of sequences A, B and C with a wavefront of tiles of the 3D matrix.
+// ***
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_three",
+                           "LCS program for CMPT 431 project for three sequences");
+
+  options.add_options(
+      "inputs",
+      {
+          {"n_threads", "Number of threads for the program",
+           cxxopts::value<int>()->default_value("1")},
+          {"tile_size", "Cells along each side of a tile of the 3D matrix.",
+           cxxopts::value<int>()->default_value("32")},
+          {"length_only", "Find only the length, keeping two planes of the matrix instead of all of it.",
+           cxxopts::value<bool>()->default_value("false")},
+          {"sequence_a", "First input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_b", "Second input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_c", "Third input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"input_file", "Path to input .csv file with three sequences.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  int n_threads = command_options["n_threads"].as<int>();
+  int tile_size = command_options["tile_size"].as<int>();
+  bool length_only = command_options["length_only"].as<bool>();
+
+  std::string sequence_a = command_options["sequence_a"].as<std::string>();
+  std::string sequence_b = command_options["sequence_b"].as<std::string>();
+  std::string sequence_c = command_options["sequence_c"].as<std::string>();
+  std::string input_file = command_options["input_file"].as<std::string>();
+  double time_limit = command_options["time_limit"].as<double>();
+
+  if (input_file != "")
+  {
+    // Read sequences from .csv file if file path was provided.
+    read_input_csv(input_file, sequence_a, sequence_b, sequence_c);
+  }
+
+  if (sequence_a.length() < 1 || sequence_b.length() < 1 || sequence_c.length() < 1)
+  {
+    std::cerr << "Error: sequences cannot be empty." << std::endl;
+    exit(1);
+  }
+
+  if (n_threads <= 0)
+  {
+    std::cerr << "Error: Number of threads must be greater than zero.\n";
+    return 1;
+  }
+  if (tile_size <= 0)
+  {
+    std::cerr << "Error: tile size must be greater than zero.\n";
+    return 1;
+  }
+
+  LongestCommonSubsequenceThree lcs(sequence_a, sequence_b, sequence_c,
+                                    n_threads, tile_size, length_only);
+  CancellationToken cancellation;
+  cancellation.setTimeLimit(time_limit);
+  lcs.setCancellationToken(&cancellation);
+
+  printf("_-_-_-_-_-_-_-_-_ LCS Three _-_-_-_-_-_-_-_-_\n");
+  printf("Number of Threads: %d\n", n_threads);
+  printf("Starting LCS Three Solver\n");
+  lcs.solve();
+
+  if (lcs.wasCancelled())
+  {
+    printf("LCS Three Solver Cancelled\n\n");
+    lcs.printCancelled(stdout);
+    return 2;
+  }
+  printf("LCS Three Solver Finished\n\n");
+
+  printf("-_-_-_-_-_-_-_ LCS Three Results _-_-_-_-_-_-_-\n");
+  lcs.printInfo();
+  lcs.printTimeTaken();
+  lcs.printWavefrontStats();
+
+  return 0;
+}
@@ -0,0 +1,417 @@
+#ifndef _LCS_THREE_H_
+#define _LCS_THREE_H_
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cancellation.h"
+#include "thread_pool.h"
+#include "timer.h"
+
+/* Computes the cells [j0, j1) x [k0, k1) of a plane of the 3D matrix, whose
+character of sequence_a is a, from the plane before it, `above`. Both planes
+have rows of length_c + 1 cells, one per character of b. */
+inline void computeThreeBlock(const char a, const char *b, const char *c,
+                              const int length_c, const int *above, int *plane,
+                              const int j0, const int j1, const int k0, const int k1)
+{
+  const int width = length_c + 1;
+  for (int j = j0; j < j1; j++)
+  {
+    const char b_j = b[j - 1];
+    const int *above_row = above + (size_t)j * width;
+    const int *above_left_row = above_row - width;
+    const int *left_row = plane + (size_t)(j - 1) * width;
+    int *row = plane + (size_t)j * width;
+    for (int k = k0; k < k1; k++)
+    {
+      if (a == b_j && b_j == c[k - 1])
+        row[k] = above_left_row[k - 1] + 1;
+      else
+        row[k] = std::max(std::max(above_row[k], left_row[k]), row[k - 1]);
+    }
+  }
+}
+
+/**
+ * @brief Finds the LCS of three sequences, on several threads.
+ *
+ * The matrix becomes a cube: cell (i, j, k) is the length of the LCS of the
+ * first i characters of sequence_a, j of sequence_b and k of sequence_c, and
+ * it depends on the three cells before it along each axis and, when all
+ * three characters match, the one before it along the diagonal.
+ *
+ * The cube is divided into tiles of tile_size^3 cells, and the tiles are
+ * computed in planes i + j + k = d of tiles: every tile in a plane depends
+ * only on tiles of the planes before it, so the tiles of a plane run
+ * concurrently, with one synchronization per plane. The alignment is traced
+ * back from the far corner.
+ *
+ * When only the length is needed, the cube is computed one slab of
+ * tile_size planes of constant i at a time, keeping only the plane before
+ * the slab, its last plane, and the faces between its tiles, so the memory
+ * is O(length_b * length_c) instead of the whole cube. Each slab is a 2D
+ * wavefront of tiles over its anti-diagonals.
+ */
+class LongestCommonSubsequenceThree
+{
+protected:
+  // Planes smaller than this are computed by a single thread.
+  static const long long PARALLEL_PLANE_CELLS = 1 << 16;
+
+  std::string sequence_a;
+  std::string sequence_b;
+  std::string sequence_c;
+  const int length_a, length_b, length_c;
+  int numThreads;
+  int tile_size;
+  bool length_only;
+
+  ThreadPool thread_pool;
+
+  std::vector<int> cube; // The whole cube, unless length_only.
+  std::vector<int> planes[2]; // Planes i - 1 and i, if length_only.
+  // The last rows and columns of the tiles of a slab (see fillPlanes()).
+  std::vector<int> row_faces;
+  std::vector<int> column_faces;
+  int tiles_b = 0, tiles_c = 0;
+
+  int lcs_length = 0;
+  std::string longest_common_subsequence;
+
+  CancellationToken *cancellation_token = nullptr;
+  bool cancelled = false;
+  long long completed_cells = 0;
+  int n_wavefront_steps = 0;
+
+  Timer timer;
+  double matrix_time_taken = 0.0;
+  double time_taken = 0.0;
+
+  bool cancellationRequested()
+  {
+    return cancellation_token && cancellation_token->isCancelled();
+  }
+
+  size_t cell(const int i, const int j, const int k) const
+  {
+    return ((size_t)i * (length_b + 1) + j) * (length_c + 1) + k;
+  }
+
+  void computeBlock(const int i, const int *above, int *plane, const int j0,
+                    const int j1, const int k0, const int k1) const
+  {
+    computeThreeBlock(sequence_a[i - 1], sequence_b.data(), sequence_c.data(),
+                      length_c, above, plane, j0, j1, k0, k1);
+  }
+
+  /* Fills the whole cube as a wavefront of tiles. Returns false if the
+  solve was cancelled. */
+  bool fillCube()
+  {
+    cube.assign(cell(length_a + 1, 0, 0), 0);
+    const int plane_cells = (length_b + 1) * (length_c + 1);
+    const int tiles_a = (length_a + tile_size - 1) / tile_size;
+    const int tiles_b = (length_b + tile_size - 1) / tile_size;
+    const int tiles_c = (length_c + tile_size - 1) / tile_size;
+
+    struct Tile
+    {
+      int i, j, k;
+    };
+    std::vector<Tile> tiles;
+    for (int d = 0; d < tiles_a + tiles_b + tiles_c - 2; d++)
+    {
+      if (cancellationRequested())
+        return false;
+      tiles.clear();
+      for (int ti = std::max(0, d - tiles_b - tiles_c + 2); ti < tiles_a && ti <= d; ti++)
+      {
+        for (int tj = std::max(0, d - ti - tiles_c + 1); tj < tiles_b && ti + tj <= d; tj++)
+        {
+          tiles.push_back(Tile{ti, tj, d - ti - tj});
+        }
+      }
+      thread_pool.run(tiles.size(), [&](int t)
+                      {
+        const Tile &tile = tiles[t];
+        int i_end = std::min(length_a, (tile.i + 1) * tile_size);
+        int j0 = tile.j * tile_size + 1, j1 = std::min(length_b, (tile.j + 1) * tile_size) + 1;
+        int k0 = tile.k * tile_size + 1, k1 = std::min(length_c, (tile.k + 1) * tile_size) + 1;
+        for (int i = tile.i * tile_size + 1; i <= i_end; i++)
+        {
+          int *plane = cube.data() + (size_t)i * plane_cells;
+          computeBlock(i, plane - plane_cells, plane, j0, j1, k0, k1);
+        } });
+      n_wavefront_steps++;
+    }
+    lcs_length = cube[cell(length_a, length_b, length_c)];
+    return true;
+  }
+
+  /* Computes the tile (tj, tk) of the slab of planes [i0, i1) in a scratch
+  block of its own, then writes its last plane to `plane` and its last row
+  and column of every plane to the faces, for the tiles after it. */
+  void computeSlabTile(const int i0, const int i1, const int tj, const int tk,
+                       const int *above, int *plane)
+  {
+    const int width = length_c + 1;
+    const int j0 = tj * tile_size + 1, j1 = std::min(length_b, (tj + 1) * tile_size) + 1;
+    const int k0 = tk * tile_size + 1, k1 = std::min(length_c, (tk + 1) * tile_size) + 1;
+    const int n_rows = j1 - j0, n_cols = k1 - k0;
+    // Plane p of the block holds plane i0 - 1 + p of the cube, with a row
+    // and a column before the tile, so it fits the same kernel.
+    const int block_width = n_cols + 1;
+    const size_t block_cells = (size_t)(n_rows + 1) * block_width;
+    thread_local std::vector<int> block;
+    block.resize((size_t)(i1 - i0 + 1) * block_cells);
+
+    for (int r = 0; r <= n_rows; r++)
+    {
+      std::copy(above + (size_t)(j0 - 1 + r) * width + k0 - 1,
+                above + (size_t)(j0 - 1 + r) * width + k1,
+                block.begin() + (size_t)r * block_width);
+    }
+    for (int i = i0; i < i1; i++)
+    {
+      const int p = i - i0 + 1;
+      int *current = block.data() + p * block_cells;
+      // The row before the tile, from the tile before it along j, and its
+      // column before the tile, from the tile before it along k. The first
+      // row and column of the cube are 0.
+      const int *row_face = row_faces.data() + ((size_t)(p - 1) * tiles_b + tj - 1) * width;
+      for (int q = 0; q <= n_cols; q++)
+        current[q] = tj > 0 ? row_face[k0 - 1 + q] : 0;
+      const int *column_face =
+          column_faces.data() + ((size_t)(p - 1) * tiles_c + tk - 1) * (length_b + 1);
+      for (int r = 1; r <= n_rows; r++)
+        current[r * block_width] = tk > 0 ? column_face[j0 - 1 + r] : 0;
+
+      computeThreeBlock(sequence_a[i - 1], sequence_b.data() + j0 - 1,
+                        sequence_c.data() + k0 - 1, n_cols, current - block_cells,
+                        current, 1, n_rows + 1, 1, n_cols + 1);
+
+      int *own_row_face = row_faces.data() + ((size_t)(p - 1) * tiles_b + tj) * width;
+      std::copy(current + (size_t)n_rows * block_width + 1,
+                current + (size_t)n_rows * block_width + block_width,
+                own_row_face + k0);
+      int *own_column_face =
+          column_faces.data() + ((size_t)(p - 1) * tiles_c + tk) * (length_b + 1);
+      for (int r = 1; r <= n_rows; r++)
+        own_column_face[j0 - 1 + r] = current[r * block_width + n_cols];
+    }
+
+    const int *last = block.data() + (size_t)(i1 - i0) * block_cells;
+    for (int r = 1; r <= n_rows; r++)
+    {
+      std::copy(last + (size_t)r * block_width + 1, last + (size_t)r * block_width + block_width,
+                plane + (size_t)(j0 - 1 + r) * width + k0);
+    }
+  }
+
+  /* Computes the cube one plane at a time, keeping two planes. Returns false
+  if the solve was cancelled.
+
+  On several threads, the planes are taken tile_size at a time, in slabs,
+  and a slab is a 2D wavefront of tile_size^3 tiles, as in fillCube(), so
+  that every synchronization covers a whole tile. Between the planes of a
+  slab, a tile needs only the last row and column of its neighbors, which
+  are kept in the faces: row_faces holds the last row of every tile along j
+  for each plane of the slab, and column_faces the last column along k. */
+  bool fillPlanes()
+  {
+    const int plane_cells = (length_b + 1) * (length_c + 1);
+    planes[0].assign(plane_cells, 0);
+    planes[1].assign(plane_cells, 0);
+    const bool parallel = numThreads > 1 && plane_cells >= PARALLEL_PLANE_CELLS;
+
+    if (!parallel)
+    {
+      for (int i = 1; i <= length_a; i++)
+      {
+        if (cancellationRequested())
+          return false;
+        computeBlock(i, planes[(i - 1) % 2].data(), planes[i % 2].data(), 1,
+                     length_b + 1, 1, length_c + 1);
+        completed_cells += (long long)length_b * length_c;
+      }
+      lcs_length = planes[length_a % 2][(size_t)length_b * (length_c + 1) + length_c];
+      return true;
+    }
+
+    tiles_b = (length_b + tile_size - 1) / tile_size;
+    tiles_c = (length_c + tile_size - 1) / tile_size;
+    const int slab_height = std::min(tile_size, length_a);
+    row_faces.assign((size_t)slab_height * tiles_b * (length_c + 1), 0);
+    column_faces.assign((size_t)slab_height * tiles_c * (length_b + 1), 0);
+
+    int n_slabs = 0;
+    for (int i0 = 1; i0 <= length_a; i0 += tile_size, n_slabs++)
+    {
+      const int i1 = std::min(length_a + 1, i0 + tile_size);
+      const int *above = planes[n_slabs % 2].data();
+      int *plane = planes[(n_slabs + 1) % 2].data();
+      // The tiles on an anti-diagonal of the slab depend only on the tiles
+      // of the anti-diagonals before it.
+      for (int d = 0; d < tiles_b + tiles_c - 1; d++)
+      {
+        if (cancellationRequested())
+          return false;
+        int tj_first = std::max(0, d - tiles_c + 1);
+        int tj_end = std::min(tiles_b, d + 1);
+        thread_pool.run(tj_end - tj_first, [&](int t)
+                        { computeSlabTile(i0, i1, tj_first + t, d - tj_first - t, above, plane); });
+        n_wavefront_steps++;
+      }
+      completed_cells += (long long)(i1 - i0) * length_b * length_c;
+    }
+    lcs_length = planes[n_slabs % 2][(size_t)length_b * (length_c + 1) + length_c];
+    return true;
+  }
+
+  /* Walks back from the far corner of the cube to find the subsequence. */
+  void traceback()
+  {
+    longest_common_subsequence.clear();
+    int i = length_a, j = length_b, k = length_c;
+    while (i > 0 && j > 0 && k > 0)
+    {
+      int current = cube[cell(i, j, k)];
+      if (sequence_a[i - 1] == sequence_b[j - 1] &&
+          sequence_b[j - 1] == sequence_c[k - 1] &&
+          cube[cell(i - 1, j - 1, k - 1)] + 1 == current)
+      {
+        longest_common_subsequence += sequence_a[i - 1];
+        i--;
+        j--;
+        k--;
+      }
+      else if (cube[cell(i - 1, j, k)] == current)
+        i--;
+      else if (cube[cell(i, j - 1, k)] == current)
+        j--;
+      else
+        k--;
+    }
+    std::reverse(longest_common_subsequence.begin(), longest_common_subsequence.end());
+  }
+
+public:
+  /* With length_only, only the length is found, in O(length_b * length_c)
+  memory instead of the whole cube. */
+  LongestCommonSubsequenceThree(const std::string &sequence_a,
+                                const std::string &sequence_b,
+                                const std::string &sequence_c,
+                                const int n_threads, const int tile_size = 32,
+                                const bool length_only = false)
+      : sequence_a(sequence_a), sequence_b(sequence_b), sequence_c(sequence_c),
+        length_a(sequence_a.length()), length_b(sequence_b.length()),
+        length_c(sequence_c.length()), numThreads(std::max(1, n_threads)),
+        tile_size(std::max(1, tile_size)), length_only(length_only),
+        thread_pool(std::max(1, n_threads) - 1)
+  {
+  }
+
+  void solve()
+  {
+    timer.start();
+    cancelled = false;
+    completed_cells = 0;
+    n_wavefront_steps = 0;
+    longest_common_subsequence.clear();
+
+    if (length_only)
+    {
+      cancelled = !fillPlanes();
+    }
+    else
+    {
+      cancelled = !fillCube();
+      completed_cells = cancelled ? 0 : (long long)length_a * length_b * length_c;
+    }
+    matrix_time_taken = timer.stop();
+
+    if (!cancelled && !length_only)
+    {
+      traceback();
+    }
+    time_taken = timer.stop();
+  }
+
+  void setCancellationToken(CancellationToken *token)
+  {
+    cancellation_token = token;
+  }
+
+  bool wasCancelled() const
+  {
+    return cancelled;
+  }
+
+  int getLongestSubsequenceLength() const
+  {
+    return lcs_length;
+  }
+
+  const std::string &getLongestCommonSubsequence() const
+  {
+    return longest_common_subsequence;
+  }
+
+  void printInfo()
+  {
+    std::cout << "Sequence A: " << sequence_a << "\n";
+    std::cout << "Sequence B: " << sequence_b << "\n";
+    std::cout << "Sequence C: " << sequence_c << "\n";
+    if (!length_only)
+      std::cout << "Longest common subsequence: " << longest_common_subsequence << "\n";
+    std::cout << "Length of the longest common subsequence: " << lcs_length << "\n";
+  }
+
+  void printTimeTaken()
+  {
+    printf("Time taken to compute matrix: %lf\n", matrix_time_taken);
+    printf("Total time taken: %lf\n", time_taken);
+  }
+
+  // Prints how the cube was divided between the threads.
+  void printWavefrontStats()
+  {
+    printf("\n-_-_-_-_-_-_-_ LCS Three Statistics _-_-_-_-_-_-_-\n\n");
+    printf("Tile Size: %d\n", tile_size);
+    printf("Wavefront Steps: %d\n", n_wavefront_steps);
+    printf("Memory: %s\n", !length_only          ? "whole cube"
+                            : row_faces.empty() ? "two planes"
+                                                : "two planes and the faces of a slab");
+  }
+
+  // Prints how far a cancelled solve got.
+  void printCancelled(FILE *out_file)
+  {
+    long long total_cells = (long long)length_a * length_b * length_c;
+    fprintf(out_file, "Solve cancelled after %lf seconds\n", time_taken);
+    fprintf(out_file, "Cells computed: %lld of %lld (%.1f%%)\n", completed_cells,
+            total_cells, total_cells > 0 ? 100.0 * completed_cells / total_cells : 0.0);
+  }
+};
+
+/* Reads three comma-separated sequences, like read_input_csv() reads two. */
+inline void read_input_csv(const std::string &input_file_path, std::string &sequence_a,
+                           std::string &sequence_b, std::string &sequence_c)
+{
+  std::ifstream in_file(input_file_path);
+  if (!in_file.is_open())
+  {
+    std::cerr << "Error reading file: " << input_file_path << std::endl;
+    exit(1);
+  }
+  std::getline(in_file, sequence_a, ',');
+  std::getline(in_file, sequence_b, ',');
+  std::getline(in_file, sequence_c, ',');
+}
+
+#endif
@@ -0,0 +1,272 @@
+#include <algorithm> // std::max, std::min, std::sort
+#include <iostream>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "lcs_three.h"
+
+/* Tag used for the boundary messages sent between neighbors. */
+#define BOUNDARY_TAG 0
+
+/**
+ * Finds the length of the LCS of three sequences on several processes.
+ *
+ * Like lcs_distributed, sequence_b is divided between the processes, so each
+ * process owns a slab of the 3D matrix: all of sequence_a and sequence_c, and
+ * its own range of sequence_b. The slab is computed one plane of constant i
+ * at a time, keeping two planes. A plane needs the last column of the same
+ * plane of the neighbor to the left, a row of length_c + 1 values, so the
+ * processes form a pipeline along sequence_a, and the boundaries of
+ * block_height planes are sent in a single message.
+ *
+ * Only the length is computed; tracing the alignment back would need every
+ * process to keep its whole slab.
+ * */
+class LCSThreeDistributed
+{
+protected:
+  const int world_size;
+  const int world_rank;
+
+  const std::string sequence_a;
+  const std::string sequence_b; // This process's range of sequence_b.
+  const std::string sequence_c;
+  const int length_a, length_b, length_c;
+
+  /* Number of planes whose boundary values are exchanged in a single message. */
+  const int block_height;
+  /* The boundary values of one block of planes, followed by the cancellation
+  flag. */
+  std::vector<int> boundary_buffer;
+
+  std::vector<int> planes[2];
+
+  CancellationToken *cancellation_token = nullptr;
+  bool cancelled = false;
+  int lcs_length = 0;
+  double time_taken = 0.0;
+
+  bool cancellationRequested()
+  {
+    return cancellation_token && cancellation_token->isCancelled();
+  }
+
+  /* Receives the last columns of the neighbor to the left for a block of
+  planes, unless we are the leftmost process, whose left column is all 0s.
+  Only the root process polls its cancellation token and passes the flag on,
+  as in lcs_distributed. Returns false if the solve was cancelled. */
+  bool receiveBoundary(const int n_planes)
+  {
+    const int width = length_c + 1;
+    if (world_rank == 0)
+    {
+      std::fill(boundary_buffer.begin(), boundary_buffer.end(), 0);
+      return !cancellationRequested();
+    }
+    MPI_Recv(boundary_buffer.data(), n_planes * width + 1, MPI_INT,
+             world_rank - 1, BOUNDARY_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    return !boundary_buffer[n_planes * width];
+  }
+
+  /* Sends the last columns of a block of planes, which computePlanes() left
+  in the buffer, to the neighbor to the right. */
+  void sendBoundary(const int n_planes, const bool stop = false)
+  {
+    if (world_rank == world_size - 1)
+      return;
+    const int width = length_c + 1;
+    boundary_buffer[n_planes * width] = stop;
+    MPI_Send(boundary_buffer.data(), n_planes * width + 1, MPI_INT,
+             world_rank + 1, BOUNDARY_TAG, MPI_COMM_WORLD);
+  }
+
+  /* Computes the planes of a block from the boundary columns in the buffer,
+  and replaces them with this slab's last columns. */
+  void computePlanes(const int block_start, const int n_planes)
+  {
+    const int width = length_c + 1;
+    for (int p = 0; p < n_planes; p++)
+    {
+      int i = block_start + p;
+      const int *above = planes[(i - 1) % 2].data();
+      int *plane = planes[i % 2].data();
+      int *boundary = boundary_buffer.data() + (size_t)p * width;
+      std::copy(boundary, boundary + width, plane);
+      computeThreeBlock(sequence_a[i - 1], sequence_b.data(), sequence_c.data(),
+                        length_c, above, plane, 1, length_b + 1, 1, length_c + 1);
+      std::copy(plane + (size_t)length_b * width, plane + (size_t)(length_b + 1) * width,
+                boundary);
+    }
+  }
+
+public:
+  LCSThreeDistributed(const std::string &sequence_a, const std::string &local_sequence_b,
+                      const std::string &sequence_c, const int world_size,
+                      const int world_rank, const int block_height)
+      : world_size(world_size), world_rank(world_rank), sequence_a(sequence_a),
+        sequence_b(local_sequence_b), sequence_c(sequence_c),
+        length_a(sequence_a.length()), length_b(local_sequence_b.length()),
+        length_c(sequence_c.length()), block_height(std::max(1, block_height)),
+        boundary_buffer((size_t)std::max(1, block_height) * (sequence_c.length() + 1) + 1)
+  {
+  }
+
+  void setCancellationToken(CancellationToken *token)
+  {
+    cancellation_token = token;
+  }
+
+  void solve()
+  {
+    double start_time = MPI_Wtime();
+    const size_t plane_cells = (size_t)(length_b + 1) * (length_c + 1);
+    planes[0].assign(plane_cells, 0);
+    planes[1].assign(plane_cells, 0);
+    cancelled = false;
+
+    for (int block_start = 1; block_start <= length_a; block_start += block_height)
+    {
+      int n_planes = std::min(block_height, length_a - block_start + 1);
+      if (!receiveBoundary(n_planes))
+      {
+        // Pass the flag on, so that every rank stops.
+        sendBoundary(n_planes, true);
+        cancelled = true;
+        break;
+      }
+      computePlanes(block_start, n_planes);
+      sendBoundary(n_planes);
+    }
+
+    // The rightmost process holds the far corner of the matrix.
+    int corner = cancelled ? 0 : planes[length_a % 2][plane_cells - 1];
+    MPI_Bcast(&corner, 1, MPI_INT, world_size - 1, MPI_COMM_WORLD);
+    lcs_length = corner;
+    time_taken = MPI_Wtime() - start_time;
+  }
+
+  bool wasCancelled() const
+  {
+    return cancelled;
+  }
+
+  int getLongestSubsequenceLength() const
+  {
+    return lcs_length;
+  }
+
+  double getTimeTaken() const
+  {
+    return time_taken;
+  }
+};
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_three_distributed",
+                           "Distributed LCS of three sequences using MPI.");
+
+  options.add_options(
+      "inputs",
+      {
+          {"sequence_a", "First input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_b", "Second input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"sequence_c", "Third input sequence.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"input_file", "Path to input .csv file with three sequences.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"block_height", "Planes per boundary message between processes.",
+           cxxopts::value<int>()->default_value("1")},
+          {"time_limit", "Cancel the solve after this many seconds (0 = no limit).",
+           cxxopts::value<double>()->default_value("0")},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  std::string sequence_a = command_options["sequence_a"].as<std::string>();
+  std::string sequence_b = command_options["sequence_b"].as<std::string>();
+  std::string sequence_c = command_options["sequence_c"].as<std::string>();
+  std::string input_file = command_options["input_file"].as<std::string>();
+  int block_height = command_options["block_height"].as<int>();
+  double time_limit = command_options["time_limit"].as<double>();
+
+  if (input_file != "")
+  {
+    // Read sequences from .csv file if file path was provided.
+    read_input_csv(input_file, sequence_a, sequence_b, sequence_c);
+  }
+
+  if (sequence_a.length() < 1 || sequence_b.length() < 1 || sequence_c.length() < 1)
+  {
+    std::cerr << "Error: sequences cannot be empty." << std::endl;
+    exit(1);
+  }
+  if (block_height <= 0)
+  {
+    std::cerr << "Error: block height must be greater than zero." << std::endl;
+    exit(1);
+  }
+
+  MPI_Init(NULL, NULL);
+  int exit_code = 0;
+
+  int world_size;
+  MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+  int world_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+
+  /* The LCS does not depend on the order of the sequences, so divide the
+  longest one between the processes and send boundaries along the shortest. */
+  std::vector<std::string> sequences = {sequence_a, sequence_b, sequence_c};
+  std::sort(sequences.begin(), sequences.end(),
+            [](const std::string &x, const std::string &y)
+            { return x.length() < y.length(); });
+  sequence_c = sequences[0];
+  sequence_a = sequences[1];
+  sequence_b = sequences[2];
+
+  int n_columns = sequence_b.length();
+  const int min_n_cols_per_process = n_columns / world_size;
+  const int excess = n_columns % world_size;
+  int n_cols = min_n_cols_per_process + (world_rank < excess);
+  int start_col = world_rank * min_n_cols_per_process + std::min(world_rank, excess);
+
+  if (world_rank == 0)
+  {
+    printf("-------------------- LCS Three Distributed --------------------\n");
+    printf("n_processes: %d\n", world_size);
+    printf("block_height: %d\n", block_height);
+    printf("divided: the longest sequence, of length %d\n\n", n_columns);
+  }
+
+  LCSThreeDistributed lcs(sequence_a, sequence_b.substr(start_col, n_cols),
+                          sequence_c, world_size, world_rank, block_height);
+  // Only the root process enforces the time limit; it tells the others.
+  CancellationToken cancellation;
+  if (world_rank == 0)
+  {
+    cancellation.setTimeLimit(time_limit);
+    lcs.setCancellationToken(&cancellation);
+  }
+  lcs.solve();
+
+  if (lcs.wasCancelled())
+  {
+    if (world_rank == 0)
+      printf("Solve cancelled after %lf seconds\n", lcs.getTimeTaken());
+    exit_code = 2;
+  }
+  else if (world_rank == 0)
+  {
+    std::cout << "Length of the longest common subsequence: "
+              << lcs.getLongestSubsequenceLength() << "\n";
+    printf("Total time taken: %lf\n", lcs.getTimeTaken());
+  }
+
+  MPI_Finalize();
+
+  return exit_code;
+}
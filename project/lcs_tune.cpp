@@ -0,0 +1,337 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <limits.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cxxopts.hpp"
+#include "lcs_parallel.h"
+#include "tuning.h"
+
+// ***
+//  Auto-tuner for the parallel and distributed LCS programs. For every size
+//  class it times a sweep of thread counts, strip widths and tile sizes on a
+//  representative input, and saves the fastest configuration to the tuning
+//  file that lcs_parallel and lcs_distributed load at startup.
+// ***
+
+/* Candidate tile sizes. A tile width of 0 covers a thread's whole strip. */
+static const int TILE_WIDTH_CANDIDATES[] = {0, 64, 256, 1024};
+static const int TILE_HEIGHT_CANDIDATES[] = {1, 4, 16, 64};
+/* Besides one strip per thread, strips of 1/k of a thread's share of the
+columns, which the threads take in turn. */
+static const int STRIPS_PER_THREAD_CANDIDATES[] = {2, 4, 8};
+
+// Generates a random DNA sequence, as generate_sequences.py does.
+std::string generate_sequence(const int length, std::mt19937 &generator)
+{
+  static const char bases[] = "CGTA";
+  std::uniform_int_distribution<int> distribution(0, 3);
+  std::string sequence(length, ' ');
+  for (int i = 0; i < length; i++)
+  {
+    sequence[i] = bases[distribution(generator)];
+  }
+  return sequence;
+}
+
+// Parses a comma-separated list of integers, e.g. "100,1000,10000".
+std::vector<int> parse_int_list(const std::string &list)
+{
+  std::vector<int> values;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    if (!item.empty())
+    {
+      values.push_back(std::stoi(item));
+    }
+  }
+  return values;
+}
+
+// Returns the path of another program of the project, which is built into the
+// same directory as this one.
+std::string program_path(const char *argv0, const std::string &name)
+{
+  std::string self = argv0;
+  if (self.find('/') == std::string::npos)
+  {
+    // Found on the PATH, so ask the kernel where it is.
+    char path[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    self = length > 0 ? std::string(path, length) : "./";
+  }
+  return self.substr(0, self.rfind('/') + 1) + name;
+}
+
+// Writes a pair of sequences to a new temporary .csv file and returns its
+// path, or "" on failure.
+std::string write_temporary_input(const std::string &sequence_a,
+                                  const std::string &sequence_b)
+{
+  char path[] = "/tmp/lcs_tune_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0)
+    return "";
+  close(fd);
+  std::ofstream out_file(path);
+  out_file << sequence_a << ',' << sequence_b;
+  out_file.close();
+  if (!out_file)
+  {
+    unlink(path);
+    return "";
+  }
+  return path;
+}
+
+// Runs a program with the given arguments, without a shell, and waits for it.
+// Returns true if it exited with status 0.
+bool run_program(const std::vector<std::string> &arguments)
+{
+  std::vector<char *> argv;
+  for (const std::string &argument : arguments)
+  {
+    argv.push_back(const_cast<char *>(argument.c_str()));
+  }
+  argv.push_back(NULL);
+
+  pid_t pid = fork();
+  if (pid < 0)
+    return false;
+  if (pid == 0)
+  {
+    execvp(argv[0], argv.data());
+    perror(argv[0]);
+    _exit(127);
+  }
+  int status;
+  if (waitpid(pid, &status, 0) < 0)
+    return false;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Returns the average solve time of a configuration over n_runs runs.
+double time_parallel(const std::string &sequence_a, const std::string &sequence_b,
+                     const TuningConfig &config, const int n_runs)
+{
+  double time_taken = 0.0;
+  for (int run = 0; run < n_runs; run++)
+  {
+    LongestCommonSubsequenceParallel lcs(sequence_a, sequence_b,
+                                         config.n_threads, config.tile_width,
+                                         config.tile_height);
+    lcs.setStripWidth(config.strip_width);
+    lcs.solve();
+    time_taken += lcs.getSolveTimeTaken();
+  }
+  return time_taken / n_runs;
+}
+
+// Returns the strip widths to try with n_threads threads: 0 for one strip per
+// thread, then narrower strips, skipping any that are too narrow or repeated.
+std::vector<int> strip_width_candidates(const int n_columns, const int n_threads)
+{
+  std::vector<int> strip_widths = {0};
+  for (int strips_per_thread : STRIPS_PER_THREAD_CANDIDATES)
+  {
+    int strip_width = n_columns / (strips_per_thread * n_threads);
+    if (strip_width < 1 || strip_width == strip_widths.back())
+      break;
+    strip_widths.push_back(strip_width);
+  }
+  return strip_widths;
+}
+
+// Sweeps thread counts, strip widths and tile sizes and returns the fastest
+// configuration.
+TuningConfig tune_parallel(const std::string &sequence_a,
+                           const std::string &sequence_b,
+                           const std::vector<int> &thread_counts,
+                           const int n_runs)
+{
+  TuningConfig best_config;
+  double best_time = -1.0;
+
+  printf("n_threads | strip_width | tile_width | tile_height | time_taken\n");
+  for (int n_threads : thread_counts)
+  {
+    // The columns of the matrix, which the solver may have transposed.
+    int n_columns = shouldTranspose(LCS_ORIENTATION_AUTO, sequence_a.length(),
+                                    sequence_b.length(), n_threads)
+                        ? sequence_a.length()
+                        : sequence_b.length();
+    for (int strip_width : strip_width_candidates(n_columns, n_threads))
+    {
+      int strip_columns = strip_width > 0 ? strip_width : n_columns / n_threads;
+      for (int tile_width : TILE_WIDTH_CANDIDATES)
+      {
+        if (tile_width > 0 && tile_width >= strip_columns)
+          continue; // Same as a tile covering the whole strip.
+
+        for (int tile_height : TILE_HEIGHT_CANDIDATES)
+        {
+          if (tile_height > 1 && tile_height / 4 >= (int)sequence_a.length())
+            continue; // Larger tiles would all behave the same.
+
+          TuningConfig config;
+          config.n_threads = n_threads;
+          config.tile_width = tile_width;
+          config.tile_height = tile_height;
+          config.strip_width = strip_width;
+          double time_taken = time_parallel(sequence_a, sequence_b, config, n_runs);
+          printf("%9d | %11d | %10d | %11d | %lf\n", n_threads, strip_width,
+                 tile_width, tile_height, time_taken);
+
+          if (best_time < 0.0 || time_taken < best_time)
+          {
+            best_time = time_taken;
+            best_config = config;
+          }
+        }
+      }
+    }
+  }
+  return best_config;
+}
+
+int main(int argc, char *argv[])
+{
+  cxxopts::Options options("lcs_tune",
+                           "Auto-tuner for the parallel and distributed LCS programs.");
+
+  options.add_options(
+      "inputs",
+      {
+          {"lengths", "Comma-separated sequence lengths of the random inputs to tune on.",
+           cxxopts::value<std::string>()->default_value("100,1000,10000")},
+          {"input_file", "Tune on the sequences in this .csv file instead of random inputs.",
+           cxxopts::value<std::string>()->default_value("")},
+          {"thread_counts", "Comma-separated thread counts to try (default: powers of two up to the core count).",
+           cxxopts::value<std::string>()->default_value("")},
+          {"n_processes", "Also tune the block height of lcs_distributed with this many MPI processes (0 = skip).",
+           cxxopts::value<int>()->default_value("0")},
+          {"n_runs", "Number of runs per configuration.",
+           cxxopts::value<int>()->default_value("3")},
+          {"tuning_file", "Path to the tuning .csv file to update.",
+           cxxopts::value<std::string>()->default_value(DEFAULT_TUNING_FILE)},
+      });
+
+  auto command_options = options.parse(argc, argv);
+  std::vector<int> lengths = parse_int_list(command_options["lengths"].as<std::string>());
+  std::string input_file = command_options["input_file"].as<std::string>();
+  std::vector<int> thread_counts = parse_int_list(command_options["thread_counts"].as<std::string>());
+  int n_processes = command_options["n_processes"].as<int>();
+  int n_runs = std::max(1, command_options["n_runs"].as<int>());
+  std::string tuning_file = command_options["tuning_file"].as<std::string>();
+
+  if (thread_counts.empty())
+  {
+    int n_cores = std::max(1u, std::thread::hardware_concurrency());
+    for (int n_threads = 1; n_threads <= n_cores; n_threads *= 2)
+    {
+      thread_counts.push_back(n_threads);
+    }
+  }
+
+  // Collect one representative input per size class.
+  std::vector<std::pair<std::string, std::string>> inputs;
+  if (input_file != "")
+  {
+    std::string sequence_a, sequence_b;
+    read_input_csv(input_file, sequence_a, sequence_b);
+    inputs.emplace_back(sequence_a, sequence_b);
+  }
+  else
+  {
+    std::mt19937 generator(431);
+    for (int length : lengths)
+    {
+      if (length < 1)
+        continue;
+      std::string sequence_a = generate_sequence(length, generator);
+      std::string sequence_b = generate_sequence(length, generator);
+      inputs.emplace_back(sequence_a, sequence_b);
+    }
+  }
+
+  printf("-------------------- LCS Tune --------------------\n");
+  TuningTable tuning_table;
+  tuning_table.load(tuning_file);
+
+  for (const auto &input : inputs)
+  {
+    const std::string &sequence_a = input.first;
+    const std::string &sequence_b = input.second;
+    if (sequence_a.empty() || sequence_b.empty())
+    {
+      std::cerr << "Error: sequences cannot be empty." << std::endl;
+      exit(1);
+    }
+    int size_class = sizeClass(sequence_a.length(), sequence_b.length());
+    printf("\nSize class %d (L = %zu x %zu)\n", size_class, sequence_a.length(),
+           sequence_b.length());
+
+    TuningConfig best_config = tune_parallel(sequence_a, sequence_b,
+                                             thread_counts, n_runs);
+    // Keep a previously tuned block height for this size class.
+    if (tuning_table.contains(size_class))
+    {
+      best_config.block_height = tuning_table[size_class].block_height;
+    }
+    tuning_table[size_class] = best_config;
+    printf("Best: n_threads=%d strip_width=%d tile_width=%d tile_height=%d\n",
+           best_config.n_threads, best_config.strip_width, best_config.tile_width,
+           best_config.tile_height);
+
+    if (!tuning_table.save(tuning_file))
+    {
+      exit(1);
+    }
+
+    if (n_processes > 0)
+    {
+      /* The block height can only be measured with the MPI processes running,
+      so hand this size class over to lcs_distributed, which updates the
+      tuning file itself. */
+      // The sequences go through a file, as they may be too long for a
+      // command line.
+      std::string path = input_file;
+      if (path == "")
+        path = write_temporary_input(sequence_a, sequence_b);
+      if (path == "")
+      {
+        std::cerr << "Error writing a temporary input file." << std::endl;
+        exit(1);
+      }
+      printf("\n");
+      fflush(stdout);
+      bool ok = run_program({"mpirun", "-n", std::to_string(n_processes),
+                             program_path(argv[0], "lcs_distributed"),
+                             "--tune_block_height",
+                             "--tune_runs=" + std::to_string(n_runs),
+                             "--tuning_file=" + tuning_file,
+                             "--input_file=" + path});
+      if (path != input_file)
+        unlink(path.c_str());
+      if (!ok)
+      {
+        std::cerr << "Error: distributed tuning failed." << std::endl;
+        exit(1);
+      }
+      tuning_table.load(tuning_file);
+    }
+  }
+
+  printf("\nTuning results saved to %s\n", tuning_file.c_str());
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include <algorithm> // std::min
+#include <cstring>
+#include <stdexcept>
+
+#include "liblcs.h"
+#include "lcs_parallel.h"
+#include "lcs_serial.h"
+
+// ***
+//  Implementation of liblcs, the library form of the serial and parallel LCS
+//  programs. The C interface at the bottom of this file wraps LCSSolver.
+// ***
+
+lcs_options LCSSolver::defaultOptions()
+{
+  lcs_options options;
+  lcs_options_init(&options);
+  return options;
+}
+
+LCSSolver::LCSSolver(const std::string &sequence_a,
+                     const std::string &sequence_b,
+                     const lcs_options &options)
+    : options(options),
+      cells((long long)sequence_a.length() * (long long)sequence_b.length())
+{
+  switch (options.engine)
+  {
+  case LCS_ENGINE_SERIAL:
+    lcs.reset(new LongestCommonSubsequenceSerial(sequence_a, sequence_b));
+    break;
+  case LCS_ENGINE_PARALLEL:
+    lcs.reset(new LongestCommonSubsequenceParallel(
+        sequence_a, sequence_b, options.n_threads, options.tile_width,
+        options.tile_height));
+    break;
+  default:
+    throw std::invalid_argument("unknown LCS engine");
+  }
+  lcs->setCancellationToken(&cancellation);
+}
+
+LCSSolver::~LCSSolver()
+{
+}
+
+void LCSSolver::solve()
+{
+  cancellation.setTimeLimit(options.time_limit);
+  lcs->solve();
+  cancelled = lcs->wasCancelled();
+  solved = !cancelled;
+  // A later solve() may run again, even after a cancel().
+  cancellation.reset();
+}
+
+int LCSSolver::length() const
+{
+  return (int)subsequence().length();
+}
+
+const std::string &LCSSolver::subsequence() const
+{
+  if (!solved)
+  {
+    throw std::logic_error("LCSSolver::solve() has not been called");
+  }
+  return lcs->getLongestCommonSubsequence();
+}
+
+lcs_stats LCSSolver::stats() const
+{
+  lcs_stats stats;
+  stats.length = solved ? length() : -1;
+  stats.cells = solved ? cells : lcs->getCompletedCells();
+  stats.matrix_time = lcs->getMatrixTimeTaken();
+  stats.total_time = lcs->getTimeTaken();
+  return stats;
+}
+
+/* The C handle is simply the C++ solver. */
+struct lcs_solver
+{
+  LCSSolver solver;
+
+  lcs_solver(const std::string &sequence_a, const std::string &sequence_b,
+             const lcs_options &options)
+      : solver(sequence_a, sequence_b, options)
+  {
+  }
+};
+
+extern "C"
+{
+  void lcs_options_init(lcs_options *options)
+  {
+    if (!options)
+      return;
+    options->engine = LCS_ENGINE_SERIAL;
+    options->n_threads = 1;
+    options->tile_width = 0;
+    options->tile_height = 1;
+    options->time_limit = 0.0;
+  }
+
+  lcs_solver *lcs_create(const char *sequence_a, size_t length_a,
+                         const char *sequence_b, size_t length_b,
+                         const lcs_options *options)
+  {
+    if ((!sequence_a && length_a > 0) || (!sequence_b && length_b > 0))
+      return NULL;
+
+    try
+    {
+      return new lcs_solver(std::string(sequence_a, length_a),
+                            std::string(sequence_b, length_b),
+                            options ? *options : LCSSolver::defaultOptions());
+    }
+    catch (...)
+    {
+      return NULL;
+    }
+  }
+
+  int lcs_solve(lcs_solver *solver)
+  {
+    if (!solver)
+      return LCS_ERROR_INVALID_ARGUMENT;
+
+    try
+    {
+      solver->solver.solve();
+    }
+    catch (...)
+    {
+      return LCS_ERROR_INTERNAL;
+    }
+    return solver->solver.isCancelled() ? LCS_ERROR_CANCELLED : LCS_OK;
+  }
+
+  void lcs_cancel(lcs_solver *solver)
+  {
+    if (solver)
+      solver->solver.cancel();
+  }
+
+  int lcs_length(const lcs_solver *solver)
+  {
+    if (!solver || !solver->solver.isSolved())
+      return -1;
+    return solver->solver.length();
+  }
+
+  int lcs_subsequence(const lcs_solver *solver, char *buffer, size_t buffer_size)
+  {
+    if (!solver || !solver->solver.isSolved())
+      return -1;
+
+    const std::string &subsequence = solver->solver.subsequence();
+    if (buffer && buffer_size > 0)
+    {
+      size_t n = std::min(subsequence.length(), buffer_size - 1);
+      memcpy(buffer, subsequence.data(), n);
+      buffer[n] = '\0';
+    }
+    return (int)subsequence.length();
+  }
+
+  int lcs_get_stats(const lcs_solver *solver, lcs_stats *stats)
+  {
+    if (!solver || !stats)
+      return LCS_ERROR_INVALID_ARGUMENT;
+    if (!solver->solver.isSolved() && !solver->solver.isCancelled())
+      return LCS_ERROR_NOT_SOLVED;
+
+    *stats = solver->solver.stats();
+    return LCS_OK;
+  }
+
+  void lcs_destroy(lcs_solver *solver)
+  {
+    delete solver;
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef _LIBLCS_H_
+#define _LIBLCS_H_
+
+#include <memory>
+#include <string>
+
+#include "cancellation.h"
+#include "lcs_c.h" // lcs_engine, lcs_options and lcs_stats are shared with C.
+
+class LongestCommonSubsequence;
+
+/**
+ * @brief C++ interface to liblcs.
+ *
+ * Unlike the command-line programs, nothing here prints to stdout. The solver
+ * is constructed with the input sequences and options, computes the LCS on
+ * solve(), and then answers queries about the result.
+ */
+class LCSSolver
+{
+private:
+  std::unique_ptr<LongestCommonSubsequence> lcs;
+  lcs_options options;
+  CancellationToken cancellation;
+  bool solved = false;
+  bool cancelled = false;
+  long long cells;
+
+public:
+  /* Returns the default options (serial engine). */
+  static lcs_options defaultOptions();
+
+  LCSSolver(const std::string &sequence_a, const std::string &sequence_b,
+            const lcs_options &options = defaultOptions());
+  ~LCSSolver();
+
+  LCSSolver(const LCSSolver &) = delete;
+  LCSSolver &operator=(const LCSSolver &) = delete;
+
+  /* Computes the longest common subsequence, unless the solve is cancelled
+  by options.time_limit or cancel() first. */
+  void solve();
+
+  /* Stops a running solve() at its next row or block of rows. Safe to call
+  from another thread. */
+  void cancel()
+  {
+    cancellation.cancel();
+  }
+
+  bool isSolved() const
+  {
+    return solved;
+  }
+
+  /* True if the last solve() was cancelled. Only its stats are available. */
+  bool isCancelled() const
+  {
+    return cancelled;
+  }
+
+  /* Length of the longest common subsequence. Requires solve(). */
+  int length() const;
+
+  /* The longest common subsequence. Requires solve(). */
+  const std::string &subsequence() const;
+
+  /* Statistics of the last call to solve(). */
+  lcs_stats stats() const;
+
+  const lcs_options &getOptions() const
+  {
+    return options;
+  }
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef _MATRIX_DUMP_H_
+#define _MATRIX_DUMP_H_
+
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Binary dump of a solution matrix, for inspecting large runs after the fact
+ * with lcs_matrix_view instead of printing them.
+ *
+ * Layout, all in host byte order:
+ *   LCSMatrixDumpHeader
+ *   sequence_a (length_a bytes), sequence_b (length_b bytes)
+ *   zero padding up to matrix_offset
+ *   (length_a + 1) x (length_b + 1) int32 cells, row by row, including the
+ *   row and column of 0s.
+ *
+ * Because every cell is at a fixed offset, writers can fill in their part of
+ * the matrix independently, e.g. one MPI rank per strip of columns.
+ */
+
+#define LCS_MATRIX_DUMP_MAGIC 0x4d53434c // "LCSM" in little-endian memory.
+#define LCS_MATRIX_DUMP_VERSION 1
+
+struct LCSMatrixDumpHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t length_a;
+  uint32_t length_b;
+  uint64_t matrix_offset; // Offset of the first cell, a multiple of 64.
+
+  uint64_t n_rows() const { return (uint64_t)length_a + 1; }
+  uint64_t n_cols() const { return (uint64_t)length_b + 1; }
+  uint64_t fileSize() const { return matrix_offset + n_rows() * n_cols() * sizeof(int); }
+};
+
+inline LCSMatrixDumpHeader makeMatrixDumpHeader(const int length_a, const int length_b)
+{
+  LCSMatrixDumpHeader header;
+  header.magic = LCS_MATRIX_DUMP_MAGIC;
+  header.version = LCS_MATRIX_DUMP_VERSION;
+  header.length_a = length_a;
+  header.length_b = length_b;
+  uint64_t end = sizeof(header) + (uint64_t)length_a + length_b;
+  header.matrix_offset = (end + 63) & ~(uint64_t)63;
+  return header;
+}
+
+/* Writes n bytes at the given offset, retrying partial writes. */
+inline bool pwriteAll(const int fd, const void *data, size_t n, off_t offset)
+{
+  const char *bytes = (const char *)data;
+  while (n > 0)
+  {
+    ssize_t n_written = pwrite(fd, bytes, n, offset);
+    if (n_written <= 0)
+      return false;
+    bytes += n_written;
+    n -= n_written;
+    offset += n_written;
+  }
+  return true;
+}
+
+/* Writes the header and both sequences at the start of a dump file. */
+inline bool writeMatrixDumpPreamble(const int fd, const LCSMatrixDumpHeader &header,
+                                    const char *sequence_a, const char *sequence_b)
+{
+  return pwriteAll(fd, &header, sizeof(header), 0) &&
+         pwriteAll(fd, sequence_a, header.length_a, sizeof(header)) &&
+         pwriteAll(fd, sequence_b, header.length_b,
+                   sizeof(header) + header.length_a);
+}
+
+/* Writes a whole matrix whose cells are stored contiguously, row by row. If
+transposed, the cells have a row per character of sequence_b instead, and are
+written a column at a time so that the dump is still in the usual layout. */
+inline bool writeMatrixDump(const std::string &path,
+                            const char *sequence_a, const int length_a,
+                            const char *sequence_b, const int length_b,
+                            const int *cells, const bool transposed = false)
+{
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+
+  LCSMatrixDumpHeader header = makeMatrixDumpHeader(length_a, length_b);
+  bool ok = writeMatrixDumpPreamble(fd, header, sequence_a, sequence_b);
+  if (!transposed)
+  {
+    ok = ok && pwriteAll(fd, cells, header.n_rows() * header.n_cols() * sizeof(int),
+                         header.matrix_offset);
+  }
+  else
+  {
+    std::vector<int> row(header.n_cols());
+    for (uint64_t i = 0; i < header.n_rows() && ok; i++)
+    {
+      for (uint64_t j = 0; j < header.n_cols(); j++)
+      {
+        row[j] = cells[j * header.n_rows() + i];
+      }
+      ok = pwriteAll(fd, row.data(), row.size() * sizeof(int),
+                     header.matrix_offset + i * header.n_cols() * sizeof(int));
+    }
+  }
+  return close(fd) == 0 && ok;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef _PROGRESS_H_
+#define _PROGRESS_H_
+
+#include <stdio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "timer.h"
+
+/* Prints one progress line: the fraction of cells done, the throughput since
+the start of the report and the estimated time until all cells are done. */
+inline void printProgress(FILE *out_file, const long long done_cells,
+                          const long long total_cells, const long long start_cells,
+                          const double elapsed)
+{
+  double rate = elapsed > 0.0 ? (done_cells - start_cells) / elapsed : 0.0;
+  double percent = total_cells > 0 ? 100.0 * done_cells / total_cells : 100.0;
+  fprintf(out_file, "Progress: %5.1f%% | %.3e cells/s | ETA ", percent, rate);
+  if (rate > 0.0)
+  {
+    long long eta = (long long)((total_cells - done_cells) / rate + 0.5);
+    fprintf(out_file, "%lld:%02lld:%02lld\n", eta / 3600, eta / 60 % 60, eta % 60);
+  }
+  else
+  {
+    fprintf(out_file, "unknown\n");
+  }
+  fflush(out_file);
+}
+
+/**
+ * @brief Background thread that periodically prints the progress of a solve.
+ *
+ * The reporter only reads the counters that the solver updates anyway, through
+ * the given function, so the solver's loops do not synchronize with it. It
+ * prints to stderr, so it never mixes with the results on stdout. Reporting
+ * starts when the reporter is created and stops when stop() is called or the
+ * reporter is destroyed. An interval of 0 disables it.
+ */
+class ProgressReporter
+{
+private:
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopped = false;
+
+public:
+  ProgressReporter(const double interval, const long long total_cells,
+                   const std::function<long long()> &done_cells)
+  {
+    if (interval <= 0.0)
+      return;
+
+    thread = std::thread([this, interval, total_cells, done_cells]()
+                         {
+      Timer timer;
+      timer.start();
+      long long start_cells = done_cells();
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!cv.wait_for(lock, std::chrono::duration<double>(interval),
+                          [this] { return stopped; }))
+      {
+        printProgress(stderr, done_cells(), total_cells, start_cells, timer.stop());
+      } });
+  }
+
+  ProgressReporter(const ProgressReporter &) = delete;
+  ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+  void stop()
+  {
+    if (!thread.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+    }
+    cv.notify_all();
+    thread.join();
+  }
+
+  ~ProgressReporter()
+  {
+    stop();
+  }
+};
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef _SCORING_H_
+#define _SCORING_H_
+
+#include <algorithm> // std::max
+#include <cstdlib>
+#include <string>
+
+/**
+ * @brief Recurrence policies: how a cell of the matrix is scored.
+ *
+ * A policy gives the values of the top row and left column, the value of a
+ * cell from the characters it compares and its three neighbors, and the move
+ * the traceback takes out of a cell. The engines take the policy as a template
+ * parameter, so every policy compiles to its own row kernel with the policy
+ * inlined, and nothing is decided per cell at run time.
+ *
+ *   LCSScoring            the longest common subsequence.
+ *   WeightedLCSScoring    the common subsequence with the largest total weight
+ *                         of its characters.
+ *   GlobalAlignmentScoring  Needleman-Wunsch: match and mismatch scores and a
+ *                         linear gap penalty, over the whole of both sequences.
+ *   LocalAlignmentScoring   Smith-Waterman: the same scores, over the best
+ *                         scoring pair of substrings.
+ *
+ * A local policy never lets a cell drop below 0; its result is the largest
+ * cell of the matrix, and its traceback starts there and stops at a 0.
+ */
+
+/* The move of the traceback out of a cell. */
+enum TracebackMove
+{
+  TRACEBACK_DIAGONAL, // To the top-left, without a match.
+  TRACEBACK_MATCH,    // To the top-left, matching the cell's characters.
+  TRACEBACK_UP,
+  TRACEBACK_LEFT,
+  TRACEBACK_STOP // Where a local alignment starts.
+};
+
+/* Unit matches, no gap penalty. The moves are those the LCS traceback has
+always taken, so the alignment is unchanged. */
+struct LCSScoring
+{
+  static const bool local = false;
+
+  int boundary(const int) const
+  {
+    return 0;
+  }
+
+  int cell(const char a, const char b, const int diagonal, const int top,
+           const int left) const
+  {
+    return a == b ? diagonal + 1 : std::max(top, left);
+  }
+
+  TracebackMove move(const char, const char, const int current, const int diagonal,
+                     const int top, const int left) const
+  {
+    if (diagonal == current)
+      return TRACEBACK_DIAGONAL;
+    if (diagonal == top && diagonal == left)
+      return TRACEBACK_MATCH;
+    return top == current ? TRACEBACK_UP : TRACEBACK_LEFT;
+  }
+};
+
+/* Every character has a weight, 1 unless given, and a match scores the weight
+of its character. With every weight 1, this is the LCS. */
+struct WeightedLCSScoring
+{
+  static const bool local = false;
+  int weights[256];
+
+  WeightedLCSScoring()
+  {
+    std::fill(weights, weights + 256, 1);
+  }
+
+  int boundary(const int) const
+  {
+    return 0;
+  }
+
+  int cell(const char a, const char b, const int diagonal, const int top,
+           const int left) const
+  {
+    int best = std::max(top, left);
+    return a == b ? std::max(best, diagonal + weights[(unsigned char)a]) : best;
+  }
+
+  TracebackMove move(const char a, const char b, const int current, const int diagonal,
+                     const int top, const int) const
+  {
+    if (a == b && current == diagonal + weights[(unsigned char)a])
+      return TRACEBACK_MATCH;
+    return top == current ? TRACEBACK_UP : TRACEBACK_LEFT;
+  }
+
+  /* Parses weights given as "A:2,C:3". Returns false if they are malformed. */
+  bool parse(const std::string &text)
+  {
+    size_t start = 0;
+    while (start < text.length())
+    {
+      size_t end = text.find(',', start);
+      if (end == std::string::npos)
+        end = text.length();
+      if (end - start < 3 || text[start + 1] != ':')
+        return false;
+      const char *number = text.c_str() + start + 2;
+      char *number_end;
+      long weight = strtol(number, &number_end, 10);
+      if (number_end != text.c_str() + end)
+        return false;
+      weights[(unsigned char)text[start]] = (int)weight;
+      start = end + 1;
+    }
+    return true;
+  }
+};
+
+/* Needleman-Wunsch scoring: a column of the alignment scores match or
+mismatch, and every character aligned with a gap costs gap. */
+struct GlobalAlignmentScoring
+{
+  static const bool local = false;
+  int match;
+  int mismatch;
+  int gap;
+
+  GlobalAlignmentScoring(const int match, const int mismatch, const int gap)
+      : match(match), mismatch(mismatch), gap(gap)
+  {
+  }
+
+  // Leading gaps are paid for.
+  int boundary(const int index) const
+  {
+    return -gap * index;
+  }
+
+  int cell(const char a, const char b, const int diagonal, const int top,
+           const int left) const
+  {
+    return std::max(diagonal + (a == b ? match : mismatch), std::max(top, left) - gap);
+  }
+
+  TracebackMove move(const char a, const char b, const int current, const int diagonal,
+                     const int top, const int) const
+  {
+    if (current == diagonal + (a == b ? match : mismatch))
+      return a == b ? TRACEBACK_MATCH : TRACEBACK_DIAGONAL;
+    return current == top - gap ? TRACEBACK_UP : TRACEBACK_LEFT;
+  }
+};
+
+/* Smith-Waterman scoring: the scores of GlobalAlignmentScoring, but an
+alignment may start and end anywhere, so no cell is below 0. */
+struct LocalAlignmentScoring : GlobalAlignmentScoring
+{
+  static const bool local = true;
+
+  LocalAlignmentScoring(const int match, const int mismatch, const int gap)
+      : GlobalAlignmentScoring(match, mismatch, gap)
+  {
+  }
+
+  int boundary(const int) const
+  {
+    return 0;
+  }
+
+  int cell(const char a, const char b, const int diagonal, const int top,
+           const int left) const
+  {
+    return std::max(0, GlobalAlignmentScoring::cell(a, b, diagonal, top, left));
+  }
+
+  TracebackMove move(const char a, const char b, const int current, const int diagonal,
+                     const int top, const int left) const
+  {
+    if (current == 0)
+      return TRACEBACK_STOP;
+    return GlobalAlignmentScoring::move(a, b, current, diagonal, top, left);
+  }
+};
+
+/* Computes cells first_col to last_col of a row whose character of sequence_a
+is a, from the row above it. Both rows are indexed by column, with column 0
+the left boundary, and b is sequence_b. */
+template <class Scoring>
+inline void computeScoredRow(const Scoring &scoring, const char a, const char *b,
+                             const int *above, int *row, const int first_col,
+                             const int last_col)
+{
+  for (int col = first_col; col <= last_col; col++)
+  {
+    row[col] = scoring.cell(a, b[col - 1], above[col - 1], above[col], row[col - 1]);
+  }
+}
+
+/* Takes one step of the traceback back from cell (i, j) of the matrix, and
+returns the move. TRACEBACK_STOP leaves (i, j) where it is. */
+template <class Scoring>
+inline TracebackMove scoredTracebackStep(const Scoring &scoring, int *const *matrix,
+                                const char *a, const char *b, int &i, int &j)
+{
+  TracebackMove move = scoring.move(a[i - 1], b[j - 1], matrix[i][j],
+                                    matrix[i - 1][j - 1], matrix[i - 1][j],
+                                    matrix[i][j - 1]);
+  switch (move)
+  {
+  case TRACEBACK_DIAGONAL:
+  case TRACEBACK_MATCH:
+    i--;
+    j--;
+    break;
+  case TRACEBACK_UP:
+    i--;
+    break;
+  case TRACEBACK_LEFT:
+    j--;
+    break;
+  case TRACEBACK_STOP:
+    break;
+  }
+  return move;
+}
+
+/* The recurrence a program solves, chosen with --scoring. */
+enum LCSScoringScheme
+{
+  LCS_SCORING_LCS,
+  LCS_SCORING_WEIGHTED,
+  LCS_SCORING_GLOBAL,
+  LCS_SCORING_LOCAL
+};
+
+/* Parses the value of --scoring. Returns false if it is unknown. */
+inline bool parseScoringScheme(const std::string &name, LCSScoringScheme &scheme)
+{
+  if (name == "lcs")
+    scheme = LCS_SCORING_LCS;
+  else if (name == "weighted")
+    scheme = LCS_SCORING_WEIGHTED;
+  else if (name == "global")
+    scheme = LCS_SCORING_GLOBAL;
+  else if (name == "local")
+    scheme = LCS_SCORING_LOCAL;
+  else
+    return false;
+  return true;
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef _SEAWEED_H_
+#define _SEAWEED_H_
+
+#include <vector>
+
+#include "cancellation.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Seaweed braids: the LCS of a band of rows as a permutation.
+ *
+ * Every cell of the matrix of a against b is crossed by two seaweeds, one
+ * travelling right and one travelling down. A seaweed enters at the left end
+ * of every row and at the top of every column, and leaves at the bottom of a
+ * column or the right end of a row. Two seaweeds turn away from each other in
+ * a cell where the characters match, and cross where they do not, unless
+ * they have crossed before. The bottom row of the LCS matrix increases at
+ * column j exactly where the seaweed that leaves through column j entered on
+ * the left. See Tiskin, "Semi-local string comparison: algorithmic techniques
+ * and applications".
+ *
+ * The seaweeds are numbered along a line from the bottom-left corner to the
+ * top-right corner. A braid maps where each seaweed enters to where it leaves:
+ *
+ *   enters: left end of row i -> m - 1 - i, top of column j -> m + j
+ *   leaves: bottom of column j -> j,        right end of row i -> n + m - 1 - i
+ *
+ * for a band of m rows and n columns. The line below a band of rows is the
+ * line above the next band, so the braid of two bands is the (associative)
+ * product of their braids.
+ */
+
+/* Combs the seaweeds of a band of rows against b: braid[s] is where the
+seaweed entering at s leaves, for the m + n seaweeds. Returns false if the
+token is cancelled before it finishes. */
+inline bool combBraid(const char *a, const int m, const char *b, const int n,
+                      int *braid, CancellationToken *cancellation_token = nullptr)
+{
+  std::vector<int> vertical(n);
+  for (int j = 0; j < n; j++)
+  {
+    vertical[j] = m + j;
+  }
+  for (int i = 0; i < m; i++)
+  {
+    if (i % 64 == 0 && cancellation_token && cancellation_token->isCancelled())
+      return false;
+    const char c = a[i];
+    int horizontal = m - 1 - i;
+    for (int j = 0; j < n; j++)
+    {
+      // Seaweeds are numbered in the order they enter, so a seaweed with a
+      // larger number on the left has already crossed the one from above.
+      int top = vertical[j];
+      bool turn = c == b[j] || horizontal > top;
+      vertical[j] = turn ? horizontal : top;
+      horizontal = turn ? top : horizontal;
+    }
+    braid[horizontal] = n + m - 1 - i;
+  }
+  for (int j = 0; j < n; j++)
+  {
+    braid[vertical[j]] = j;
+  }
+  return true;
+}
+
+/* Computes the braid of the seaweeds of p followed by those of q, for two
+braids of the same size, with Tiskin's steady ant algorithm in O(n log n)
+time. In terms of matrices, it is the (min, +) product of the matrices that
+count, for each (i, j), the seaweeds entering at i or later and leaving before
+j. If a pool is given, the two halves of large products run on it. */
+inline std::vector<int> stickyBraidProduct(const std::vector<int> &p,
+                                           const std::vector<int> &q,
+                                           ThreadPool *pool = nullptr)
+{
+  // Halves smaller than this are not worth a second task.
+  const int FORK_SIZE = 1 << 14;
+
+  const int n = p.size();
+  if (n <= 1)
+    return std::vector<int>(n, 0);
+
+  // Split the middle of the product, where p's seaweeds leave and q's enter,
+  // in two halves, and multiply the seaweeds that pass through each half.
+  const int half = n / 2;
+  std::vector<int> lo_rows, hi_rows, lo_p, hi_p;
+  for (int r = 0; r < n; r++)
+  {
+    if (p[r] < half)
+    {
+      lo_rows.push_back(r);
+      lo_p.push_back(p[r]);
+    }
+    else
+    {
+      hi_rows.push_back(r);
+      hi_p.push_back(p[r] - half);
+    }
+  }
+  // The columns of q that each half reaches, in order, and their ranks.
+  std::vector<int> column_rank(n);
+  std::vector<char> column_lo(n, 0);
+  for (int j = 0; j < half; j++)
+  {
+    column_lo[q[j]] = 1;
+  }
+  int n_lo = 0, n_hi = 0;
+  std::vector<int> lo_columns(half), hi_columns(n - half);
+  for (int c = 0; c < n; c++)
+  {
+    if (column_lo[c])
+    {
+      column_rank[c] = n_lo;
+      lo_columns[n_lo++] = c;
+    }
+    else
+    {
+      column_rank[c] = n_hi;
+      hi_columns[n_hi++] = c;
+    }
+  }
+  std::vector<int> lo_q(half), hi_q(n - half);
+  for (int j = 0; j < half; j++)
+  {
+    lo_q[j] = column_rank[q[j]];
+  }
+  for (int j = half; j < n; j++)
+  {
+    hi_q[j - half] = column_rank[q[j]];
+  }
+  std::vector<int> lo_product, hi_product;
+  if (pool && n >= 2 * FORK_SIZE)
+  {
+    pool->run(2, [&](int task)
+              {
+      if (task == 0)
+        lo_product = stickyBraidProduct(lo_p, lo_q, pool);
+      else
+        hi_product = stickyBraidProduct(hi_p, hi_q, pool); });
+  }
+  else
+  {
+    lo_product = stickyBraidProduct(lo_p, lo_q);
+    hi_product = stickyBraidProduct(hi_p, hi_q);
+  }
+
+  // Both halves' products, in the full size: row -> column, or -1.
+  std::vector<int> lo(n, -1), hi(n, -1), lo_row(n, -1), hi_row(n, -1);
+  for (int k = 0; k < (int)lo_rows.size(); k++)
+  {
+    lo[lo_rows[k]] = lo_columns[lo_product[k]];
+    lo_row[lo[lo_rows[k]]] = lo_rows[k];
+  }
+  for (int k = 0; k < (int)hi_rows.size(); k++)
+  {
+    hi[hi_rows[k]] = hi_columns[hi_product[k]];
+    hi_row[hi[hi_rows[k]]] = hi_rows[k];
+  }
+
+  // The product keeps the low half's nonzeros above and left of a monotone
+  // boundary and the high half's below and right of it, where the boundary
+  // is the sign change of
+  //   delta(i, k) = #hi above row i and left of column k
+  //               - #lo from row i down and from column k right,
+  // which grows with both i and k. The ant walks the boundary from the
+  // bottom-left corner to the top-right one: boundary[k] is the first row i
+  // with delta(i, k) >= 0.
+  std::vector<int> boundary(n + 1);
+  int i = n, hi_above_left = 0, lo_below_right = 0;
+  for (int k = 0;; k++)
+  {
+    while (i > 0)
+    {
+      int hi_step = hi[i - 1] >= 0 && hi[i - 1] < k;
+      int lo_step = lo[i - 1] >= 0 && lo[i - 1] >= k;
+      if (hi_above_left - hi_step < lo_below_right + lo_step)
+        break;
+      i--;
+      hi_above_left -= hi_step;
+      lo_below_right += lo_step;
+    }
+    boundary[k] = i;
+    if (k == n)
+      break;
+    hi_above_left += hi_row[k] >= 0 && hi_row[k] < i;
+    lo_below_right -= lo_row[k] >= 0 && lo_row[k] >= i;
+  }
+
+  std::vector<int> product(n, -1);
+  std::vector<char> column_used(n, 0);
+  for (int r = 0; r < n; r++)
+  {
+    if (lo[r] >= 0 && r + 1 < boundary[lo[r] + 1])
+      product[r] = lo[r];
+    else if (hi[r] >= 0 && r >= boundary[hi[r]])
+      product[r] = hi[r];
+    if (product[r] >= 0)
+      column_used[product[r]] = 1;
+  }
+  // The remaining nonzeros lie on the boundary, so they go up and to the
+  // right: the lowest free row takes the leftmost free column.
+  int c = 0;
+  for (int r = n - 1; r >= 0; r--)
+  {
+    if (product[r] >= 0)
+      continue;
+    while (column_used[c])
+      c++;
+    product[r] = c++;
+  }
+  return product;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _SEQUENCE_H_
+#define _SEQUENCE_H_
+
+#include <ostream>
+#include <string>
+
+/** Read-only view of a sequence of characters owned by someone else: inside
+a LongestCommonSubsequence object, its copies of the inputs (in a string or
+in an arena), and as an input, a string or a slice of a memory-mapped file. */
+struct Sequence
+{
+  const char *data = nullptr;
+  int size = 0;
+
+  Sequence() {}
+  Sequence(const char *data, const int size) : data(data), size(size) {}
+  Sequence(const std::string &sequence)
+      : data(sequence.data()), size(sequence.length())
+  {
+  }
+
+  char operator[](const int i) const
+  {
+    return data[i];
+  }
+
+  int length() const
+  {
+    return size;
+  }
+
+  std::string str() const
+  {
+    return std::string(data, size);
+  }
+};
+
+inline std::ostream &operator<<(std::ostream &out, const Sequence &sequence)
+{
+  return out.write(sequence.data, sequence.size);
+}
+
+#endif
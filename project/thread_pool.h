@@ -0,0 +1,149 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads that stay alive between solves.
+ *
+ * `run(n_tasks, task)` calls task(0) ... task(n_tasks - 1) on the workers and
+ * returns once all of them have finished. The calling thread executes tasks
+ * as well, so a run always makes progress even when every worker is busy.
+ *
+ * Task indices are handed out in increasing order and a task that has been
+ * handed out is always being executed. Tasks may therefore wait for tasks
+ * with a smaller index, which is what the wavefront solvers do: strip k only
+ * ever waits for strip k - 1.
+ */
+class ThreadPool
+{
+private:
+  /* A single call to run(). */
+  struct Gang
+  {
+    std::function<void(int)> task;
+    int n_tasks;
+    std::atomic<int> next_task;
+    std::atomic<int> n_finished;
+
+    Gang(const std::function<void(int)> &task, int n_tasks)
+        : task(task), n_tasks(n_tasks), next_task(0), n_finished(0)
+    {
+    }
+  };
+
+  std::vector<std::thread> workers;
+  std::deque<std::shared_ptr<Gang>> gangs; // Runs that still have tasks to hand out.
+  std::mutex mutex;
+  std::condition_variable work_cv; // Signalled when a run is added.
+  std::condition_variable done_cv; // Signalled when a run finishes.
+  bool stopping = false;
+
+  /* Claims and executes tasks of the gang until none are left. */
+  void execute(Gang &gang)
+  {
+    int task_id;
+    while ((task_id = gang.next_task.fetch_add(1)) < gang.n_tasks)
+    {
+      gang.task(task_id);
+      if (gang.n_finished.fetch_add(1) + 1 == gang.n_tasks)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        done_cv.notify_all();
+      }
+    }
+  }
+
+  void workerLoop()
+  {
+    while (true)
+    {
+      std::shared_ptr<Gang> gang;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        work_cv.wait(lock, [this]
+                     { return stopping || !gangs.empty(); });
+        if (stopping)
+          return;
+
+        gang = gangs.front();
+        // Every task is about to be handed out, so later workers can move on.
+        if (gang->next_task.load() + 1 >= gang->n_tasks)
+          gangs.pop_front();
+      }
+      execute(*gang);
+    }
+  }
+
+public:
+  ThreadPool(int n_workers)
+  {
+    for (int i = 0; i < n_workers; i++)
+    {
+      workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    work_cv.notify_all();
+    for (std::thread &worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /* Number of worker threads, not counting callers of run(). */
+  int size() const
+  {
+    return workers.size();
+  }
+
+  /* Runs task(0) ... task(n_tasks - 1) and waits for all of them. */
+  void run(int n_tasks, const std::function<void(int)> &task)
+  {
+    if (n_tasks <= 0)
+      return;
+
+    auto gang = std::make_shared<Gang>(task, n_tasks);
+    if (n_tasks > 1 && !workers.empty())
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        gangs.push_back(gang);
+      }
+      work_cv.notify_all();
+    }
+
+    execute(*gang);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // Stop handing out this run in case no worker got to it.
+    for (auto it = gangs.begin(); it != gangs.end(); ++it)
+    {
+      if (*it == gang)
+      {
+        gangs.erase(it);
+        break;
+      }
+    }
+    done_cv.wait(lock, [&gang]
+                 { return gang->n_finished.load() == gang->n_tasks; });
+  }
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef _TUNING_H_
+#define _TUNING_H_
+
+#include <algorithm> // std::max, std::replace
+#include <fstream>
+#include <iostream>
+#include <iterator> // std::prev
+#include <map>
+#include <sstream>
+#include <string>
+
+/* Default location of the tuning file written by lcs_tune and read by the
+LCS programs at startup. */
+#define DEFAULT_TUNING_FILE "lcs_tuning.csv"
+
+/**
+ * @brief Tunable parameters of the parallel and distributed solvers.
+ *
+ * A tile_width of 0 means a thread processes its whole strip of columns
+ * before moving on to the next block of rows. A strip_width of 0 gives each
+ * thread one strip; otherwise the threads take strips of that many columns in
+ * turn.
+ */
+struct TuningConfig
+{
+  int n_threads = 1;    // Number of threads used by lcs_parallel.
+  int tile_width = 0;   // Columns per tile in lcs_parallel (0 = whole strip).
+  int tile_height = 1;  // Rows computed between synchronizations in lcs_parallel.
+  int block_height = 1; // Rows sent per boundary message in lcs_distributed.
+  int strip_width = 0;  // Columns per strip in lcs_parallel (0 = one per thread).
+};
+
+/* Inputs are grouped into size classes by the number of digits of the longer
+sequence, so L=1000 and L=10000 workloads get separate configurations. */
+inline int sizeClass(const int length_a, const int length_b)
+{
+  int n = std::max(length_a, length_b);
+  int size_class = 0;
+  while (n >= 10)
+  {
+    n /= 10;
+    size_class++;
+  }
+  return size_class;
+}
+
+/**
+ * @brief Table of the best known configuration for each size class.
+ *
+ * The table is stored as a .csv file with one row per size class:
+ *
+ *   size_class,n_threads,tile_width,tile_height,block_height,strip_width
+ *
+ * Files written before strip_width was tuned lack the last column, which then
+ * defaults to 0.
+ */
+class TuningTable
+{
+private:
+  std::map<int, TuningConfig> configs;
+
+public:
+  /* Loads the table from the given file. Returns false if the file could not
+  be opened, in which case the table is left empty. */
+  bool load(const std::string &path)
+  {
+    std::ifstream in_file(path);
+    if (!in_file.is_open())
+    {
+      return false;
+    }
+
+    std::string line;
+    while (std::getline(in_file, line))
+    {
+      if (line.empty() || line[0] < '0' || line[0] > '9')
+      {
+        continue; // Skip the header and blank lines.
+      }
+      std::replace(line.begin(), line.end(), ',', ' ');
+      std::istringstream fields(line);
+      int size_class;
+      TuningConfig config;
+      if (fields >> size_class >> config.n_threads >> config.tile_width >> config.tile_height >> config.block_height)
+      {
+        if (!(fields >> config.strip_width))
+          config.strip_width = 0;
+        configs[size_class] = config;
+      }
+    }
+    return true;
+  }
+
+  /* Writes the table to the given file, replacing its contents. */
+  bool save(const std::string &path) const
+  {
+    std::ofstream out_file(path);
+    if (!out_file.is_open())
+    {
+      std::cerr << "Error writing file: " << path << std::endl;
+      return false;
+    }
+    out_file << "size_class,n_threads,tile_width,tile_height,block_height,strip_width\n";
+    for (const auto &entry : configs)
+    {
+      const TuningConfig &config = entry.second;
+      out_file << entry.first << "," << config.n_threads << ","
+               << config.tile_width << "," << config.tile_height << ","
+               << config.block_height << "," << config.strip_width << "\n";
+    }
+    return true;
+  }
+
+  bool contains(const int size_class) const
+  {
+    return configs.count(size_class) > 0;
+  }
+
+  TuningConfig &operator[](const int size_class)
+  {
+    return configs[size_class];
+  }
+
+  /* Returns the configuration for the size class of the given input, falling
+  back to the closest smaller size class, and then to the defaults. */
+  TuningConfig lookup(const int length_a, const int length_b) const
+  {
+    TuningConfig config;
+    auto it = configs.upper_bound(sizeClass(length_a, length_b));
+    if (it != configs.begin())
+    {
+      config = std::prev(it)->second;
+    }
+    return config;
+  }
+};
+
+#endif